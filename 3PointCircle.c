@@ -1,683 +1,1749 @@
-/*
-======================================================================
-3PointCircle.c
-
-A tool to generate a circle from any three arbitrary points.
-Contains some code modified from the LW SDK.
-
-Next version should be interactive. 
-
-Kevin MacPhail	08/19/03
-====================================================================== */
-
-#include <lwserver.h>
-#include <lwcmdseq.h>
-#include <lwmodeler.h>
-#include <lwxpanel.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <math.h>
-#include <lwmodlib.h>
-#include <lwcomlib.h>
-#include <com_math.h>
-#include <com_vecmatquat.h>
-#include "pppcir.h"
-
-/* some matrix shorthand */
-#define m00  m[ 0 ][ 0 ]
-#define m01  m[ 0 ][ 1 ]
-#define m02  m[ 0 ][ 2 ]
-#define m03  m[ 0 ][ 3 ]
-#define m10  m[ 1 ][ 0 ]
-#define m11  m[ 1 ][ 1 ]
-#define m12  m[ 1 ][ 2 ]
-#define m13  m[ 1 ][ 3 ]
-#define m20  m[ 2 ][ 0 ]
-#define m21  m[ 2 ][ 1 ]
-#define m22  m[ 2 ][ 2 ]
-#define m23  m[ 2 ][ 3 ]
-#define m30  m[ 3 ][ 0 ]
-#define m31  m[ 3 ][ 1 ]
-#define m32  m[ 3 ][ 2 ]
-#define m33  m[ 3 ][ 3 ]
-
-#define a0 point[ 0 ][ 0 ]
-#define a1 point[ 0 ][ 1 ]
-#define b0 point[ 1 ][ 0 ]
-#define b1 point[ 1 ][ 1 ]
-#define c0 point[ 2 ][ 0 ]
-#define c1 point[ 2 ][ 1 ]
-
-typedef struct st_PointStack{
-   MeshEditOp *edit;
-   int pointCount;
-   double **pointArray;
-} PointStack;
-
-static EDError KMPointEnum( PointStack *pointcircle, const EDPointInfo *pointInfo );
-static EDError KMPolyEnum( PointStack *pointcircle, const EDPolygonInfo *polyInfo );
-void KM_D4Transform( LWDMatrix4 m, double d1, double d2, double d3 );
-int KM_D4Rotate( LWDMatrix4 m, char axis, double theta );
-void LWMAT_transpose4( LWDMatrix4 n, LWDMatrix4 m );
-
-/*
-======================================================================
-LWXPanelFuncs
-
-Create the interface panel.
-====================================================================== */
-int get_user( LWXPanelFuncs *xpanf, int *sides)
-{
-   LWXPanelID panel;
-   int ok = 0;
-
-   enum { ID_SIDES = 0x8001, };
-
-   LWXPanelControl ctl[] = {
-	  { ID_SIDES, "Number of Sides", "integer" },
-      { 0 }
-   };
-   LWXPanelDataDesc cdata[] = {
-	  { ID_SIDES, "Number of Sides", "integer" },
-      { 0 }
-   };
-   LWXPanelHint hint[] = {
-	   XpLABEL( 0, "3PointCircle v1.1.0" ),
-	   XpEND
-   };
-
-   panel = xpanf->create( LWXP_FORM, ctl );
-   if ( !panel ) return 0;
-
-   xpanf->describe( panel, cdata, NULL, NULL );
-   xpanf->hint( panel, 0, hint );
-   xpanf->formSet( panel, ID_SIDES, sides );
-
-   ok = xpanf->post( panel );
-
-   if ( ok ) {
-       int *i;
-	   
-	   i = xpanf->formGet( panel, ID_SIDES );
-	   *sides = *i;
-   }
-
-   xpanf->destroy( panel );
-   return ok;
-}
-
-/*
-======================================================================
-Activate()
-
-The plug-in activation function.
-====================================================================== */
-XCALL_( int )
-Activate( long version, GlobalFunc *global, LWModCommand *local,
-   void *serverData )
-{
-	char cmd[ 128 ];
-	LWStateQueryFuncs *query;
-	LWMessageFuncs *msg;
-	LWXPanelFuncs *xpanf;
-	ModData *md;
-	int ok = 0;
-	int nmode;   
-	int sides = 32;
-	int pointEnum = 0;
-	int polyEnum = 0;
-	int i, j;
-	double dangle = 0.0;
-	double radius[3] = {0.0, 0.0, 0.0};
-	double center[3] = {0.0, 0.0, 0.0};
-	PointStack pinfo;
-	PointStack npinfo;
-	PointStack pointcircle;
-	LWDVector temp;
-	LWDVector unitX = { 1.0, 0.0, 0.0 };
-	LWDVector unitY = { 0.0, 1.0, 0.0 };
-	LWDVector unitZ = { 0.0, 0.0, 1.0 };
-	LWDMatrix4 pointTranslate;
-	LWDMatrix4 pointTranslateT;
-	LWDMatrix4 pointRotateX;
-	LWDMatrix4 pointRotateY;
-	LWDMatrix4 pointRotateZ;
-	LWDMatrix4 pointWork1;
-	LWDMatrix4 pointWork2;
-	LWDMatrix4 pointXYZT;
-	LWPntID *cpntid;
-	v2_pos v2_points[3];
-	v2_pos v2_center;
-	int lastLayer = 0;
-	const char *layers;
-	char *fgLayers, *bgLayers, *allLayers;
-	char setLayer[20];
-	char *token, *temptoken;
-	char seps[] = " ";
-
-
-	//////////////////////////////////
-	// Initialize vectors and matrices
-	//////////////////////////////////
-	pinfo.pointCount = 0;
-	npinfo.pointCount = 0;
-	pointcircle.pointCount = 0;
-	LWMAT_didentity4( pointTranslate );
-	LWMAT_didentity4( pointRotateX );
-	LWMAT_didentity4( pointRotateY );
-	LWMAT_didentity4( pointRotateZ );
-			
-	/////////////////////
-	// Initialize Globals
-	/////////////////////
-	if ( version != LWMODCOMMAND_VERSION ) return AFUNC_BADVERSION;
-
-	query = global( LWSTATEQUERYFUNCS_GLOBAL, GFUSE_TRANSIENT );
-	if ( !query ) return AFUNC_BADGLOBAL;
-
-	xpanf = global( LWXPANELFUNCS_GLOBAL, GFUSE_TRANSIENT );
-	if ( !xpanf ) return AFUNC_BADGLOBAL;
-
-	msg = global (LWMESSAGEFUNCS_GLOBAL, GFUSE_TRANSIENT);
-	if ( !msg ) return AFUNC_BADGLOBAL;
-	
-	nmode = query->mode(LWM_MODE_SELECTION);
-
-	//////////////////////////////////////////////
-	// Fail if user is not in point selection mode
-	//////////////////////////////////////////////
-	if ( md = csInit( global, local )) {
-
-		csMeshBegin( 0, 0, OPSEL_USER );
-
-		if (nmode == 1) {
-
-			pointEnum = 3;
-			polyEnum = mePolyCount( OPLYR_SELECT, EDCOUNT_SELECT );
-
-			//////////////////////////////////////////
-			// Fail if more than 1 polygon is selected
-			//////////////////////////////////////////
-			if ( polyEnum != 1 ) {
-				msg->error("Please select only 1 polygon.", NULL);
-				csMeshDone( EDERR_NONE, 0 );
-				return AFUNC_OK;
-			}
-		}
-		else if (nmode == 0) {
-
-			pointEnum = mePointCount( OPLYR_SELECT, EDCOUNT_SELECT );
-
-			//////////////////////////////////////////////////////
-			// Fail if there are not exactly three points selected
-			//////////////////////////////////////////////////////
-			if ( pointEnum != 3 ) {
-				msg->error("Please select 3 points.", NULL);
-				csMeshDone( EDERR_NONE, 0 );
-				return AFUNC_OK;
-			}
-		}
-		else {
-			msg->error("Please use a point or polygon selection and try again.", NULL);
-			csMeshDone( EDERR_NONE, 0 );
-			return AFUNC_OK;
-		}
-
-		//////////////////////////////
-		// Initialize the point arrays
-		//////////////////////////////
-		pinfo.pointArray = (double **)malloc(pointEnum * sizeof(double *));
-		npinfo.pointArray = (double **)malloc(pointEnum * sizeof(double *));
-
-		for (i=0; i<pointEnum; i++) {
-			pinfo.pointArray[i] = (double *)malloc( 3 * sizeof(double));
-			npinfo.pointArray[i] = (double *)malloc( 3 * sizeof(double));
-			for (j=0; j<3; j++) {
-				pinfo.pointArray[i][j] = 0.0;
-				npinfo.pointArray[i][j] = 0.0;
-			}
-		}
-
-		if (nmode == 1) {
-			if ( ( mePolyScan((EDPolyScanFunc *)KMPolyEnum, &pinfo, OPLYR_SELECT ) ) ) {
-				msg->error("Please select a polygon with 3 vertices.", NULL);
-				csMeshDone( EDERR_NONE, 0 );
-				return AFUNC_OK;
-			}
-		}
-
-		else {
-			mePointScan((EDPointScanFunc *)KMPointEnum, &pinfo, OPLYR_SELECT);
-		}
-
-		csMeshDone( EDERR_NONE, 0 );
-	}
-
-	// Get input from XPanel
-	ok = get_user( xpanf, &sides );
-	if (!ok) {
-		return AFUNC_OK;
-	}
-
-	//////////////////////
-	// Deselect all points
-	//////////////////////
-	sprintf( cmd, "SEL_POINT SET VOLUME <%g %g %g> <%g %g %g>", 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 );
-	local->evaluate( local->data, cmd );
-
-	/////////////////////////////////////////////
-	// Find the FG, BG, and ALL layers
-	// Keep FG and BG so we can be nice and reset
-	// the users selection after processing
-	/////////////////////////////////////////////
-	layers = query->layerList( OPLYR_FG, NULL );
-	fgLayers = (char *)malloc(strlen(layers)+1);
-	strcpy(fgLayers,layers);
-	layers = query->layerList( OPLYR_BG, NULL );
-	bgLayers = (char *)malloc(strlen(layers)+1);
-	strcpy(bgLayers,layers);
-	layers = query->layerList( OPLYR_NONEMPTY, NULL );
-	allLayers = (char *)malloc(strlen(layers)+1);
-	strcpy(allLayers,layers);
-
-	// Find the last empty FG layer
-    token = strtok( allLayers, seps );
-	while( token != NULL )
-	{
-		// Copy token value to temptoken
-		temptoken = (char *)malloc(strlen(token)+1);
-		strcpy(temptoken,token);
-
-		// Get next token
-		token = strtok( NULL, seps );
-
-		// Set lastLayer to the highest layer found
-		if (atoi(temptoken) > lastLayer) {
-			lastLayer = atoi(temptoken);
-		}
-	}
-
-	//////////////////////////////////
-	// Generate the translation matrix
-	//////////////////////////////////
-	KM_D4Transform( pointTranslate, -pinfo.pointArray[0][0], -pinfo.pointArray[0][1], -pinfo.pointArray[0][2] );
-
-	/////////////////////////////////////////////////////////////////////////////////////////////////
-	// Translate the positions of the three selected points relative to the first point to the origin
-	/////////////////////////////////////////////////////////////////////////////////////////////////
-	for (i=0; i<3; i++) {
-        LWMAT_dtransformp ( pinfo.pointArray[i], pointTranslate, npinfo.pointArray[i] );
-	}
-
-	//////////////////////////
-	// Rotate about the Z-Axis
-	//////////////////////////
-	VCPY ( temp, npinfo.pointArray[1] );
-	temp[2] = 0.0; // Use only the X and Y components
-	dangle = LWVEC_dangle( temp, unitX );
-
-	if (temp[1] < 0) {dangle*=(-1);}
-
-	if ( KM_D4Rotate( pointRotateZ, 'Z' , dangle ) ) {
-		return AFUNC_BADLOCAL;
-	}
-	
-	for (i=1; i<3; i++) {
-		VCPY ( temp, npinfo.pointArray[i] );
-        LWMAT_dtransformp ( temp, pointRotateZ, npinfo.pointArray[i] );
-	}
-
-	//////////////////////////
-	// Rotate about the Y-Axis
-	//////////////////////////
-	VCPY ( temp, npinfo.pointArray[1] );
-	temp[1] = 0.0; // Use only the X and Z components
-	dangle = LWVEC_dangle( temp, unitX );
-
-	if (temp[2] < 0) {dangle*=(-1);}
-
-	if ( KM_D4Rotate( pointRotateY, 'Y', dangle ) ) {
-		return AFUNC_BADLOCAL;
-	}
-
-	for (i=1; i<3; i++) {
-		VCPY ( temp, npinfo.pointArray[i] );
-        LWMAT_dtransformp ( temp, pointRotateY, npinfo.pointArray[i] );
-	}
-
-	//////////////////////////
-	// Rotate about the X-Axis
-	//////////////////////////
-	VCPY ( temp, npinfo.pointArray[2] );
-	temp[0] = 0.0; // Use only the Y and Z components
-	dangle = LWVEC_dangle( temp, unitY );
-
-	if (temp[2] < 0) {dangle*=(-1);}
-
-	if ( KM_D4Rotate( pointRotateX, 'X', dangle ) ) {
-		return AFUNC_BADLOCAL;
-	}
-
-	VCPY ( temp, npinfo.pointArray[2] );
-	LWMAT_dtransformp ( temp, pointRotateX, npinfo.pointArray[2] );
-    
-	///////////////////////////////////////
-	//Calculate the Center Point and Radius
-	///////////////////////////////////////
-	for (i=0; i<3; i++) {
-		v2_points[i].x = npinfo.pointArray[i][0];
-		v2_points[i].y = npinfo.pointArray[i][1];
-	}
-
-	v2_center.x = center[0];
-	v2_center.y = center[1];
-
-	if ( !ppp_circle(&v2_points[0], &v2_points[1], &v2_points[2], &v2_center, radius) ) {
-        msg->error("Cannot calculate center point.", "Points may be co-linear.");
-		return AFUNC_OK;
-	}
-
-	center[0] = v2_center.x;
-	center[1] = v2_center.y;
-	radius[2] = radius[1] = radius[0];
-
-	///////////////////////////////////
-	// setLayer is the next empty layer
-	///////////////////////////////////
-	lastLayer++;
-	_itoa(lastLayer, setLayer, 10);
-
-	sprintf( cmd, "SETLAYER \"%s\"", setLayer );
-	local->evaluate( local->data, cmd );
-
-	/////////////////////////////////
-	//Draw the circle
-	/////////////////////////////////
-	csMakeDisc( radius, 0.0, 0.0, "Z", sides, 1, center );
-    
-	////////////////////////////////////
-	// Select all points of new geometry
-	////////////////////////////////////
-	sprintf( cmd, "SEL_POINT SET VOLUME <%g %g %g> <%g %g %g>", 1000.0, 1000.0, 1000.0, -1000.0, -1000.0, -1000.0 );
-	local->evaluate( local->data, cmd );
-
-	/////////////////////////////////////////////////////
-	// Place the coordinates of all new points in an array
-	//////////////////////////////////////////////////////
-	if ( md = csInit( global, local )) {
-
-		csMeshBegin( 0, 0, OPSEL_USER );
-
-		pointEnum = mePointCount( OPLYR_SELECT, EDCOUNT_SELECT );
-
-		pointcircle.pointArray = (double **)malloc(pointEnum * sizeof(double *));
-
-		for (i=0; i<pointEnum; i++) {
-			pointcircle.pointArray[i] = (double *)malloc( 3 * sizeof(double));
-			for (j=0; j<3; j++) {
-				pointcircle.pointArray[i][j] = 0.0;
-			}
-		}
-		
-		mePointScan((EDPointScanFunc *)KMPointEnum, &pointcircle, OPLYR_SELECT);
-
-		csMeshDone( EDERR_NONE, 0 );
-	}
-
-	////////////////////////////////////////////////
-	// Generate the Transpose matrix pointRotateXYZT
-	////////////////////////////////////////////////
-
-	LWMAT_dcopym4( pointTranslateT, pointTranslate );
-	pointTranslateT[3][0] = (pointTranslate[3][0] * (-1.0));
-	pointTranslateT[3][1] = (pointTranslate[3][1] * (-1.0));
-	pointTranslateT[3][2] = (pointTranslate[3][2] * (-1.0));
-
-	LWMAT_transpose4( pointWork1, pointRotateX );
-	LWMAT_dcopym4( pointRotateX, pointWork1 );
-
-	LWMAT_transpose4( pointWork1, pointRotateY );
-	LWMAT_dcopym4( pointRotateY, pointWork1 );
-
-	LWMAT_transpose4( pointWork1, pointRotateZ );
-	LWMAT_dcopym4( pointRotateZ, pointWork1 );
-
-	LWMAT_dmatmul4  ( pointRotateX, pointRotateY, pointWork1 );
-	LWMAT_dmatmul4  ( pointWork1, pointRotateZ, pointWork2 );
-	LWMAT_dmatmul4  ( pointWork2, pointTranslateT, pointXYZT );
-
-	for (i=0; i<pointEnum; i++) {
-		VCPY ( temp, pointcircle.pointArray[i] );
-        LWMAT_dtransformp ( temp, pointXYZT, pointcircle.pointArray[i] );
-	}
-
-	cpntid = (LWPntID *)malloc(pointEnum * sizeof(LWPntID));
-
-	///////////////////////////////
-	// Delete the selected geometry
-	///////////////////////////////
-	csDelete();
-	
-	/////////////////////////////////
-	//Draw the new polygon
-	/////////////////////////////////
-	csMeshBegin( 0, 0, OPSEL_USER );
-	for (i=0; i<pointEnum; i++) {
-        cpntid[i] = meAddPoint( pointcircle.pointArray[i] );
-	}
-	meAddFace ( NULL, pointEnum, cpntid);
-	csMeshDone( EDERR_NONE, 0 );
-	
-	/////////////////////////////////////////////////////////
-	// Return layers to original selections plus newest layer
-	/////////////////////////////////////////////////////////
-	sprintf( cmd, "SETALAYER \"%s %s\"", fgLayers, setLayer);	
-	local->evaluate( local->data, cmd );
-	sprintf( cmd, "SETBLAYER \"%s\"", bgLayers);	
-	local->evaluate( local->data, cmd );
-
-	//////////////////////////////////////////////////////
-	// If initial selection mode was polygons return to it
-	//////////////////////////////////////////////////////
-	if (nmode) {
-		sprintf( cmd, "SEL_POLYGON CLEAR VOLINCL <%g %g %g> <%g %g %g>", 1000.0, 1000.0, 1000.0, -1000.0, -1000.0, -1000.0 );
-		local->evaluate( local->data, cmd );
-	}
-
-	//////////////
-	// free memory
-	//////////////
-	free(fgLayers);
-	fgLayers = NULL;
-	free(bgLayers);
-	bgLayers = NULL;
-	free(allLayers);
-	allLayers = NULL;
-	free(pointcircle.pointArray);
-	pointcircle.pointArray = NULL;
-
-	//////
-	//Done
-	//////
-	return AFUNC_OK;
-}
-
-
-/*
-======================================================================
-KMPointEnum()
-
-The callback passed to the MeshEditOp polyScan() function.  For each
-point selected, add its position to the point array.
-======================================================================*/
-
-XCALL_( static EDError )
-KMPointEnum( PointStack *pointcircle, const EDPointInfo *pointInfo ) {
-
-	int i;
-
-	if ( ( pointInfo->flags & EDDF_SELECT ) != EDDF_SELECT ) return EDERR_NONE;
-
-	for (i=0; i<3; i++){
-		pointcircle->pointArray[ pointcircle->pointCount ][ i ] = pointInfo->position[ i ];
-	}
-    
-	pointcircle->pointCount++;
-
-	return EDERR_NONE;
-}
-
-/*
-======================================================================
-KMPolyEnum()
-
-The callback passed to the MeshEditOp polyScan() function.  For each
-point selected, add its position to the point array.
-======================================================================*/
-
-XCALL_( static EDError )
-KMPolyEnum( PointStack *pointcircle, const EDPolygonInfo *polyInfo ) {
-
-	int i,j;
-	EDPointInfo *pointInfo;
-
-	if ( ( polyInfo->flags & EDDF_SELECT ) != EDDF_SELECT ) return EDERR_NONE;
-
-	if ( polyInfo->numPnts != 3) return EDERR_BADARGS;
-
-	pointcircle->pointCount = 3;
-
-	for (i=0; i<3; i++){
-			for (j=0; j<3; j++){
-				pointInfo = mePointInfo( polyInfo->points[i] );
-				pointcircle->pointArray[ i ][ j ] = pointInfo->position[ j ];
-			}
-	}
-    
-	return EDERR_NONE;
-}
-
-/*
-======================================================================
-KM_D4Transform()
-
-Helper function to generate translation matrices.
-
-Translate
-
-| 1  0  0  0 |
-| 0  1  0  0 |
-| 0  0  1  0 |
-| dx dy dz 1 |
-====================================================================== */
-void KM_D4Transform( LWDMatrix4 m, double a4, double b4, double c4 )
-{
-   m30 = a4;
-   m31 = b4;
-   m32 = c4;
-}
-
-/*
-======================================================================
-KM_D4Rotate()
-
-Helper function to generate rotation matrices.
-
-LWDMatrix4 m: pointer to a 4x4 matrix
-char axis: the X, Y, or Z axis of rotation
-double theta: the angle of rotation in degrees
-
-Rotate about X axis
-
-| 0 0   0    0 |
-| 0 cos -sin 0 |
-| 0 sin cos  0 |
-| 0 0   0    0 |
-
-
-Rotate about Y axis
-
-| cos 0 -sin 0 |
-| 0   0 0    0 |
-| sin 0 cos  0 |
-| 0   0 0    0 |
-
-
-Rotate about Z axis
-
-| cos -sin 0 0 |
-| sin cos  0 0 |
-| 0   0    0 0 |
-| 0   0    0 0 |
-
-====================================================================== */
-
-int KM_D4Rotate( LWDMatrix4 m, char axis, double theta) {
-
-	int i;
-	double t1, t2, t3, t4;
-	double t[4] = {0.0, 0.0, 0.0, 0.0};
-
-	t1 = t2 = t3 = t4 = 0.0;
-	
-	switch (axis) {
-
-		case 'x':
-		case 'X':
-			{			
-			t[0] = cos(theta) ; t[1] = -sin(theta);
-			t[2] = sin(theta); t[3] = cos(theta);
-			for (i=0; i<4; i++) {
-				if (( t[i] < 0.00000001 )&&( t[i] > -0.00000001 )) {t[i] = 0.0;}
-			}
-			m11 = t[0]; m12 = t[1]; m21 = t[2]; m22 = t[3];
-			break;
-			}
-		case 'y':
-		case 'Y':
-			{			
-			t[0] = cos(theta) ; t[1] = -sin(theta);
-			t[2] = sin(theta); t[3] = cos(theta);
-			for (i=0; i<4; i++) {
-				if (( t[i] < 0.00000001 )&&( t[i] > -0.00000001 )) {t[i] = 0.0;}
-			}
-			m00 = t[0]; m02 = t[1]; m20 = t[2]; m22 = t[3];
-			break;
-			}
-		case 'z':
-		case 'Z':
-			{			
-			t[0] = cos(theta) ; t[1] = -sin(theta);
-			t[2] = sin(theta); t[3] = cos(theta);
-			for (i=0; i<4; i++) {
-				if (( t[i] < 0.00000001 )&&( t[i] > -0.00000001 )) {t[i] = 0.0;}
-			}
-			m00 = t[0]; m01 = t[1]; m10 = t[2]; m11 = t[3];
-			break;
-			}
-		default:
-			return 1; // Error!
-	}
-	return 0;
-}
-
-/*
-======================================================================
-LWMAT_transpose4()
-
-Helper function to generate transpose matrices.
-====================================================================== */
-void LWMAT_transpose4( LWDMatrix4 n, LWDMatrix4 m ) {
-	LWMAT_dinitm4( n, m00, m10, m20, m30, m01, m11, m21, m31, m02, m12, m22, m32, m03, m13, m23, m33 );
-}
-
-/*
-======================================================================
-Server record declarations
-====================================================================== */
-
-ServerRecord ServerDesc[] = {
-   { LWMODCOMMAND_CLASS, "3PointCircle", Activate },
-   { NULL }
-};
+/*
+======================================================================
+3PointCircle.c
+
+A tool to generate a circle from any three arbitrary points.
+Contains some code modified from the LW SDK.
+
+The interactive version is 3PointCircleTool, in kmtool.c.
+
+Kevin MacPhail	08/19/03
+====================================================================== */
+
+#include <lwserver.h>
+#include <lwcmdseq.h>
+#include <lwmodeler.h>
+#include <lwxpanel.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <lwmodlib.h>
+#include <lwcomlib.h>
+#include <com_math.h>
+#include <com_vecmatquat.h>
+#include "pppcir.h"
+#include "pppring.h"
+#include "pppfit.h"
+#include "pppransac.h"
+#include "pppqual.h"
+#include "pppcurv.h"
+#include "pppthread.h"
+#include "kmarena.h"
+#include "kmtimer.h"
+#include "kmtool.h"
+
+#define a0 point[ 0 ][ 0 ]
+#define a1 point[ 0 ][ 1 ]
+#define b0 point[ 1 ][ 0 ]
+#define b1 point[ 1 ][ 1 ]
+#define c0 point[ 2 ][ 0 ]
+#define c1 point[ 2 ][ 1 ]
+
+#define KM_SHAPE_RING 0
+#define KM_SHAPE_ARC  1
+
+#define KM_MODE_POINTS   0   /* Modeler's selection modes */
+#define KM_MODE_POLYGONS 1
+#define KM_MODE_DETECT   2   /* every foreground point, RANSAC */
+#define KM_MODE_QUALITY  3   /* every foreground triangle, no geometry */
+#define KM_MODE_CURVATURE 4  /* selected polylines, no geometry */
+
+typedef struct st_PointStack{
+   KMArena *arena;
+   int pointCount;
+   int pointCapacity;
+   double (*pointArray)[3];
+} PointStack;
+
+typedef struct st_KMOptions{
+   int sides;
+   double tolerance; /* chord deviation, 0 for a fixed sides */
+   int minSides;  /* bounds on the sides derived from tolerance */
+   int maxSides;
+   int passes;
+   int shape;     /* KM_SHAPE_RING or KM_SHAPE_ARC */
+   int mode;      /* KM_MODE_*, -1 for Modeler's selection mode */
+   int layer;     /* output layer, 0 for the next empty one */
+   double inlier;    /* detection: inlier distance, 0 for automatic */
+   int support;      /* detection: inliers needed for a circle */
+   double maxRadius; /* detection: largest circle, 0 for automatic */
+   double minArc;    /* detection: arc its inliers cover, radians */
+   int worst;        /* quality: triangles listed in the report */
+   double limit;     /* quality: ratio counted as too high, 0 for none */
+   double minRadius; /* curvature: tighter windows are violations, 0 for none */
+   int select;       /* quality, curvature: select the offenders */
+   char *report;     /* quality, curvature: report file, "-" for stdout, NULL for none */
+   int given;     /* parameters found in the command argument */
+} KMOptions;
+
+typedef struct st_KMCurvature{
+   MeshEditOp *edit;
+   FILE *fp;         /* the report, NULL for none */
+   double minRadius; /* tighter windows are violations */
+   int select;       /* select the vertices of the violations */
+   long polylines;
+   long vertices;
+   long straight;
+   long cusps;
+   long violations;
+   double radiusMin;
+   v3_pos radiusMinAt;
+} KMCurvature;
+
+typedef struct st_KMCircle{
+   v3_pos center;
+   double radius;
+   int sides;
+   v3_vect normal;
+   v3_vect axisU;
+   v3_vect axisV;
+   int triple;    /* first of its points in the point stack, -1 for a fit */
+} KMCircle;
+
+typedef struct st_KMSpec{
+   const PointStack *pinfo;  /* the selection, only read while running */
+   KMOptions opt;            /* the values the panel opens with */
+   KMCircle *circles;        /* one per non co-linear triple */
+   int circleCount;
+   double (*ringXYZ)[3];     /* every ring, one after another */
+   long *first;              /* start of each circle's ring in ringXYZ */
+   int ok;                   /* finished, everything above is valid */
+   int running;
+   ppp_thread thread;
+} KMSpec;
+
+static KMOptions kmLast;     /* the panel values last used */
+static int kmLastValid = 0;
+
+static EDError KMPointEnum( PointStack *pointcircle, const EDPointInfo *pointInfo );
+static EDError KMPolyEnum( PointStack *pointcircle, const EDPolygonInfo *polyInfo );
+static EDError KMLayerPointEnum( PointStack *pointcircle, const EDPointInfo *pointInfo );
+static EDError KMFitEnum( ppp_fit *fit, const EDPointInfo *pointInfo );
+static EDError KMRefineEnum( ppp_fit_refine *refine, const EDPointInfo *pointInfo );
+static EDError KMQualityEnum( ppp_qual *qual, const EDPolygonInfo *polyInfo );
+static EDError KMCurveEnum( KMCurvature *curv, const EDPolygonInfo *polyInfo );
+static int KMQuality( LWMessageFuncs *msg, LWXPanelFuncs *xpanf, GlobalFunc *global,
+   LWModCommand *local, KMOptions *opt, KMTimer *timer );
+static int KMCurvatureCheck( LWMessageFuncs *msg, LWXPanelFuncs *xpanf, GlobalFunc *global,
+   LWModCommand *local, KMOptions *opt, KMTimer *timer );
+static int KMPointStackInit( PointStack *stack, KMArena *arena, int capacity );
+static int KMParseOptions( KMOptions *opt, const char *argument, KMArena *arena, char **bad );
+static double *KMPointStackPush( PointStack *stack );
+static int KMSolveTriples( const PointStack *pinfo, KMCircle *circles );
+static int KMCircleSides( KMCircle *circles, int circleCount, const KMOptions *opt );
+static void KMSpecStart( KMSpec *spec, const PointStack *pinfo, const KMOptions *opt );
+static void KMSpecJoin( KMSpec *spec );
+static void KMSpecFree( KMSpec *spec );
+static int KMSpecRings( const KMSpec *spec, const KMOptions *opt );
+static void KMRecallOptions( KMOptions *opt );
+static void KMRememberOptions( const KMOptions *opt );
+
+/*
+======================================================================
+LWXPanelFuncs
+
+Create the interface panel.
+====================================================================== */
+int get_user( LWXPanelFuncs *xpanf, KMOptions *opt, int fitting, int detecting )
+{
+   LWXPanelID panel;
+   int ok = 0;
+
+   enum { ID_SHAPE = 0x8001, ID_SIDES, ID_TOLERANCE, ID_MINSIDES, ID_MAXSIDES, ID_PASSES,
+      ID_INLIER, ID_SUPPORT, ID_MAXRADIUS, ID_MINARC };
+   static const char *shapes[] = { "Ring", "Arc", NULL };
+
+   LWXPanelControl ctl[] = {
+	  { ID_SHAPE, "Shape", "iPopChoice" },
+	  { ID_SIDES, "Number of Sides", "integer" },
+	  { ID_TOLERANCE, "Chord Tolerance", "distance" },
+	  { ID_MINSIDES, "Min Sides", "integer" },
+	  { ID_MAXSIDES, "Max Sides", "integer" },
+	  { ID_PASSES, "Refinement Passes", "integer" },
+	  { ID_INLIER, "Inlier Distance", "distance" },
+	  { ID_SUPPORT, "Min Support", "integer" },
+	  { ID_MAXRADIUS, "Max Radius", "distance" },
+	  { ID_MINARC, "Min Arc", "angle" },
+      { 0 }
+   };
+   LWXPanelDataDesc cdata[] = {
+	  { ID_SHAPE, "Shape", "integer" },
+	  { ID_SIDES, "Number of Sides", "integer" },
+	  { ID_TOLERANCE, "Chord Tolerance", "distance" },
+	  { ID_MINSIDES, "Min Sides", "integer" },
+	  { ID_MAXSIDES, "Max Sides", "integer" },
+	  { ID_PASSES, "Refinement Passes", "integer" },
+	  { ID_INLIER, "Inlier Distance", "distance" },
+	  { ID_SUPPORT, "Min Support", "integer" },
+	  { ID_MAXRADIUS, "Max Radius", "distance" },
+	  { ID_MINARC, "Min Arc", "angle" },
+      { 0 }
+   };
+   LWXPanelHint hint[] = {
+	   XpLABEL( 0, "3PointCircle v1.1.0" ),
+	   XpSTRLIST( ID_SHAPE, shapes ),
+	   XpEND
+   };
+
+   // Refinement passes only apply to a fit of more than 3 points
+   // or to detection, the last four controls only to detection
+   if ( !detecting ) {
+      ctl[ 6 ].cid = 0;
+      cdata[ 6 ].vid = 0;
+   }
+   if ( !fitting && !detecting ) {
+      ctl[ 5 ].cid = 0;
+      cdata[ 5 ].vid = 0;
+   }
+
+   panel = xpanf->create( LWXP_FORM, ctl );
+   if ( !panel ) return 0;
+
+   xpanf->describe( panel, cdata, NULL, NULL );
+   xpanf->hint( panel, 0, hint );
+   xpanf->formSet( panel, ID_SHAPE, &opt->shape );
+   xpanf->formSet( panel, ID_SIDES, &opt->sides );
+   xpanf->formSet( panel, ID_TOLERANCE, &opt->tolerance );
+   xpanf->formSet( panel, ID_MINSIDES, &opt->minSides );
+   xpanf->formSet( panel, ID_MAXSIDES, &opt->maxSides );
+   if ( fitting || detecting ) xpanf->formSet( panel, ID_PASSES, &opt->passes );
+   if ( detecting ) {
+      xpanf->formSet( panel, ID_INLIER, &opt->inlier );
+      xpanf->formSet( panel, ID_SUPPORT, &opt->support );
+      xpanf->formSet( panel, ID_MAXRADIUS, &opt->maxRadius );
+      xpanf->formSet( panel, ID_MINARC, &opt->minArc );
+   }
+
+   ok = xpanf->post( panel );
+
+   if ( ok ) {
+       int *i;
+	   double *d;
+	   
+	   i = xpanf->formGet( panel, ID_SHAPE );
+	   opt->shape = *i;
+	   i = xpanf->formGet( panel, ID_SIDES );
+	   opt->sides = *i;
+	   d = xpanf->formGet( panel, ID_TOLERANCE );
+	   opt->tolerance = *d;
+	   i = xpanf->formGet( panel, ID_MINSIDES );
+	   opt->minSides = *i;
+	   i = xpanf->formGet( panel, ID_MAXSIDES );
+	   opt->maxSides = *i;
+	   if ( fitting || detecting ) {
+		   i = xpanf->formGet( panel, ID_PASSES );
+		   opt->passes = *i;
+	   }
+	   if ( detecting ) {
+		   d = xpanf->formGet( panel, ID_INLIER );
+		   opt->inlier = *d;
+		   i = xpanf->formGet( panel, ID_SUPPORT );
+		   opt->support = *i;
+		   d = xpanf->formGet( panel, ID_MAXRADIUS );
+		   opt->maxRadius = *d;
+		   d = xpanf->formGet( panel, ID_MINARC );
+		   opt->minArc = *d;
+	   }
+   }
+
+   xpanf->destroy( panel );
+   return ok;
+}
+
+/*
+======================================================================
+get_quality()
+
+The panel of the quality analysis.
+====================================================================== */
+int get_quality( LWXPanelFuncs *xpanf, KMOptions *opt )
+{
+   LWXPanelID panel;
+   int ok = 0;
+
+   enum { ID_WORST = 0x8001, ID_LIMIT, ID_SELECT };
+
+   LWXPanelControl ctl[] = {
+	  { ID_WORST, "Worst Listed", "integer" },
+	  { ID_LIMIT, "Ratio Limit", "float" },
+	  { ID_SELECT, "Select Offenders", "iBoolean" },
+      { 0 }
+   };
+   LWXPanelDataDesc cdata[] = {
+	  { ID_WORST, "Worst Listed", "integer" },
+	  { ID_LIMIT, "Ratio Limit", "float" },
+	  { ID_SELECT, "Select Offenders", "integer" },
+      { 0 }
+   };
+   LWXPanelHint hint[] = {
+	   XpLABEL( 0, "3PointCircle Quality" ),
+	   XpEND
+   };
+
+   panel = xpanf->create( LWXP_FORM, ctl );
+   if ( !panel ) return 0;
+
+   xpanf->describe( panel, cdata, NULL, NULL );
+   xpanf->hint( panel, 0, hint );
+   xpanf->formSet( panel, ID_WORST, &opt->worst );
+   xpanf->formSet( panel, ID_LIMIT, &opt->limit );
+   xpanf->formSet( panel, ID_SELECT, &opt->select );
+
+   ok = xpanf->post( panel );
+
+   if ( ok ) {
+       int *i;
+	   double *d;
+
+	   i = xpanf->formGet( panel, ID_WORST );
+	   opt->worst = *i;
+	   d = xpanf->formGet( panel, ID_LIMIT );
+	   opt->limit = *d;
+	   i = xpanf->formGet( panel, ID_SELECT );
+	   opt->select = *i;
+   }
+
+   xpanf->destroy( panel );
+   return ok;
+}
+
+/*
+======================================================================
+get_curvature()
+
+The panel of the curvature check.
+====================================================================== */
+int get_curvature( LWXPanelFuncs *xpanf, KMOptions *opt )
+{
+   LWXPanelID panel;
+   int ok = 0;
+
+   enum { ID_MINRADIUS = 0x8001, ID_SELECT };
+
+   LWXPanelControl ctl[] = {
+	  { ID_MINRADIUS, "Min Radius", "distance" },
+	  { ID_SELECT, "Select Violations", "iBoolean" },
+      { 0 }
+   };
+   LWXPanelDataDesc cdata[] = {
+	  { ID_MINRADIUS, "Min Radius", "distance" },
+	  { ID_SELECT, "Select Violations", "integer" },
+      { 0 }
+   };
+   LWXPanelHint hint[] = {
+	   XpLABEL( 0, "3PointCircle Curvature" ),
+	   XpEND
+   };
+
+   panel = xpanf->create( LWXP_FORM, ctl );
+   if ( !panel ) return 0;
+
+   xpanf->describe( panel, cdata, NULL, NULL );
+   xpanf->hint( panel, 0, hint );
+   xpanf->formSet( panel, ID_MINRADIUS, &opt->minRadius );
+   xpanf->formSet( panel, ID_SELECT, &opt->select );
+
+   ok = xpanf->post( panel );
+
+   if ( ok ) {
+       int *i;
+	   double *d;
+
+	   d = xpanf->formGet( panel, ID_MINRADIUS );
+	   opt->minRadius = *d;
+	   i = xpanf->formGet( panel, ID_SELECT );
+	   opt->select = *i;
+   }
+
+   xpanf->destroy( panel );
+   return ok;
+}
+
+/*
+======================================================================
+KMActivate()
+
+The body of both commands.  mode is the KM_MODE_* to use when the
+argument does not name one, -1 for Modeler's selection mode.
+====================================================================== */
+static int KMActivate( long version, GlobalFunc *global, LWModCommand *local,
+   int mode )
+{
+	char cmd[ 128 ];
+	LWStateQueryFuncs *query;
+	LWMessageFuncs *msg;
+	LWXPanelFuncs *xpanf;
+	ModData *md;
+	KMArena arena;
+	KMTimer timer;
+	int result = AFUNC_OK;
+	int ok = 0;
+	int selMode;
+	int nmode;
+	KMOptions opt;
+	char *bad;
+	int fitting = 0;
+	int detecting = 0;
+	int pointEnum = 0;
+	int polyEnum = 0;
+	int circleEnum = 0;
+	int circleCount = 0;
+	int i, k;
+	PointStack pinfo;
+	const ppp_ring *ring;
+	double (*ringXYZ)[3];
+	LWPntID *cpntid;
+	v3_pos v3_points[3];
+	KMCircle *circles;
+	KMSpec spec;
+	int ringsReady;
+	double (*emitXYZ)[3];
+	ppp_fit fit;
+	ppp_fit_circle fitCircle, fitNext;
+	ppp_fit_refine refine;
+	ppp_ransac_params ransac;
+	ppp_fit_circle *found;
+	int lastLayer = 0;
+	const char *layers;
+	char *fgLayers, *bgLayers, *allLayers;
+	char setLayer[20];
+	char *token;
+	char seps[] = " ";
+
+	/////////////////////
+	// Initialize Globals
+	/////////////////////
+	if ( version != LWMODCOMMAND_VERSION ) return AFUNC_BADVERSION;
+
+	query = global( LWSTATEQUERYFUNCS_GLOBAL, GFUSE_TRANSIENT );
+	if ( !query ) return AFUNC_BADGLOBAL;
+
+	xpanf = global( LWXPANELFUNCS_GLOBAL, GFUSE_TRANSIENT );
+	if ( !xpanf ) return AFUNC_BADGLOBAL;
+
+	msg = global (LWMESSAGEFUNCS_GLOBAL, GFUSE_TRANSIENT);
+	if ( !msg ) return AFUNC_BADGLOBAL;
+	
+	selMode = query->mode(LWM_MODE_SELECTION);
+
+	KMTimerBegin( &timer );
+
+	//////////////////////////////////////////////////////////
+	// Everything below is allocated from the arena and freed
+	// in one shot at done:
+	//////////////////////////////////////////////////////////
+	KMArenaInit( &arena );
+	KMPointStackInit( &pinfo, &arena, 0 );
+	memset( &spec, 0, sizeof(spec) );
+
+	///////////////////////////////////////////////////
+	// Parameters given in the command argument replace
+	// the XPanel, so macros can run without the UI
+	///////////////////////////////////////////////////
+	if ( !KMParseOptions( &opt, local->argument, &arena, &bad )) {
+		msg->error("Unknown 3PointCircle argument:", bad);
+		goto done;
+	}
+	if ( !opt.given ) KMRecallOptions( &opt );
+	if ( opt.mode < 0 ) opt.mode = mode;
+
+	/////////////////////////////////////////////////////
+	// Modeler's selection mode only ever picks points or
+	// polygons.  Its other modes share numbers with the
+	// KM_MODE_*s (volume is 2) and fall through to the
+	// error below.
+	/////////////////////////////////////////////////////
+	if ( opt.mode >= 0 ) nmode = opt.mode;
+	else if ( selMode == KM_MODE_POINTS || selMode == KM_MODE_POLYGONS ) nmode = selMode;
+	else nmode = -1;
+	detecting = ( nmode == KM_MODE_DETECT );
+
+	//////////////////////////////////////////////
+	// The quality and curvature checks only read
+	// the mesh
+	//////////////////////////////////////////////
+	if ( nmode == KM_MODE_QUALITY ) {
+		result = KMQuality( msg, xpanf, global, local, &opt, &timer );
+		goto done;
+	}
+	if ( nmode == KM_MODE_CURVATURE ) {
+		result = KMCurvatureCheck( msg, xpanf, global, local, &opt, &timer );
+		goto done;
+	}
+
+	//////////////////////////////////////////////
+	// Fail if user is not in point selection mode
+	//////////////////////////////////////////////
+	if ( md = csInit( global, local )) {
+
+		csMeshBegin( 0, 0, OPSEL_USER );
+
+		if (nmode == 1) {
+
+			polyEnum = mePolyCount( OPLYR_SELECT, EDCOUNT_SELECT );
+			pointEnum = 3 * polyEnum;
+
+			///////////////////////////////////
+			// Fail if no polygons are selected
+			///////////////////////////////////
+			if ( polyEnum < 1 ) {
+				msg->error("Please select one or more polygons.", NULL);
+				csMeshDone( EDERR_NONE, 0 );
+				goto done;
+			}
+		}
+		else if (nmode == 0) {
+
+			pointEnum = mePointCount( OPLYR_SELECT, EDCOUNT_SELECT );
+
+			//////////////////////////////////////////////
+			// Fail if there are fewer than 3 points, fit
+			// a circle to them if there are more than 3
+			//////////////////////////////////////////////
+			if ( pointEnum < 3 ) {
+				msg->error("Please select 3 or more points.", NULL);
+				csMeshDone( EDERR_NONE, 0 );
+				goto done;
+			}
+			fitting = ( pointEnum > 3 );
+		}
+		else if ( detecting ) {
+
+			/////////////////////////////////////////////
+			// Detection looks at every point in the
+			// foreground layers, selected or not
+			/////////////////////////////////////////////
+			pointEnum = mePointCount( OPLYR_FG, EDCOUNT_ALL );
+			if ( pointEnum < 3 ) {
+				msg->error("The foreground layers need 3 or more points.", NULL);
+				csMeshDone( EDERR_NONE, 0 );
+				goto done;
+			}
+		}
+		else {
+			msg->error("Please use a point or polygon selection and try again.", NULL);
+			csMeshDone( EDERR_NONE, 0 );
+			goto done;
+		}
+
+		if ( fitting ) {
+			/////////////////////////////////////////////////
+			// Stream the points into the fit moments, the
+			// points themselves are not kept
+			/////////////////////////////////////////////////
+			ppp_fit_init( &fit );
+			mePointScan((EDPointScanFunc *)KMFitEnum, &fit, OPLYR_SELECT);
+		}
+
+		/////////////////////////////
+		// Initialize the point array
+		/////////////////////////////
+		else if ( !KMPointStackInit( &pinfo, &arena, pointEnum ) ) {
+			msg->error("Not enough memory for the selection.", NULL);
+			csMeshDone( EDERR_NONE, 0 );
+			goto done;
+		}
+
+		if (nmode == 1) {
+			if ( mePolyScan((EDPolyScanFunc *)KMPolyEnum, &pinfo, OPLYR_SELECT ) == EDERR_NOMEMORY ) {
+				msg->error("Not enough memory for the selection.", NULL);
+				csMeshDone( EDERR_NONE, 0 );
+				goto done;
+			}
+			if ( pinfo.pointCount == 0 ) {
+				msg->error("Please select a polygon with 3 vertices.", NULL);
+				csMeshDone( EDERR_NONE, 0 );
+				goto done;
+			}
+		}
+
+		else if ( detecting ) {
+			mePointScan((EDPointScanFunc *)KMLayerPointEnum, &pinfo, OPLYR_FG);
+		}
+
+		else if ( !fitting ) {
+			mePointScan((EDPointScanFunc *)KMPointEnum, &pinfo, OPLYR_SELECT);
+		}
+
+		csMeshDone( EDERR_NONE, 0 );
+	}
+	KMTimerMark( &timer, KMT_SCAN );
+
+	// Get input from XPanel, unless the argument had it
+	if ( opt.given ) ok = 1;
+	else {
+		/////////////////////////////////////////////////////
+		// While the panel is up, a background thread solves
+		// the triples and builds their rings for the values
+		// the panel opens with, the last ones used.  A fit
+		// and a detection rescan the mesh, so they wait.
+		/////////////////////////////////////////////////////
+		if ( !fitting && !detecting ) KMSpecStart( &spec, &pinfo, &opt );
+		ok = get_user( xpanf, &opt, fitting, detecting );
+		KMSpecJoin( &spec );
+		if ( ok ) KMRememberOptions( &opt );
+	}
+	KMTimerMark( &timer, KMT_PANEL );
+	if (!ok) {
+		goto done;
+	}
+
+	if ( opt.sides < 3 ) {
+		msg->error("Number of Sides must be 3 or more.", NULL);
+		goto done;
+	}
+
+	if ( opt.tolerance > 0.0 && ( opt.minSides < 3 || opt.maxSides < opt.minSides )) {
+		msg->error("Min Sides must be 3 or more and at most Max Sides.", NULL);
+		goto done;
+	}
+
+	if ( opt.passes < 0 ) {
+		msg->error("Refinement Passes must be 0 or more.", NULL);
+		goto done;
+	}
+
+	if ( detecting && ( opt.support < 3 || opt.inlier < 0.0 || opt.maxRadius < 0.0 )) {
+		msg->error("Min Support must be 3 or more, Inlier Distance and Max Radius 0 or more.", NULL);
+		goto done;
+	}
+	if ( detecting && !( opt.minArc >= 0.0 && opt.minArc <= 2.0 * PI )) {
+		msg->error("Min Arc must be between 0 and 360 degrees.", NULL);
+		goto done;
+	}
+
+	/////////////////////////////////////////////
+	// Find the FG, BG, and ALL layers
+	// Keep FG and BG so we can be nice and reset
+	// the users selection after processing
+	/////////////////////////////////////////////
+	layers = query->layerList( OPLYR_FG, NULL );
+	fgLayers = KMArenaStrdup( &arena, layers );
+	layers = query->layerList( OPLYR_BG, NULL );
+	bgLayers = KMArenaStrdup( &arena, layers );
+	layers = query->layerList( OPLYR_NONEMPTY, NULL );
+	allLayers = KMArenaStrdup( &arena, layers );
+	if ( !fgLayers || !bgLayers || !allLayers ) {
+		msg->error("Not enough memory for the layer lists.", NULL);
+		goto done;
+	}
+
+	// Find the last empty FG layer
+    token = strtok( allLayers, seps );
+	while( token != NULL )
+	{
+		// Set lastLayer to the highest layer found
+		if (atoi(token) > lastLayer) {
+			lastLayer = atoi(token);
+		}
+
+		// Get next token
+		token = strtok( NULL, seps );
+	}
+	KMTimerMark( &timer, KMT_LAYERS );
+
+	///////////////////////////////////////////////////////
+	// Calculate the Center Point, Radius and circle plane
+	// of every triangle.  Co-linear triangles are skipped.
+	///////////////////////////////////////////////////////
+	circleEnum = fitting ? 1 : pinfo.pointCount / ( detecting ? opt.support : 3 );
+	if ( spec.ok ) circles = spec.circles;
+	else circles = (KMCircle *)KMArenaAlloc( &arena, circleEnum * sizeof(KMCircle) );
+	if ( !circles ) {
+		msg->error("Not enough memory for the circles.", NULL);
+		goto done;
+	}
+
+	///////////////////////////////////////////////////////
+	// A fit starts from the Pratt circle of the moments.
+	// Each refinement pass rescans the points for one
+	// Gauss-Newton step; the last pass only measures the
+	// RMS distance of the points from the circle.
+	///////////////////////////////////////////////////////
+	if ( fitting && ppp_fit_solve( &fit, PPP_FIT_PRATT, &fitCircle ) ) {
+		csMeshBegin( 0, 0, OPSEL_USER );
+		for (i=0; i<=opt.passes; i++) {
+			ppp_fit_refine_init( &refine, &fitCircle );
+			mePointScan((EDPointScanFunc *)KMRefineEnum, &refine, OPLYR_SELECT);
+			fitCircle.rms = ppp_fit_refine_rms( &refine );
+			if ( i == opt.passes || !ppp_fit_refine_step( &refine, &fitNext ) ) break;
+			fitCircle = fitNext;
+		}
+		csMeshDone( EDERR_NONE, 0 );
+
+		circles[0].center = fitCircle.center;
+		circles[0].radius = fitCircle.radius;
+		circles[0].normal = fitCircle.normal;
+		circles[0].axisU = fitCircle.u;
+		circles[0].axisV = fitCircle.v;
+		circles[0].triple = -1;
+		circleCount = 1;
+	}
+
+	///////////////////////////////////////////////////////
+	// Detection samples random triples of nearby points on
+	// all processors and peels off the best supported
+	// circle until none has Min Support inliers left.  The
+	// circles are refined fits, like the one above.
+	///////////////////////////////////////////////////////
+	if ( detecting ) {
+		found = (ppp_fit_circle *)KMArenaAlloc( &arena, circleEnum * sizeof(ppp_fit_circle) );
+		ppp_ransac_defaults( &ransac );
+		ransac.tolerance = opt.inlier;
+		ransac.max_radius = opt.maxRadius;
+		ransac.min_arc = opt.minArc;
+		ransac.min_support = opt.support;
+		ransac.passes = opt.passes;
+
+		circleCount = found ? ppp_ransac( pinfo.pointCount, (const double (*)[3])pinfo.pointArray,
+			&ransac, found, circleEnum ) : -1;
+		if ( circleCount < 0 ) {
+			circleCount = 0;
+			msg->error("Not enough memory for the detection.", NULL);
+			goto done;
+		}
+
+		for (k=0; k<circleCount; k++) {
+			circles[k].center = found[k].center;
+			circles[k].radius = found[k].radius;
+			circles[k].normal = found[k].normal;
+			circles[k].axisU = found[k].u;
+			circles[k].axisV = found[k].v;
+			circles[k].triple = -1;
+		}
+	}
+
+	// The triples, unless the panel thread has solved them
+	if ( spec.ok ) circleCount = spec.circleCount;
+	else if ( !fitting && !detecting ) circleCount = KMSolveTriples( &pinfo, circles );
+	KMTimerMark( &timer, KMT_SOLVE );
+
+	if ( circleCount == 0 && detecting ) {
+		msg->error("No circles found.", "Try a larger Inlier Distance or a smaller Min Support or Min Arc.");
+		goto done;
+	}
+
+	if ( circleCount == 0 ) {
+        msg->error("Cannot calculate center point.", "Points may be co-linear.");
+		goto done;
+	}
+
+	///////////////////////////////////////////////////
+	// setLayer is the next empty layer, or the one the
+	// argument asked for
+	///////////////////////////////////////////////////
+	lastLayer = opt.layer ? opt.layer : lastLayer + 1;
+	sprintf( setLayer, "%d", lastLayer );
+
+	sprintf( cmd, "SETLAYER \"%s\"", setLayer );
+	local->evaluate( local->data, cmd );
+
+	///////////////////////////////////////////////////
+	// With a chord tolerance every circle gets its own
+	// side count; the buffers fit the largest of them
+	///////////////////////////////////////////////////
+	pointEnum = KMCircleSides( circles, circleCount, &opt );
+	ringsReady = KMSpecRings( &spec, &opt );
+
+	// an arc has up to one vertex more than the ring
+	ringXYZ = (double (*)[3])KMArenaAlloc( &arena, ( pointEnum + 1 ) * sizeof(*ringXYZ) );
+	cpntid = (LWPntID *)KMArenaAlloc( &arena, ( pointEnum + 1 ) * sizeof(LWPntID) );
+	if ( !ringXYZ || !cpntid ) {
+		msg->error("Not enough memory for the circle.", NULL);
+		goto done;
+	}
+
+	//////////////////////////////////////////
+	//Draw all the new polygons in one session
+	//////////////////////////////////////////
+	ring = NULL;
+	csMeshBegin( 0, 0, OPSEL_USER );
+	for (k=0; k<circleCount; k++) {
+		///////////////////////////////////////////////////
+		// An arc runs from the first point to the third
+		// through the second, as a chain of line polygons.
+		// A fit has no such points and always gets a ring.
+		///////////////////////////////////////////////////
+		if ( opt.shape == KM_SHAPE_ARC && circles[k].triple >= 0 ) {
+			double (*pick)[3] = pinfo.pointArray + circles[k].triple;
+			double start, sweep;
+
+			for (i=0; i<3; i++) {
+				v3_points[i].x = pick[i][0];
+				v3_points[i].y = pick[i][1];
+				v3_points[i].z = pick[i][2];
+			}
+			ppp_arc_angles( &circles[k].center, &circles[k].axisU, &circles[k].axisV,
+				&v3_points[0], &v3_points[1], &v3_points[2], &start, &sweep );
+			pointEnum = ppp_arc_segments( sweep, circles[k].sides ) + 1;
+			ppp_arc_emit( &circles[k].center, circles[k].radius, &circles[k].axisU,
+				&circles[k].axisV, start, sweep, pointEnum - 1, ringXYZ );
+
+			// end exactly on the picked points
+			VCPY( ringXYZ[0], pick[0] );
+			VCPY( ringXYZ[pointEnum-1], pick[2] );
+
+			for (i=0; i<pointEnum; i++) {
+				cpntid[i] = meAddPoint( ringXYZ[i] );
+			}
+			for (i=0; i<pointEnum-1; i++) {
+				meAddFace ( NULL, 2, cpntid + i );
+			}
+			continue;
+		}
+
+		// The ring from the panel thread, if the panel kept its sides
+		if ( ringsReady ) {
+			pointEnum = circles[k].sides;
+			emitXYZ = spec.ringXYZ + spec.first[k];
+		}
+		else {
+			// Cached unit circle table, shared by circles of one size
+			if ( !ring || ring->sides != circles[k].sides ) {
+				if ( !( ring = ppp_ring_table( circles[k].sides ))) break;
+			}
+			pointEnum = ring->sides;
+			ppp_ring_emit( ring, &circles[k].center, circles[k].radius,
+				&circles[k].axisU, &circles[k].axisV, ringXYZ );
+			emitXYZ = ringXYZ;
+		}
+
+		for (i=0; i<pointEnum; i++) {
+			cpntid[i] = meAddPoint( emitXYZ[i] );
+		}
+		meAddFace ( NULL, pointEnum, cpntid);
+	}
+	csMeshDone( EDERR_NONE, 0 );
+	KMTimerMark( &timer, KMT_BUILD );
+
+	if ( k < circleCount ) {
+		msg->error("Not enough memory for the circle.", NULL);
+		goto done;
+	}
+
+	/////////////////////////////////////////////////////
+	// Reports need an OK click, so headless runs skip them
+	/////////////////////////////////////////////////////
+	if ( fitting && !opt.given ) {
+		sprintf( cmd, "Fitted %ld points: radius %g, RMS residual %g.",
+			fitCircle.n, fitCircle.radius, fitCircle.rms );
+		msg->info( cmd, NULL );
+	}
+
+	if ( detecting && !opt.given ) {
+		sprintf( cmd, "Found %d circles in %d points.", circleCount, pinfo.pointCount );
+		msg->info( cmd, NULL );
+	}
+
+	if ( circleCount < polyEnum && !opt.given ) {
+		sprintf( cmd, "%d of %d polygons were skipped.", polyEnum - circleCount, polyEnum );
+		msg->info( cmd, "Only non co-linear triangles make circles." );
+	}
+	
+	/////////////////////////////////////////////////////////
+	// Return layers to original selections plus newest layer
+	/////////////////////////////////////////////////////////
+	sprintf( cmd, "SETALAYER \"%s %s\"", fgLayers, setLayer);	
+	local->evaluate( local->data, cmd );
+	sprintf( cmd, "SETBLAYER \"%s\"", bgLayers);	
+	local->evaluate( local->data, cmd );
+	KMTimerMark( &timer, KMT_RESTORE );
+
+	//////
+	//Done
+	//////
+done:
+	KMTimerEnd( &timer, circleCount );
+	KMSpecFree( &spec );
+	KMArenaFree( &arena );
+	return result;
+}
+
+/*
+======================================================================
+Activate()
+
+The plug-in activation function.  Makes circles from the selection.
+====================================================================== */
+XCALL_( int )
+Activate( long version, GlobalFunc *global, LWModCommand *local,
+   void *serverData )
+{
+	return KMActivate( version, global, local, -1 );
+}
+
+/*
+======================================================================
+ActivateDetect()
+
+The activation function of 3PointCircleDetect.  Finds the circles
+among all the points of the foreground layers.
+====================================================================== */
+XCALL_( int )
+ActivateDetect( long version, GlobalFunc *global, LWModCommand *local,
+   void *serverData )
+{
+	return KMActivate( version, global, local, KM_MODE_DETECT );
+}
+
+
+/*
+======================================================================
+ActivateQuality()
+
+The activation function of 3PointCircleQuality.  Measures the
+circumradius of every triangle of the foreground layers.
+====================================================================== */
+XCALL_( int )
+ActivateQuality( long version, GlobalFunc *global, LWModCommand *local,
+   void *serverData )
+{
+	return KMActivate( version, global, local, KM_MODE_QUALITY );
+}
+
+/*
+======================================================================
+KMQuality()
+
+The quality analysis.  Every triangle of the foreground layers goes
+through ppp_qual in one polygon scan; the report lists the histograms
+of circumradius / shortest edge and of circumradius and the worst
+triangles.  With Select Offenders the triangles over Ratio Limit, or
+the worst listed without a limit, become the polygon selection.  No
+geometry is made.
+====================================================================== */
+static int KMQuality( LWMessageFuncs *msg, LWXPanelFuncs *xpanf, GlobalFunc *global,
+   LWModCommand *local, KMOptions *opt, KMTimer *timer )
+{
+	char line[ 128 ];
+	ppp_qual qual;
+	MeshEditOp *edit;
+	FILE *fp = NULL;
+	EDError err;
+	long i, picked;
+	int b;
+
+	// Get input from XPanel, unless the argument had it
+	if ( !opt->given ) {
+		if ( !get_quality( xpanf, opt )) return AFUNC_OK;
+		KMRememberOptions( opt );
+	}
+	KMTimerMark( timer, KMT_PANEL );
+
+	if ( opt->worst < 0 || opt->limit < 0.0 ) {
+		msg->error("Worst Listed and Ratio Limit must be 0 or more.", NULL);
+		return AFUNC_OK;
+	}
+
+	if ( !ppp_qual_init( &qual, opt->worst, opt->limit, opt->select ) ) {
+		msg->error("Not enough memory for the analysis.", NULL);
+		return AFUNC_OK;
+	}
+
+	if ( !csInit( global, local ) ) {
+		ppp_qual_free( &qual );
+		return AFUNC_OK;
+	}
+	csMeshBegin( 0, 0, OPSEL_USER );
+	err = mePolyScan((EDPolyScanFunc *)KMQualityEnum, &qual, OPLYR_FG);
+	csMeshDone( EDERR_NONE, 0 );
+	KMTimerMark( timer, KMT_SCAN );
+
+	if ( err == EDERR_NOMEMORY || !ppp_qual_finish( &qual ) ) {
+		msg->error("Not enough memory for the analysis.", NULL);
+		ppp_qual_free( &qual );
+		return AFUNC_OK;
+	}
+	KMTimerMark( timer, KMT_SOLVE );
+
+	if ( qual.triangles == 0 ) {
+		msg->error("The foreground layers have no triangles.", NULL);
+		ppp_qual_free( &qual );
+		return AFUNC_OK;
+	}
+
+	/////////////////////////////////////////////
+	// The report goes to a file, or stdout for
+	// headless runs
+	/////////////////////////////////////////////
+	if ( opt->report ) {
+		fp = strcmp( opt->report, "-" ) ? fopen( opt->report, "w" ) : stdout;
+		if ( !fp ) msg->error("Cannot write the report:", opt->report);
+	}
+	if ( fp ) {
+		fprintf( fp, "triangles %ld  degenerate %ld  over limit %ld\n",
+			qual.triangles, qual.degenerate, qual.over );
+		if ( qual.triangles > qual.degenerate )
+			fprintf( fp, "ratio min %.6g  mean %.6g  max %.6g\n", qual.ratio_min,
+				qual.ratio_sum / ( qual.triangles - qual.degenerate ), qual.ratio_max );
+
+		fprintf( fp, "circumradius / shortest edge\n" );
+		for ( b=0; b<PPP_QUAL_RATIO_BINS; b++ ) {
+			if ( b < PPP_QUAL_RATIO_BINS - 1 )
+				fprintf( fp, "  < %-8g %ld\n", ppp_qual_ratio_edge[b], qual.ratio_hist[b] );
+			else
+				fprintf( fp, "  >= %-7g %ld\n", ppp_qual_ratio_edge[b-1], qual.ratio_hist[b] );
+		}
+		fprintf( fp, "  degenerate %ld\n", qual.degenerate );
+
+		fprintf( fp, "circumradius\n" );
+		for ( b=0; b<PPP_QUAL_RADIUS_BINS; b++ ) {
+			if ( qual.radius_hist[b] == 0 ) continue;
+			fprintf( fp, "  < %-8g %ld\n", ldexp( 1.0, b + PPP_QUAL_RADIUS_LOW + 1 ),
+				qual.radius_hist[b] );
+		}
+
+		fprintf( fp, "worst\n" );
+		for ( b=0; b<qual.worst_n; b++ ) {
+			fprintf( fp, "  ratio %-12g radius %-12g at %g %g %g\n", qual.worst[b].ratio,
+				qual.worst[b].radius, qual.worst[b].centroid[0], qual.worst[b].centroid[1],
+				qual.worst[b].centroid[2] );
+		}
+		if ( fp != stdout ) fclose( fp );
+	}
+
+	/////////////////////////////////////////////////////
+	// The offenders replace the polygon selection: the
+	// triangles over the limit, or the worst without one
+	/////////////////////////////////////////////////////
+	picked = 0;
+	if ( opt->select ) {
+		edit = csMeshBegin( 0, 0, OPSEL_USER );
+		if ( opt->limit > 0.0 ) {
+			for ( i=0; i<qual.over; i++ ) edit->polSelect( edit->state, (LWPolID)qual.over_id[i], 1 );
+			picked = qual.over;
+		}
+		else {
+			for ( i=0; i<qual.worst_n; i++ ) edit->polSelect( edit->state, (LWPolID)qual.worst[i].id, 1 );
+			picked = qual.worst_n;
+		}
+		csMeshDone( EDERR_NONE, EDSELM_CLEARCURRENT | EDSELM_FORCEPOLS );
+		KMTimerMark( timer, KMT_BUILD );
+	}
+
+	/////////////////////////////////////////////////////
+	// Reports need an OK click, so headless runs skip them
+	/////////////////////////////////////////////////////
+	if ( !opt->given ) {
+		if ( qual.triangles > qual.degenerate )
+			sprintf( line, "%ld triangles: ratio mean %.3g, worst %.3g; %ld degenerate.", qual.triangles,
+				qual.ratio_sum / ( qual.triangles - qual.degenerate ), qual.ratio_max, qual.degenerate );
+		else
+			sprintf( line, "%ld triangles, all degenerate.", qual.triangles );
+		msg->info( line, NULL );
+		if ( opt->select ) {
+			sprintf( line, "Selected %ld triangles.", picked );
+			msg->info( line, NULL );
+		}
+	}
+
+	ppp_qual_free( &qual );
+	return AFUNC_OK;
+}
+
+/*
+======================================================================
+ActivateCurvature()
+
+The activation function of 3PointCircleCurvature.  Checks the circle
+through every three consecutive vertices of the selected polylines.
+====================================================================== */
+XCALL_( int )
+ActivateCurvature( long version, GlobalFunc *global, LWModCommand *local,
+   void *serverData )
+{
+	return KMActivate( version, global, local, KM_MODE_CURVATURE );
+}
+
+/*
+======================================================================
+KMCurvatureCheck()
+
+The curvature check.  Each selected polygon is walked once with
+ppp_curv: curves as open polylines, faces as closed ones.  The report
+has a line per vertex with the radius and center of its window, the
+violations of Min Radius marked; with Select Violations their
+vertices become the point selection.  No geometry is made.
+====================================================================== */
+static int KMCurvatureCheck( LWMessageFuncs *msg, LWXPanelFuncs *xpanf, GlobalFunc *global,
+   LWModCommand *local, KMOptions *opt, KMTimer *timer )
+{
+	char line[ 160 ];
+	KMCurvature curv;
+	EDError err;
+
+	// Get input from XPanel, unless the argument had it
+	if ( !opt->given ) {
+		if ( !get_curvature( xpanf, opt )) return AFUNC_OK;
+		KMRememberOptions( opt );
+	}
+	KMTimerMark( timer, KMT_PANEL );
+
+	if ( opt->minRadius < 0.0 ) {
+		msg->error("Min Radius must be 0 or more.", NULL);
+		return AFUNC_OK;
+	}
+
+	memset( &curv, 0, sizeof(curv) );
+	curv.minRadius = opt->minRadius;
+	curv.select = opt->select;
+	curv.radiusMin = HUGE_VAL;
+	if ( opt->report ) {
+		curv.fp = strcmp( opt->report, "-" ) ? fopen( opt->report, "w" ) : stdout;
+		if ( !curv.fp ) msg->error("Cannot write the report:", opt->report);
+	}
+	if ( curv.fp ) {
+		fprintf( curv.fp, "polyline vertex  radius  center" );
+		if ( opt->minRadius > 0.0 ) fprintf( curv.fp, "  (* under %g)", opt->minRadius );
+		fprintf( curv.fp, "\n" );
+	}
+
+	if ( !csInit( global, local ) ) {
+		if ( curv.fp && curv.fp != stdout ) fclose( curv.fp );
+		return AFUNC_OK;
+	}
+
+	/////////////////////////////////////////////////////
+	// One scan does it all, the violations are selected
+	// as they are found and replace the selection
+	/////////////////////////////////////////////////////
+	curv.edit = csMeshBegin( 0, 0, OPSEL_USER );
+	err = mePolyScan((EDPolyScanFunc *)KMCurveEnum, &curv, OPLYR_FG);
+	if ( curv.select && curv.violations ) csMeshDone( EDERR_NONE, EDSELM_CLEARCURRENT | EDSELM_FORCEVRTS );
+	else csMeshDone( EDERR_NONE, 0 );
+	KMTimerMark( timer, KMT_SOLVE );
+
+	if ( curv.fp && curv.fp != stdout ) fclose( curv.fp );
+
+	if ( err != EDERR_NONE ) {
+		msg->error("The curvature check failed.", NULL);
+		return AFUNC_OK;
+	}
+
+	if ( curv.polylines == 0 ) {
+		msg->error("Please select one or more polylines of 3 or more vertices.", NULL);
+		return AFUNC_OK;
+	}
+
+	/////////////////////////////////////////////////////
+	// Reports need an OK click, so headless runs skip them
+	/////////////////////////////////////////////////////
+	if ( !opt->given ) {
+		if ( curv.radiusMin < HUGE_VAL )
+			sprintf( line, "%ld polylines, %ld vertices: tightest radius %g at %g %g %g.", curv.polylines,
+				curv.vertices, curv.radiusMin, curv.radiusMinAt.x, curv.radiusMinAt.y, curv.radiusMinAt.z );
+		else
+			sprintf( line, "%ld polylines, %ld vertices, all straight.", curv.polylines, curv.vertices );
+		msg->info( line, NULL );
+		if ( opt->minRadius > 0.0 ) {
+			sprintf( line, "%ld vertices under radius %g, %ld of them cusps.", curv.violations,
+				opt->minRadius, curv.cusps );
+			msg->info( line, NULL );
+		}
+	}
+
+	return AFUNC_OK;
+}
+
+/*
+======================================================================
+KMPointEnum()
+
+The callback passed to the MeshEditOp polyScan() function.  For each
+point selected, add its position to the point array.
+======================================================================*/
+
+XCALL_( static EDError )
+KMPointEnum( PointStack *pointcircle, const EDPointInfo *pointInfo ) {
+
+	int i;
+	double *point;
+
+	if ( ( pointInfo->flags & EDDF_SELECT ) != EDDF_SELECT ) return EDERR_NONE;
+
+	if ( !( point = KMPointStackPush( pointcircle ) ) ) return EDERR_NOMEMORY;
+
+	for (i=0; i<3; i++){
+		point[ i ] = pointInfo->position[ i ];
+	}
+
+	return EDERR_NONE;
+}
+
+/*
+======================================================================
+KMPolyEnum()
+
+The callback passed to the MeshEditOp polyScan() function.  For each
+selected triangle, add its three vertex positions to the point array.
+Other polygons are skipped.
+======================================================================*/
+
+XCALL_( static EDError )
+KMPolyEnum( PointStack *pointcircle, const EDPolygonInfo *polyInfo ) {
+
+	int i,j;
+	EDPointInfo *pointInfo;
+	double *point;
+
+	if ( ( polyInfo->flags & EDDF_SELECT ) != EDDF_SELECT ) return EDERR_NONE;
+
+	if ( polyInfo->numPnts != 3) return EDERR_NONE;
+
+	for (i=0; i<3; i++){
+			if ( !( point = KMPointStackPush( pointcircle ) ) ) return EDERR_NOMEMORY;
+			pointInfo = mePointInfo( polyInfo->points[i] );
+			for (j=0; j<3; j++){
+				point[ j ] = pointInfo->position[ j ];
+			}
+	}
+    
+	return EDERR_NONE;
+}
+
+/*
+======================================================================
+KMLayerPointEnum()
+
+The callback passed to the MeshEditOp pointScan() function when
+detecting.  Add every point of the foreground layers to the point
+array.
+======================================================================*/
+
+XCALL_( static EDError )
+KMLayerPointEnum( PointStack *pointcircle, const EDPointInfo *pointInfo ) {
+
+	double *point;
+
+	if ( !( point = KMPointStackPush( pointcircle ) ) ) return EDERR_NOMEMORY;
+
+	VCPY( point, pointInfo->position );
+
+	return EDERR_NONE;
+}
+
+/*
+======================================================================
+KMFitEnum()
+
+The callback passed to the MeshEditOp pointScan() function when more
+than three points are selected.  For each point selected, add it to
+the fit moments.
+======================================================================*/
+
+XCALL_( static EDError )
+KMFitEnum( ppp_fit *fit, const EDPointInfo *pointInfo ) {
+
+	if ( ( pointInfo->flags & EDDF_SELECT ) != EDDF_SELECT ) return EDERR_NONE;
+
+	ppp_fit_add( fit, pointInfo->position );
+
+	return EDERR_NONE;
+}
+
+/*
+======================================================================
+KMRefineEnum()
+
+The callback passed to the MeshEditOp pointScan() function for each
+refinement pass of a fit.
+======================================================================*/
+
+XCALL_( static EDError )
+KMRefineEnum( ppp_fit_refine *refine, const EDPointInfo *pointInfo ) {
+
+	if ( ( pointInfo->flags & EDDF_SELECT ) != EDDF_SELECT ) return EDERR_NONE;
+
+	ppp_fit_refine_add( refine, pointInfo->position );
+
+	return EDERR_NONE;
+}
+
+/*
+======================================================================
+KMQualityEnum()
+
+The callback passed to the MeshEditOp polyScan() function for the
+quality analysis.  Every triangle of the foreground layers goes into
+the analysis; other polygons are skipped.
+======================================================================*/
+
+XCALL_( static EDError )
+KMQualityEnum( ppp_qual *qual, const EDPolygonInfo *polyInfo ) {
+
+	double *p1, *p2, *p3;
+
+	if ( polyInfo->numPnts != 3 ) return EDERR_NONE;
+
+	p1 = mePointInfo( polyInfo->points[0] )->position;
+	p2 = mePointInfo( polyInfo->points[1] )->position;
+	p3 = mePointInfo( polyInfo->points[2] )->position;
+	if ( !ppp_qual_add( qual, p1, p2, p3, polyInfo->pol ) ) return EDERR_NOMEMORY;
+
+	return EDERR_NONE;
+}
+
+/*
+======================================================================
+KMCurveWindow()
+
+One window of the curvature check: report it, and select its vertex
+if it is a violation.
+======================================================================*/
+
+static void KMCurveWindow( KMCurvature *curv, const EDPolygonInfo *polyInfo,
+	const ppp_curv_vertex *w ) {
+
+	if ( curv->fp )
+		fprintf( curv->fp, "%ld %ld %.9g %.9g %.9g %.9g%s\n", curv->polylines, w->index, w->radius,
+			w->center.x, w->center.y, w->center.z, w->violation ? " *" : "" );
+
+	if ( w->violation && curv->select )
+		curv->edit->pntSelect( curv->edit->state, polyInfo->points[ w->index ], 1 );
+}
+
+/*
+======================================================================
+KMCurveEnum()
+
+The callback passed to the MeshEditOp polyScan() function for the
+curvature check.  Walk each selected polygon of 3 or more vertices,
+a curve open and a face closed, and add up its windows.
+======================================================================*/
+
+XCALL_( static EDError )
+KMCurveEnum( KMCurvature *curv, const EDPolygonInfo *polyInfo ) {
+
+	ppp_curv walk;
+	ppp_curv_vertex w[ 2 ];
+	EDPointInfo *pointInfo;
+	int i, n;
+
+	if ( ( polyInfo->flags & EDDF_SELECT ) != EDDF_SELECT ) return EDERR_NONE;
+
+	if ( polyInfo->numPnts < 3 ) return EDERR_NONE;
+
+	ppp_curv_init( &walk, polyInfo->type != LWPOLTYPE_CURV, curv->minRadius );
+	for (i=0; i<polyInfo->numPnts; i++) {
+		pointInfo = mePointInfo( polyInfo->points[i] );
+		if ( ppp_curv_add( &walk, pointInfo->position, &w[0] ) ) KMCurveWindow( curv, polyInfo, &w[0] );
+	}
+	n = ppp_curv_finish( &walk, w );
+	for (i=0; i<n; i++) KMCurveWindow( curv, polyInfo, &w[i] );
+
+	curv->polylines++;
+	curv->vertices += polyInfo->numPnts;
+	curv->straight += walk.straight;
+	curv->cusps += walk.cusps;
+	curv->violations += walk.violations;
+	if ( walk.radius_min < curv->radiusMin ) {
+		curv->radiusMin = walk.radius_min;
+		pointInfo = mePointInfo( polyInfo->points[ walk.radius_min_at ] );
+		curv->radiusMinAt.x = pointInfo->position[0];
+		curv->radiusMinAt.y = pointInfo->position[1];
+		curv->radiusMinAt.z = pointInfo->position[2];
+	}
+
+	return EDERR_NONE;
+}
+
+/*
+======================================================================
+KMParseOptions()
+
+Read the command argument, whitespace or comma separated key=value
+pairs:
+
+   sides=N            number of sides (default 32)
+   tol=D              chord tolerance: each circle gets the fewest
+                      sides keeping its edges within D of the circle
+                      (default 0, off, use sides)
+   minsides=N         bounds on the sides from tol (default 8 and 256)
+   maxsides=N
+   passes=N           fit and detection refinement passes (default 2)
+   shape=arc          open arc from the first point to the third
+                      through the second instead of a ring
+   mode=points        use the point selection, mode=polygons the
+                      polygon selection, mode=detect every point of
+                      the foreground layers (default Modeler's mode,
+                      detect for 3PointCircleDetect), mode=quality
+                      the triangle quality of the foreground layers,
+                      mode=curvature the selected polylines
+   inlier=D           detection: largest distance of a point from its
+                      circle (default 0, 1/1000 of the layer size)
+   support=N          detection: points needed on a circle (default 20)
+   maxradius=D        detection: largest radius (default 0, any that
+                      fits in the layers, looking for the small circles
+                      first)
+   minarc=A           detection: degrees of its circle the inliers
+                      must cover, in 32 bins of 11.25 (default 120)
+   layer=N            output layer (default the next empty layer)
+   worst=N            quality: triangles listed (default 10)
+   limit=D            quality: circumradius / shortest edge counted
+                      as too high (default 0, none)
+   minradius=D        curvature: windows tighter than D are
+                      violations (default 0, none)
+   select=1           quality: select the offenders, those over the
+                      limit or else the worst listed; curvature: the
+                      vertices of the violations (default 0)
+   report=path        quality, curvature: write the report to path,
+                      - for the standard output (default none)
+
+opt->given counts the pairs; with any at all the XPanel is skipped.
+Returns 0 and sets *bad to the offending pair for an unknown key or
+a bad value.
+======================================================================*/
+
+static int KMParseOptions( KMOptions *opt, const char *argument, KMArena *arena, char **bad ) {
+
+	char *args, *token, *value, *end;
+	double t;
+	long n;
+
+	opt->sides = 32;
+	opt->tolerance = 0.0;
+	opt->minSides = 8;
+	opt->maxSides = 256;
+	opt->passes = 2;
+	opt->shape = KM_SHAPE_RING;
+	opt->mode = -1;
+	opt->layer = 0;
+	opt->inlier = 0.0;
+	opt->support = 20;
+	opt->maxRadius = 0.0;
+	opt->minArc = 120.0 * PI / 180.0;
+	opt->worst = 10;
+	opt->limit = 0.0;
+	opt->minRadius = 0.0;
+	opt->select = 0;
+	opt->report = NULL;
+	opt->given = 0;
+	*bad = "";
+
+	if ( !argument || !argument[ 0 ] ) return 1;
+	if ( !( args = KMArenaStrdup( arena, argument ) ) ) return 1;
+
+	for ( token = strtok( args, " \t," ); token; token = strtok( NULL, " \t," ) ) {
+		*bad = token;
+		if ( !( value = strchr( token, '=' ) ) ) return 0;
+		value++;
+
+		if ( !strncmp( token, "mode=", 5 ) ) {
+			if ( !strcmp( value, "points" ) ) opt->mode = 0;
+			else if ( !strcmp( value, "polygons" ) ) opt->mode = 1;
+			else if ( !strcmp( value, "detect" ) ) opt->mode = KM_MODE_DETECT;
+			else if ( !strcmp( value, "quality" ) ) opt->mode = KM_MODE_QUALITY;
+			else if ( !strcmp( value, "curvature" ) ) opt->mode = KM_MODE_CURVATURE;
+			else return 0;
+		}
+		else if ( !strncmp( token, "shape=", 6 ) ) {
+			if ( !strcmp( value, "ring" ) ) opt->shape = KM_SHAPE_RING;
+			else if ( !strcmp( value, "arc" ) ) opt->shape = KM_SHAPE_ARC;
+			else return 0;
+		}
+		else if ( !strncmp( token, "report=", 7 ) ) {
+			if ( !*value ) return 0;
+			opt->report = value;
+		}
+		else if ( !strncmp( token, "minarc=", 7 ) ) {
+			t = strtod( value, &end );
+			if ( end == value || *end || !( t >= 0.0 && t <= 360.0 ) ) return 0;
+			opt->minArc = t * PI / 180.0;
+		}
+		else if ( !strncmp( token, "tol=", 4 ) || !strncmp( token, "inlier=", 7 )
+			|| !strncmp( token, "maxradius=", 10 ) || !strncmp( token, "limit=", 6 )
+			|| !strncmp( token, "minradius=", 10 ) ) {
+			t = strtod( value, &end );
+			if ( end == value || *end || !( t >= 0.0 ) ) return 0;
+			if ( token[ 0 ] == 't' ) opt->tolerance = t;
+			else if ( token[ 0 ] == 'i' ) opt->inlier = t;
+			else if ( token[ 0 ] == 'l' ) opt->limit = t;
+			else if ( token[ 1 ] == 'i' ) opt->minRadius = t;
+			else opt->maxRadius = t;
+		}
+		else {
+			n = strtol( value, &end, 10 );
+			if ( end == value || *end ) return 0;
+
+			if ( !strncmp( token, "sides=", 6 ) ) opt->sides = (int)n;
+			else if ( !strncmp( token, "minsides=", 9 ) ) opt->minSides = (int)n;
+			else if ( !strncmp( token, "maxsides=", 9 ) ) opt->maxSides = (int)n;
+			else if ( !strncmp( token, "passes=", 7 ) ) opt->passes = (int)n;
+			else if ( !strncmp( token, "support=", 8 ) ) opt->support = (int)n;
+			else if ( !strncmp( token, "layer=", 6 ) && n >= 1 ) opt->layer = (int)n;
+			else if ( !strncmp( token, "worst=", 6 ) && n >= 0 ) opt->worst = (int)n;
+			else if ( !strncmp( token, "select=", 7 ) ) opt->select = ( n != 0 );
+			else return 0;
+		}
+		opt->given++;
+	}
+	return 1;
+}
+
+/*
+======================================================================
+KMPointStackInit()
+
+Start an empty point stack with room for capacity points, allocated
+from the arena.  Returns 0 when out of memory.
+======================================================================*/
+
+static int KMPointStackInit( PointStack *stack, KMArena *arena, int capacity ) {
+
+	stack->arena = arena;
+	stack->pointCount = 0;
+	stack->pointCapacity = 0;
+	stack->pointArray = NULL;
+
+	if ( capacity > 0 ) {
+		stack->pointArray = (double (*)[3])KMArenaAlloc( arena, capacity * sizeof(*stack->pointArray) );
+		if ( !stack->pointArray ) return 0;
+		stack->pointCapacity = capacity;
+	}
+	return 1;
+}
+
+/*
+======================================================================
+KMPointStackPush()
+
+Return storage for one more point, doubling the capacity when full.
+The old storage stays in the arena until it is freed.  Returns NULL
+when out of memory.
+======================================================================*/
+
+static double *KMPointStackPush( PointStack *stack ) {
+
+	double (*grown)[3];
+	int capacity;
+
+	if ( stack->pointCount == stack->pointCapacity ) {
+		capacity = stack->pointCapacity ? 2 * stack->pointCapacity : 16;
+		grown = (double (*)[3])KMArenaAlloc( stack->arena, capacity * sizeof(*grown) );
+		if ( !grown ) return NULL;
+		if ( stack->pointCount ) memcpy( grown, stack->pointArray, stack->pointCount * sizeof(*grown) );
+		stack->pointArray = grown;
+		stack->pointCapacity = capacity;
+	}
+	return stack->pointArray[ stack->pointCount++ ];
+}
+
+/*
+======================================================================
+KMSolveTriples()
+
+The circle of each triple of the point stack.  Co-linear triples are
+skipped.  Returns the number of circles.
+======================================================================*/
+
+static int KMSolveTriples( const PointStack *pinfo, KMCircle *circles ) {
+
+	v3_pos v3_points[3];
+	int i, k, circleCount = 0;
+
+	for (k=0; k<pinfo->pointCount/3; k++) {
+		for (i=0; i<3; i++) {
+			v3_points[i].x = pinfo->pointArray[3*k+i][0];
+			v3_points[i].y = pinfo->pointArray[3*k+i][1];
+			v3_points[i].z = pinfo->pointArray[3*k+i][2];
+		}
+
+		if ( ppp_circle3d(&v3_points[0], &v3_points[1], &v3_points[2], &circles[circleCount].center,
+				&circles[circleCount].radius, &circles[circleCount].normal,
+				&circles[circleCount].axisU, &circles[circleCount].axisV) ) {
+			circles[circleCount].triple = 3*k;
+			circleCount++;
+		}
+	}
+	return circleCount;
+}
+
+/*
+======================================================================
+KMCircleSides()
+
+Set the side count of every circle: with a chord tolerance each gets
+its own, otherwise they all get Number of Sides.  Returns the largest,
+the size of a buffer that fits any of the rings.
+======================================================================*/
+
+static int KMCircleSides( KMCircle *circles, int circleCount, const KMOptions *opt ) {
+
+	int k, sides = opt->sides;
+
+	if ( opt->tolerance > 0.0 ) {
+		sides = opt->minSides;
+		for (k=0; k<circleCount; k++) {
+			circles[k].sides = ppp_ring_sides( circles[k].radius, opt->tolerance,
+				opt->minSides, opt->maxSides );
+			if ( circles[k].sides > sides ) sides = circles[k].sides;
+		}
+	}
+	else for (k=0; k<circleCount; k++) circles[k].sides = opt->sides;
+
+	return sides;
+}
+
+/*
+======================================================================
+KMSpecRun()
+
+The panel thread.  Solve the triples and build every ring for the
+values the panel opened with.  Only touches the selection, read only,
+its own malloc'd buffers and the ring table cache of pppring.c;
+spec->ok is set when all of it is done.
+======================================================================*/
+
+static void KMSpecRun( void *arg ) {
+
+	KMSpec *spec = (KMSpec *)arg;
+	const ppp_ring *ring = NULL;
+	long total = 0;
+	int k;
+
+	spec->circles = (KMCircle *)malloc( ( spec->pinfo->pointCount / 3 + 1 ) * sizeof(KMCircle) );
+	if ( !spec->circles ) return;
+	spec->circleCount = KMSolveTriples( spec->pinfo, spec->circles );
+
+	if ( spec->opt.sides < 3 || ( spec->opt.tolerance > 0.0
+		&& ( spec->opt.minSides < 3 || spec->opt.maxSides < spec->opt.minSides ))) return;
+	KMCircleSides( spec->circles, spec->circleCount, &spec->opt );
+
+	spec->first = (long *)malloc( ( spec->circleCount + 1 ) * sizeof(long) );
+	if ( !spec->first ) return;
+	for (k=0; k<spec->circleCount; k++) {
+		spec->first[k] = total;
+		total += spec->circles[k].sides;
+	}
+	spec->first[k] = total;
+
+	spec->ringXYZ = (double (*)[3])malloc( ( total + 1 ) * sizeof(*spec->ringXYZ) );
+	if ( !spec->ringXYZ ) return;
+
+	for (k=0; k<spec->circleCount; k++) {
+		if ( !ring || ring->sides != spec->circles[k].sides ) {
+			if ( !( ring = ppp_ring_table( spec->circles[k].sides ))) return;
+		}
+		ppp_ring_emit( ring, &spec->circles[k].center, spec->circles[k].radius,
+			&spec->circles[k].axisU, &spec->circles[k].axisV, spec->ringXYZ + spec->first[k] );
+	}
+	spec->ok = 1;
+}
+
+/*
+======================================================================
+KMSpecStart()
+
+Start the panel thread on the selection with the panel's opening
+values.  Without a thread nothing is precomputed and the command
+works as before.  The ring table cache of pppring.c is not thread
+safe, so until KMSpecJoin has returned the main thread must not look
+up a ring table with ppp_ring_table.
+======================================================================*/
+
+static void KMSpecStart( KMSpec *spec, const PointStack *pinfo, const KMOptions *opt ) {
+
+	spec->pinfo = pinfo;
+	spec->opt = *opt;
+	spec->ok = 0;
+	spec->running = ppp_thread_start( &spec->thread, KMSpecRun, spec );
+}
+
+/*
+======================================================================
+KMSpecJoin()
+
+Wait for the panel thread, if there is one.
+======================================================================*/
+
+static void KMSpecJoin( KMSpec *spec ) {
+
+	if ( !spec->running ) return;
+	ppp_thread_join( spec->thread );
+	spec->running = 0;
+}
+
+/*
+======================================================================
+KMSpecFree()
+
+Wait for the panel thread and free what it made.
+======================================================================*/
+
+static void KMSpecFree( KMSpec *spec ) {
+
+	KMSpecJoin( spec );
+	free( spec->circles );
+	free( spec->first );
+	free( spec->ringXYZ );
+	spec->circles = NULL;
+	spec->first = NULL;
+	spec->ringXYZ = NULL;
+	spec->ok = 0;
+}
+
+/*
+======================================================================
+KMSpecRings()
+
+Whether the rings of the panel thread can be used as they are: the
+panel was closed with the sides it opened with.
+======================================================================*/
+
+static int KMSpecRings( const KMSpec *spec, const KMOptions *opt ) {
+
+	if ( !spec->ok ) return 0;
+	if ( opt->tolerance != spec->opt.tolerance ) return 0;
+	if ( opt->tolerance > 0.0 )
+		return opt->minSides == spec->opt.minSides && opt->maxSides == spec->opt.maxSides;
+	return opt->sides == spec->opt.sides;
+}
+
+/*
+======================================================================
+KMRecallOptions()
+
+Open the panels with the values last used in them.  What the command
+argument decides, the mode, layer and report, is kept.
+======================================================================*/
+
+static void KMRecallOptions( KMOptions *opt ) {
+
+	KMOptions given = *opt;
+
+	if ( !kmLastValid ) return;
+	*opt = kmLast;
+	opt->mode = given.mode;
+	opt->layer = given.layer;
+	opt->report = given.report;
+	opt->given = given.given;
+}
+
+/*
+======================================================================
+KMRememberOptions()
+
+Keep the values of a panel closed with OK for the next one.
+======================================================================*/
+
+static void KMRememberOptions( const KMOptions *opt ) {
+
+	kmLast = *opt;
+	kmLast.report = NULL;
+	kmLastValid = 1;
+}
+
+/*
+======================================================================
+Server record declarations
+====================================================================== */
+
+ServerRecord ServerDesc[] = {
+   { LWMODCOMMAND_CLASS, "3PointCircle", (ActivateFunc *)Activate },
+   { LWMODCOMMAND_CLASS, "3PointCircleDetect", (ActivateFunc *)ActivateDetect },
+   { LWMODCOMMAND_CLASS, "3PointCircleQuality", (ActivateFunc *)ActivateQuality },
+   { LWMODCOMMAND_CLASS, "3PointCircleCurvature", (ActivateFunc *)ActivateCurvature },
+   { LWMESHEDITTOOL_CLASS, "3PointCircleTool", (ActivateFunc *)ActivateTool },
+   { NULL }
+};
@@ -0,0 +1,45 @@
+/*
+** bench.h
+**
+** Timing and random number helpers shared by the benchmarks.
+*/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/*
+** Function bench_now -- Monotonic wall clock in seconds
+*/
+static double bench_now(void)
+{
+#ifdef _WIN32
+ LARGE_INTEGER freq, count;
+
+ QueryPerformanceFrequency(&freq);
+ QueryPerformanceCounter(&count);
+ return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+ struct timespec ts;
+
+ clock_gettime(CLOCK_MONOTONIC, &ts);
+ return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+/*
+** Function bench_rand -- Uniform double in [lo, hi) from a 64 bit
+**    linear congruential generator, reproducible across platforms
+*/
+static double bench_rand(unsigned long long *state, double lo, double hi)
+{
+ *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+ return lo + (hi - lo) * ((double)(*state >> 11) * (1.0 / 9007199254740992.0));
+}
+
+#endif
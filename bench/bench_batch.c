@@ -0,0 +1,408 @@
+/*
+** bench_batch.c
+**
+** Throughput of ppp_circle_batch against a loop over ppp_circle, for
+** every instruction set the running CPU supports, and of the scalar
+** ppp_circle_closed solver, and of ppp_circle_batch_mt for 1, 2, 4 ...
+** threads up to the processor count.  Also reports the largest
+** deviation from ppp_circle over well conditioned triples, and whether
+** the threaded output matches the single threaded one bit for bit.
+** Then ppp_affine_batch per instruction set against a loop applying a
+** 4 x 4 matrix to one point at a time, and ring emission, for a range
+** of side counts, through a direct loop over the ring table against
+** ppp_affine_batch on it.  Last, ppp_curv_polyline along a polyline
+** through the points against ppp_circle3d on every window.
+**
+** Usage: bench_batch [triples] [repeats]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../pppcir.h"
+#include "../pppthread.h"
+#include "../pppcurv.h"
+#include "../pppring.h"
+#include "bench.h"
+
+#define MIN_SINE 1e-3
+
+/*
+** Function min_sine -- Sine of the smallest angle of a triangle
+*/
+static double min_sine(double ax, double ay, double bx, double by,
+      double cx, double cy)
+{
+ double area2, ab, bc, ca, s, m;
+
+ area2 = fabs((bx - ax) * (cy - ay) - (by - ay) * (cx - ax));
+ ab = sqrt((bx - ax) * (bx - ax) + (by - ay) * (by - ay));
+ bc = sqrt((cx - bx) * (cx - bx) + (cy - by) * (cy - by));
+ ca = sqrt((ax - cx) * (ax - cx) + (ay - cy) * (ay - cy));
+ if ((ab == 0.0) || (bc == 0.0) || (ca == 0.0)) return 0.0;
+ m = area2 / (ab * ca);
+ s = area2 / (ab * bc); if (s < m) m = s;
+ s = area2 / (bc * ca); if (s < m) m = s;
+ return m;
+}
+
+/*
+** Function solve_loop -- Time one ppp_circle_solve call per triple
+**
+** Return value: double
+**  elapsed seconds for all repeats
+*/
+static double solve_loop(int solver, int n, int reps,
+      const double *x1, const double *y1, const double *x2,
+      const double *y2, const double *x3, const double *y3,
+      double *cx, double *cy, double *rad, unsigned char *valid, int *found)
+{
+ int i, r;
+ double t0 = bench_now();
+
+ for (r = 0; r < reps; r++) {
+  *found = 0;
+  for (i = 0; i < n; i++) {
+   v2_pos p1, p2, p3, c;
+
+   p1.x = x1[i]; p1.y = y1[i];
+   p2.x = x2[i]; p2.y = y2[i];
+   p3.x = x3[i]; p3.y = y3[i];
+   valid[i] = (unsigned char)(ppp_circle_solve(solver, &p1, &p2, &p3, &c, &rad[i]) != 0);
+   cx[i] = c.x;
+   cy[i] = c.y;
+   *found += valid[i];
+  }
+ }
+ return bench_now() - t0;
+}
+
+/*
+** Function report -- Print throughput and deviation from the reference
+*/
+static void report(const char *name, double rate, double ref_rate,
+      int found, int n,
+      const double *x1, const double *y1, const double *x2,
+      const double *y2, const double *x3, const double *y3,
+      const double *cx, const double *cy, const double *rad,
+      const unsigned char *valid, const double *rcx, const double *rcy,
+      const double *rrad, const unsigned char *rvalid)
+{
+ int i, mismatch = 0;
+ double dev, maxdev = 0.0;
+
+ for (i = 0; i < n; i++) {
+  if (min_sine(x1[i], y1[i], x2[i], y2[i], x3[i], y3[i]) < MIN_SINE) continue;
+  if (valid[i] != rvalid[i]) {
+   mismatch++;
+   continue;
+  }
+  dev = fabs(cx[i] - rcx[i]) + fabs(cy[i] - rcy[i]) + fabs(rad[i] - rrad[i]);
+  dev /= rrad[i];
+  if (dev > maxdev) maxdev = dev;
+ }
+
+ printf("%-10s %10.2f Mtriples/s  %7.2f ns/triple  found %d/%d  "
+   "speedup %5.2fx  max rel dev %.3g  mismatches %d\n",
+   name, rate * 1e-6, 1e9 / rate, found, n, rate / ref_rate, maxdev, mismatch);
+}
+
+/*
+** Function affine_loop -- One point at a time through a 4 x 4 row
+**    vector matrix, copied in and out, as a Modeler plug-in would with
+**    LWMAT_dtransformp
+*/
+static double affine_loop(int n, int reps, double m4[4][4],
+      const double *x, const double *y, const double *z, double (*xyz)[3])
+{
+ double p[3], t[3];
+ int i, j, r;
+ double t0 = bench_now();
+
+ for (r = 0; r < reps; r++)
+  for (i = 0; i < n; i++) {
+   p[0] = x[i]; p[1] = y[i]; p[2] = z[i];
+   for (j = 0; j < 3; j++)
+    t[j] = p[0] * m4[0][j] + p[1] * m4[1][j] + p[2] * m4[2][j] + m4[3][j];
+   xyz[i][0] = t[0]; xyz[i][1] = t[1]; xyz[i][2] = t[2];
+  }
+ return bench_now() - t0;
+}
+
+/*
+** Function affine_bench -- ppp_affine_batch per instruction set
+*/
+static void affine_bench(int n, int reps, const double *x, const double *y,
+      const double *z)
+{
+ double m[3][4], m4[4][4], (*ref)[3], (*out)[3], t, ref_rate, rate, t0;
+ unsigned long long seed = 99;
+ int isa, best, j, k, r, same;
+
+ ref = (double (*)[3])malloc(2 * (size_t)n * sizeof(*ref));
+ if (!ref) return;
+ out = ref + n;
+
+ for (k = 0; k < 3; k++)
+  for (j = 0; j < 4; j++) m4[j][k] = m[k][j] = bench_rand(&seed, -2.0, 2.0);
+ m4[0][3] = m4[1][3] = m4[2][3] = 0.0;
+ m4[3][3] = 1.0;
+
+ t = affine_loop(n, reps, m4, x, y, z, ref);
+ ref_rate = (double)n * reps / t;
+ printf("%-14s %10.2f Mpoints/s  %7.2f ns/point\n", "4x4 loop", ref_rate * 1e-6, 1e9 / ref_rate);
+
+ ppp_batch_set_isa(PPP_ISA_SCALAR);
+ ppp_affine_batch(n, (const double (*)[4])m, x, y, z, ref);
+
+ ppp_batch_set_isa(PPP_ISA_AUTO);
+ best = ppp_batch_isa();
+ for (isa = PPP_ISA_SCALAR; isa <= best; isa++) {
+  char name[32];
+
+  if (!ppp_batch_set_isa(isa)) continue;
+  t0 = bench_now();
+  for (r = 0; r < reps; r++) ppp_affine_batch(n, (const double (*)[4])m, x, y, z, out);
+  t = bench_now() - t0;
+  rate = (double)n * reps / t;
+  same = !memcmp(out, ref, n * sizeof(*ref));
+  sprintf(name, "affine %s", ppp_batch_isa_name(isa));
+  printf("%-14s %10.2f Mpoints/s  %7.2f ns/point  speedup %5.2fx  same as scalar: %s\n",
+    name, rate * 1e-6, 1e9 / rate, rate / ref_rate, same ? "yes" : "NO");
+ }
+ ppp_batch_set_isa(PPP_ISA_AUTO);
+ free(ref);
+}
+
+/*
+** Function ring_loop -- The ring of each circle through a direct loop
+**    over the table, as ppp_ring_emit does below PPP_RING_BATCH sides
+*/
+static double ring_loop(const ppp_ring *ring, int circles, const double *x,
+      const double *y, const double *z, double (*xyz)[3])
+{
+ double ux, uy, uz, vx, vy, vz;
+ int c, i;
+ double t0 = bench_now();
+
+ for (c = 0; c < circles; c++) {
+  ux = x[c]; uy = y[c]; uz = z[c];
+  vx = y[c]; vy = z[c]; vz = x[c];
+  for (i = 0; i < ring->sides; i++) {
+   xyz[i][0] = x[c] + ring->cosv[i] * ux + ring->sinv[i] * vx;
+   xyz[i][1] = y[c] + ring->cosv[i] * uy + ring->sinv[i] * vy;
+   xyz[i][2] = z[c] + ring->cosv[i] * uz + ring->sinv[i] * vz;
+  }
+ }
+ return bench_now() - t0;
+}
+
+/*
+** Function ring_affine -- The ring of each circle through
+**    ppp_affine_batch on the table
+*/
+static double ring_affine(const ppp_ring *ring, int circles, const double *x,
+      const double *y, const double *z, double (*xyz)[3])
+{
+ double m[3][4];
+ int c;
+ double t0 = bench_now();
+
+ for (c = 0; c < circles; c++) {
+  m[0][0] = x[c]; m[0][1] = y[c]; m[0][2] = 0.0; m[0][3] = x[c];
+  m[1][0] = y[c]; m[1][1] = z[c]; m[1][2] = 0.0; m[1][3] = y[c];
+  m[2][0] = z[c]; m[2][1] = x[c]; m[2][2] = 0.0; m[2][3] = z[c];
+  ppp_affine_batch(ring->sides, (const double (*)[4])m, ring->cosv, ring->sinv, NULL, xyz);
+ }
+ return bench_now() - t0;
+}
+
+/*
+** Function ring_bench -- Ring emission per vertex, direct loop against
+**    ppp_affine_batch per instruction set, from 8 to 1024 sides
+*/
+static void ring_bench(int n, int reps, const double *x, const double *y,
+      const double *z)
+{
+ const ppp_ring *ring;
+ double (*xyz)[3], t, loop_ns;
+ int sides, circles, isa, best;
+
+ xyz = (double (*)[3])malloc(1024 * sizeof(*xyz));
+ if (!xyz) return;
+ best = ppp_batch_isa();
+
+ for (sides = 8; sides <= 1024; sides *= 2) {
+  if (!(ring = ppp_ring_table(sides))) break;
+  circles = (int)(((double)n * reps) / sides);
+  if (circles > n) circles = n;
+  if (circles < 1) circles = 1;
+
+  t = ring_loop(ring, circles, x, y, z, xyz);
+  loop_ns = 1e9 * t / ((double)circles * sides);
+  printf("ring %4d      loop %6.2f ns/vertex", sides, loop_ns);
+  for (isa = PPP_ISA_SCALAR; isa <= best; isa++) {
+   if (!ppp_batch_set_isa(isa)) continue;
+   t = ring_affine(ring, circles, x, y, z, xyz);
+   printf("  %s %6.2f", ppp_batch_isa_name(isa), 1e9 * t / ((double)circles * sides));
+  }
+  printf("\n");
+  ppp_batch_set_isa(PPP_ISA_AUTO);
+ }
+ free(xyz);
+}
+
+/*
+** Function curv_bench -- ppp_curv_polyline against ppp_circle3d on
+**    each window of three consecutive vertices
+*/
+static void curv_bench(int n, int reps, const double *x, const double *y,
+      const double *z)
+{
+ double (*p)[3], *rad, t, t0, ref_rate, rate, dev, maxdev = 0.0;
+ ppp_curv_vertex *out;
+ v3_pos a, b, c, center;
+ v3_vect normal, u, v;
+ int i, r, mismatch = 0;
+
+ p = (double (*)[3])malloc((size_t)n * sizeof(*p));
+ rad = (double *)malloc((size_t)n * sizeof(double));
+ out = (ppp_curv_vertex *)malloc((size_t)n * sizeof(ppp_curv_vertex));
+ if (!p || !rad || !out || (n < 3)) {
+  free(p); free(rad); free(out);
+  return;
+ }
+ for (i = 0; i < n; i++) {
+  p[i][0] = x[i]; p[i][1] = y[i]; p[i][2] = z[i];
+ }
+
+ t0 = bench_now();
+ for (r = 0; r < reps; r++)
+  for (i = 1; i < n - 1; i++) {
+   a.x = p[i - 1][0]; a.y = p[i - 1][1]; a.z = p[i - 1][2];
+   b.x = p[i][0]; b.y = p[i][1]; b.z = p[i][2];
+   c.x = p[i + 1][0]; c.y = p[i + 1][1]; c.z = p[i + 1][2];
+   rad[i] = ppp_circle3d(&a, &b, &c, &center, &rad[i], &normal, &u, &v) ? rad[i] : -1.0;
+  }
+ t = bench_now() - t0;
+ ref_rate = (double)(n - 2) * reps / t;
+ printf("%-14s %10.2f Mwindows/s  %7.2f ns/window\n", "circle3d loop", ref_rate * 1e-6, 1e9 / ref_rate);
+
+ t0 = bench_now();
+ for (r = 0; r < reps; r++) ppp_curv_polyline(n, (const double (*)[3])p, false, 0.0, out);
+ t = bench_now() - t0;
+ rate = (double)(n - 2) * reps / t;
+
+ for (i = 1; i < n - 1; i++) {
+  if ((rad[i] < 0.0) != (out[i].kind != PPP_CURV_OK)) {
+   mismatch++;
+   continue;
+  }
+  if (rad[i] < 0.0) continue;
+  dev = fabs(out[i].radius - rad[i]) / rad[i];
+  if (dev > maxdev) maxdev = dev;
+ }
+ printf("%-14s %10.2f Mwindows/s  %7.2f ns/window  speedup %5.2fx  max rel dev %.3g  mismatches %d\n",
+   "ppp_curv", rate * 1e-6, 1e9 / rate, rate / ref_rate, maxdev, mismatch);
+
+ free(p);
+ free(rad);
+ free(out);
+}
+
+int main(int argc, char **argv)
+{
+ int n = 1000000, reps = 20;
+ int i, r, isa, best, found, ref_found, threads, cpus, same;
+ unsigned long long seed = 12345;
+ double *buf, *x1, *y1, *x2, *y2, *x3, *y3, *cx, *cy, *rad, *rcx, *rcy, *rrad;
+ double *mt;
+ unsigned char *valid, *rvalid, *mvalid;
+ double t0, t, ref_rate;
+
+ if (argc > 1) n = atoi(argv[1]);
+ if (argc > 2) reps = atoi(argv[2]);
+ if ((n <= 0) || (reps <= 0)) {
+  fprintf(stderr, "usage: bench_batch [triples] [repeats]\n");
+  return 1;
+ }
+
+ buf = (double *)malloc(15 * (size_t)n * sizeof(double));
+ valid = (unsigned char *)malloc(3 * (size_t)n);
+ if (!buf || !valid) {
+  fprintf(stderr, "out of memory\n");
+  return 1;
+ }
+ x1 = buf; y1 = x1 + n; x2 = y1 + n; y2 = x2 + n; x3 = y2 + n; y3 = x3 + n;
+ cx = y3 + n; cy = cx + n; rad = cy + n; rcx = rad + n; rcy = rcx + n; rrad = rcy + n;
+ rvalid = valid + n;
+ mt = rrad + n;
+ mvalid = rvalid + n;
+
+ for (i = 0; i < n; i++) {
+  x1[i] = bench_rand(&seed, -100.0, 100.0);
+  y1[i] = bench_rand(&seed, -100.0, 100.0);
+  x2[i] = bench_rand(&seed, -100.0, 100.0);
+  y2[i] = bench_rand(&seed, -100.0, 100.0);
+  x3[i] = bench_rand(&seed, -100.0, 100.0);
+  y3[i] = bench_rand(&seed, -100.0, 100.0);
+ }
+
+ /* reference: one ppp_circle call per triple */
+ t = solve_loop(PPP_SOLVER_REFERENCE, n, reps, x1, y1, x2, y2, x3, y3,
+   rcx, rcy, rrad, rvalid, &ref_found);
+ ref_rate = (double)n * reps / t;
+ printf("%-10s %10.2f Mtriples/s  %7.2f ns/triple  found %d/%d\n",
+   "ppp_circle", ref_rate * 1e-6, 1e9 / ref_rate, ref_found, n);
+
+ /* closed form scalar solver, one call per triple */
+ t = solve_loop(PPP_SOLVER_CLOSED, n, reps, x1, y1, x2, y2, x3, y3,
+   cx, cy, rad, valid, &found);
+ report("closed", (double)n * reps / t, ref_rate, found, n,
+   x1, y1, x2, y2, x3, y3, cx, cy, rad, valid, rcx, rcy, rrad, rvalid);
+
+ best = ppp_batch_isa();
+ for (isa = PPP_ISA_SCALAR; isa <= best; isa++) {
+  if (!ppp_batch_set_isa(isa)) continue;
+
+  found = 0;
+  t0 = bench_now();
+  for (r = 0; r < reps; r++)
+   found = ppp_circle_batch(n, x1, y1, x2, y2, x3, y3, cx, cy, rad, valid);
+  t = bench_now() - t0;
+  report(ppp_batch_isa_name(isa), (double)n * reps / t, ref_rate, found, n,
+    x1, y1, x2, y2, x3, y3, cx, cy, rad, valid, rcx, rcy, rrad, rvalid);
+ }
+ ppp_batch_set_isa(PPP_ISA_AUTO);
+
+ /* threaded, compared bit for bit with the single threaded best kernel */
+ ppp_circle_batch(n, x1, y1, x2, y2, x3, y3, cx, cy, rad, valid);
+ cpus = ppp_cpu_count();
+ for (threads = 1; ; threads *= 2) {
+  char name[32];
+
+  if (threads > cpus) threads = cpus;
+  found = 0;
+  t0 = bench_now();
+  for (r = 0; r < reps; r++)
+   found = ppp_circle_batch_mt(n, x1, y1, x2, y2, x3, y3,
+     mt, mt + n, mt + 2 * n, mvalid, threads);
+  t = bench_now() - t0;
+
+  same = !memcmp(mt, cx, n * sizeof(double)) && !memcmp(mt + n, cy, n * sizeof(double))
+    && !memcmp(mt + 2 * n, rad, n * sizeof(double)) && !memcmp(mvalid, valid, n);
+  sprintf(name, "mt %d", threads);
+  report(name, (double)n * reps / t, ref_rate, found, n,
+    x1, y1, x2, y2, x3, y3, mt, mt + n, mt + 2 * n, mvalid, rcx, rcy, rrad, rvalid);
+  printf("%-10s identical to single threaded: %s\n", "", same ? "yes" : "NO");
+  if (threads == cpus) break;
+ }
+
+ affine_bench(n, reps, x1, y1, x2);
+ ring_bench(n, reps, x1, y1, x2);
+ curv_bench(n, reps, x1, y1, x2);
+
+ free(buf);
+ free(valid);
+ return 0;
+}
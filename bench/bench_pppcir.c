@@ -0,0 +1,405 @@
+/*
+** bench_pppcir.c
+**
+** Per call cost of the pppcir.c math core: ppp_circle, its helpers
+** line_intersect and v2_dist (ppp_line_intersect_d and ppp_v2_dist_d
+** of pppgen.h), and ppp_circle_closed in double and, as
+** ppp_circle_closed_f, in float for comparison,
+** over several input distributions:
+**
+**    random     triangles with vertices uniform in [-100, 100)
+**    axis       right triangles with legs on the grid axes, so the
+**               perpendiculars hit the vertical (d.x == 0) and the
+**               m == 0 branches of line_intersect
+**    collinear  third vertex within 1e-9 of the line through the others,
+**               one in four exactly on it
+**    offset     unit sized triangles 1e6 to 1e9 away from the origin
+**
+** pppcir.c is included directly so the inline helpers are compiled
+** exactly as ppp_circle sees them.
+**
+** For every distribution and function the report gives ns/call, calls/s
+** and the failure rate: calls that returned false ("rejected") and
+** calls that returned a result further than 1e-6 (relative) from the
+** exact answer ("inaccurate"), 1e-3 for float.
+**
+** Built with -DPPP_COUNTERS it also runs ppp_circle once more over
+** each distribution and prints the branch counters (see pppcir.h) as
+** percentages of the calls.
+**
+** Usage: bench_pppcir [triples] [repeats]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../pppcir.c"
+#include "bench.h"
+
+#define TOLERANCE 1e-6
+#define TOLERANCE_F 1e-3
+
+#define DIST_RANDOM    0
+#define DIST_AXIS      1
+#define DIST_COLLINEAR 2
+#define DIST_OFFSET    3
+#define DIST_COUNT     4
+
+static const char *dist_name[DIST_COUNT] = {
+ "random", "axis", "collinear", "offset"
+};
+
+/*
+** Bisector lines of p1p2 and p1p3 as ppp_circle builds them, the input
+** of the line_intersect benchmark.
+*/
+typedef struct BISECTORS
+{
+ v2_pos mp1, mp2;
+ v2_vect d1, d2;
+} bisectors;
+
+/* keeps the timed results alive */
+static volatile double sink;
+
+/*
+** Function make_triples -- Fill p[3 * n] with triples of a distribution
+*/
+static void make_triples(int dist, int n, v2_pos *p, unsigned long long *seed)
+{
+ int i, k;
+
+ for (i = 0; i < n; i++) {
+  v2_pos *t = p + 3 * i;
+
+  switch (dist) {
+  case DIST_AXIS: {
+   double x = floor(bench_rand(seed, -100.0, 100.0));
+   double y = floor(bench_rand(seed, -100.0, 100.0));
+   double w = floor(bench_rand(seed, 1.0, 50.0));
+   double h = floor(bench_rand(seed, 1.0, 50.0));
+   v2_pos q[3];
+
+   q[0].x = x;     q[0].y = y;
+   q[1].x = x + w; q[1].y = y;
+   q[2].x = x;     q[2].y = y + h;
+   /* rotate the vertex order so every branch gets its share */
+   k = i % 3;
+   t[0] = q[k]; t[1] = q[(k + 1) % 3]; t[2] = q[(k + 2) % 3];
+   break;
+  }
+  case DIST_COLLINEAR: {
+   double s = bench_rand(seed, -2.0, 3.0);
+   double e = bench_rand(seed, -1e-9, 1e-9);
+   double dx, dy;
+
+   for (k = 0; k < 2; k++) {
+    t[k].x = bench_rand(seed, -100.0, 100.0);
+    t[k].y = bench_rand(seed, -100.0, 100.0);
+   }
+   /* one in four exactly on the line, on the integer grid */
+   if ((i & 3) == 0) {
+    for (k = 0; k < 2; k++) {
+     t[k].x = floor(t[k].x);
+     t[k].y = floor(t[k].y);
+    }
+    s = (i & 4) ? 2.0 : -1.0;
+    e = 0.0;
+   }
+   dx = t[1].x - t[0].x;
+   dy = t[1].y - t[0].y;
+   t[2].x = t[0].x + s * dx - e * dy;
+   t[2].y = t[0].y + s * dy + e * dx;
+   break;
+  }
+  case DIST_OFFSET: {
+   double r = pow(10.0, bench_rand(seed, 6.0, 9.0));
+   double a = bench_rand(seed, 0.0, 6.283185307179586);
+   double ox = r * cos(a), oy = r * sin(a);
+
+   for (k = 0; k < 3; k++) {
+    t[k].x = ox + bench_rand(seed, -1.0, 1.0);
+    t[k].y = oy + bench_rand(seed, -1.0, 1.0);
+   }
+   break;
+  }
+  default:
+   for (k = 0; k < 3; k++) {
+    t[k].x = bench_rand(seed, -100.0, 100.0);
+    t[k].y = bench_rand(seed, -100.0, 100.0);
+   }
+   break;
+  }
+ }
+}
+
+/*
+** Function make_bisectors -- Build the line_intersect inputs for each
+**    triple the same way ppp_circle does
+*/
+static void make_bisectors(int n, const v2_pos *p, bisectors *b)
+{
+ int i;
+
+ for (i = 0; i < n; i++) {
+  const v2_pos *t = p + 3 * i;
+
+  b[i].d1.y = t[1].x - t[0].x;
+  b[i].d2.y = t[2].x - t[0].x;
+  b[i].d1.x = t[0].y - t[1].y;
+  b[i].d2.x = t[0].y - t[2].y;
+  b[i].mp1.x = (t[0].x + t[1].x) * 0.5;
+  b[i].mp1.y = (t[0].y + t[1].y) * 0.5;
+  b[i].mp2.x = (t[0].x + t[2].x) * 0.5;
+  b[i].mp2.y = (t[0].y + t[2].y) * 0.5;
+ }
+}
+
+/*
+** Function circle_error -- Relative distance of a circle from the three
+**    points it should pass through, evaluated in long double so the
+**    check itself survives the offset distribution
+*/
+static double circle_error(const v2_pos *t, const v2_pos *c, double r)
+{
+ int k;
+ double worst = 0.0;
+
+ if (!(r > 0.0)) return 1.0;
+ for (k = 0; k < 3; k++) {
+  long double dx = (long double)t[k].x - c->x;
+  long double dy = (long double)t[k].y - c->y;
+  double e = fabs((double)(sqrtl(dx * dx + dy * dy) - r)) / r;
+
+  if (!(e <= worst)) worst = e;
+ }
+ return worst;
+}
+
+/*
+** Function line_error -- Distance of ip from both bisector lines,
+**    relative to its distance from the triangle
+*/
+static double line_error(const bisectors *b, const v2_pos *ip)
+{
+ long double e1, e2, l1, l2;
+
+ l1 = sqrtl((long double)b->d1.x * b->d1.x + (long double)b->d1.y * b->d1.y);
+ l2 = sqrtl((long double)b->d2.x * b->d2.x + (long double)b->d2.y * b->d2.y);
+ if ((l1 == 0.0) || (l2 == 0.0)) return 1.0;
+ e1 = ((ip->x - (long double)b->mp1.x) * b->d1.y - (ip->y - (long double)b->mp1.y) * b->d1.x) / l1;
+ e2 = ((ip->x - (long double)b->mp2.x) * b->d2.y - (ip->y - (long double)b->mp2.y) * b->d2.x) / l2;
+ e1 = fabsl(e1) + fabsl(e2);
+ e2 = (l1 > l2 ? l1 : l2) + fabsl(ip->x - (long double)b->mp1.x) + fabsl(ip->y - (long double)b->mp1.y);
+ return (double)(e1 / e2);
+}
+
+/*
+** Function print_row -- One line of the report
+*/
+static void print_row(const char *dist, const char *func, double seconds,
+      long calls, int n, int rejected, int inaccurate)
+{
+ printf("%-10s %-19s %8.2f ns/call %9.2f Mcalls/s  rejected %6.2f%%  inaccurate %6.2f%%\n",
+   dist, func, seconds * 1e9 / calls, calls / seconds * 1e-6,
+   100.0 * rejected / n, 100.0 * inaccurate / n);
+}
+
+/*
+** Function bench_solver -- Time ppp_circle or ppp_circle_closed and
+**    count its failures
+*/
+static void bench_solver(const char *dist, const char *func,
+      int (*solve)(v2_pos *, v2_pos *, v2_pos *, v2_pos *, double *),
+      int n, int reps, v2_pos *p, v2_pos *c, double *r, int *ok)
+{
+ int i, j, rejected = 0, inaccurate = 0;
+ double t0, t, acc = 0.0;
+
+ t0 = bench_now();
+ for (j = 0; j < reps; j++) {
+  for (i = 0; i < n; i++) {
+   ok[i] = solve(p + 3 * i, p + 3 * i + 1, p + 3 * i + 2, c + i, r + i);
+   acc += r[i];
+  }
+ }
+ t = bench_now() - t0;
+ sink = acc;
+
+ for (i = 0; i < n; i++) {
+  if (!ok[i]) rejected++;
+  else if (!(circle_error(p + 3 * i, c + i, r[i]) <= TOLERANCE)) inaccurate++;
+ }
+ print_row(dist, func, t, (long)n * reps, n, rejected, inaccurate);
+}
+
+/*
+** Function bench_float -- Time ppp_circle_closed_f on the triples
+**    rounded to float, checked against those rounded triples
+*/
+static void bench_float(const char *dist, int n, int reps, const v2_pos *p)
+{
+ int i, j, k, rejected = 0, inaccurate = 0;
+ double t0, t, acc = 0.0;
+ v2f_pos *pf, *cf;
+ float *rf;
+ int *okf;
+
+ pf = (v2f_pos *)malloc(3 * (size_t)n * sizeof(v2f_pos));
+ cf = (v2f_pos *)malloc((size_t)n * sizeof(v2f_pos));
+ rf = (float *)malloc((size_t)n * sizeof(float));
+ okf = (int *)malloc((size_t)n * sizeof(int));
+ if (!pf || !cf || !rf || !okf) {
+  free(pf); free(cf); free(rf); free(okf);
+  return;
+ }
+ for (i = 0; i < 3 * n; i++) {
+  pf[i].x = (float)p[i].x;
+  pf[i].y = (float)p[i].y;
+ }
+
+ t0 = bench_now();
+ for (j = 0; j < reps; j++) {
+  for (i = 0; i < n; i++) {
+   okf[i] = ppp_circle_closed_f(pf + 3 * i, pf + 3 * i + 1, pf + 3 * i + 2, cf + i, rf + i);
+   acc += rf[i];
+  }
+ }
+ t = bench_now() - t0;
+ sink = acc;
+
+ for (i = 0; i < n; i++) {
+  v2_pos q[3], c;
+
+  if (!okf[i]) {
+   rejected++;
+   continue;
+  }
+  for (k = 0; k < 3; k++) {
+   q[k].x = pf[3 * i + k].x;
+   q[k].y = pf[3 * i + k].y;
+  }
+  c.x = cf[i].x;
+  c.y = cf[i].y;
+  if (!(circle_error(q, &c, rf[i]) <= TOLERANCE_F)) inaccurate++;
+ }
+ print_row(dist, "ppp_circle_closed_f", t, (long)n * reps, n, rejected, inaccurate);
+
+ free(pf);
+ free(cf);
+ free(rf);
+ free(okf);
+}
+
+/*
+** Function bench_line_intersect -- Time line_intersect on the bisectors
+*/
+static void bench_line_intersect(const char *dist, int n, int reps,
+      bisectors *b, v2_pos *c, int *ok)
+{
+ int i, j, rejected = 0, inaccurate = 0;
+ double t0, t, acc = 0.0;
+
+ t0 = bench_now();
+ for (j = 0; j < reps; j++) {
+  for (i = 0; i < n; i++) {
+   ok[i] = ppp_line_intersect_d(&b[i].mp1, &b[i].mp2, &b[i].d1, &b[i].d2, c + i);
+   acc += c[i].x;
+  }
+ }
+ t = bench_now() - t0;
+ sink = acc;
+
+ for (i = 0; i < n; i++) {
+  if (!ok[i]) rejected++;
+  else if (!(line_error(b + i, c + i) <= TOLERANCE)) inaccurate++;
+ }
+ print_row(dist, "line_intersect", t, (long)n * reps, n, rejected, inaccurate);
+}
+
+/*
+** Function bench_v2_dist -- Time v2_dist from p1 to p2 of every triple
+*/
+static void bench_v2_dist(const char *dist, int n, int reps, v2_pos *p)
+{
+ int i, j;
+ double t0, t, acc = 0.0;
+
+ t0 = bench_now();
+ for (j = 0; j < reps; j++)
+  for (i = 0; i < n; i++)
+   acc += ppp_v2_dist_d(p + 3 * i, p + 3 * i + 1);
+ t = bench_now() - t0;
+ sink = acc;
+
+ print_row(dist, "v2_dist", t, (long)n * reps, n, 0, 0);
+}
+
+#ifdef PPP_COUNTERS
+/*
+** Function print_counters -- Branch counts of one untimed pass of
+**    ppp_circle over the triples
+*/
+static void print_counters(const char *dist, int n, v2_pos *p, v2_pos *c, double *r)
+{
+ ppp_counters counts;
+ int i;
+
+ ppp_counters_reset();
+ for (i = 0; i < n; i++)
+  ppp_circle(p + 3 * i, p + 3 * i + 1, p + 3 * i + 2, c + i, r + i);
+ ppp_counters_thread(&counts);
+
+ printf("%-10s counters  ", dist);
+ for (i = 0; i < PPP_COUNTERS_N; i++)
+  if (counts.n[i]) printf(" %s %.2f%%", ppp_counter_name(i), 100.0 * counts.n[i] / n);
+ printf("\n");
+}
+#endif
+
+int main(int argc, char **argv)
+{
+ int n = 100000, reps = 50;
+ int dist, *ok;
+ unsigned long long seed = 12345;
+ v2_pos *p, *c;
+ bisectors *b;
+ double *r;
+
+ if (argc > 1) n = atoi(argv[1]);
+ if (argc > 2) reps = atoi(argv[2]);
+ if ((n <= 0) || (reps <= 0)) {
+  fprintf(stderr, "usage: bench_pppcir [triples] [repeats]\n");
+  return 1;
+ }
+
+ p = (v2_pos *)malloc(3 * (size_t)n * sizeof(v2_pos));
+ c = (v2_pos *)malloc((size_t)n * sizeof(v2_pos));
+ b = (bisectors *)malloc((size_t)n * sizeof(bisectors));
+ r = (double *)malloc((size_t)n * sizeof(double));
+ ok = (int *)malloc((size_t)n * sizeof(int));
+ if (!p || !c || !b || !r || !ok) {
+  fprintf(stderr, "out of memory\n");
+  return 1;
+ }
+
+ for (dist = 0; dist < DIST_COUNT; dist++) {
+  make_triples(dist, n, p, &seed);
+  make_bisectors(n, p, b);
+
+  bench_solver(dist_name[dist], "ppp_circle", ppp_circle, n, reps, p, c, r, ok);
+  bench_solver(dist_name[dist], "ppp_circle_closed", ppp_circle_closed, n, reps, p, c, r, ok);
+  bench_float(dist_name[dist], n, reps, p);
+  bench_line_intersect(dist_name[dist], n, reps, b, c, ok);
+  bench_v2_dist(dist_name[dist], n, reps, p);
+#ifdef PPP_COUNTERS
+  print_counters(dist_name[dist], n, p, c, r);
+#endif
+ }
+
+ free(p);
+ free(c);
+ free(b);
+ free(r);
+ free(ok);
+ return 0;
+}
@@ -0,0 +1,17 @@
+/*
+======================================================================
+com_math.h
+
+Headless host stand-in for the LightWave SDK common_library header.
+====================================================================== */
+
+#ifndef LWSDK_COM_MATH_H
+#define LWSDK_COM_MATH_H
+
+#include <math.h>
+
+#ifndef PI
+#define PI 3.14159265358979323846
+#endif
+
+#endif
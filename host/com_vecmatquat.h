@@ -0,0 +1,27 @@
+/*
+======================================================================
+com_vecmatquat.h
+
+Headless host stand-in for the LightWave SDK common_library vector
+and matrix routines.  Implemented in lwhost.c.
+====================================================================== */
+
+#ifndef LWSDK_COM_VECMATQUAT_H
+#define LWSDK_COM_VECMATQUAT_H
+
+#include <lwtypes.h>
+
+#define VCPY( a, b )  ( (a)[ 0 ] = (b)[ 0 ], (a)[ 1 ] = (b)[ 1 ], (a)[ 2 ] = (b)[ 2 ] )
+
+extern void   LWMAT_didentity4( LWDMatrix4 m );
+extern void   LWMAT_dcopym4( LWDMatrix4 to, LWDMatrix4 from );
+extern void   LWMAT_dmatmul4( LWDMatrix4 a, LWDMatrix4 b, LWDMatrix4 c );
+extern void   LWMAT_dtransformp( LWDVector a, LWDMatrix4 m, LWDVector b );
+extern void   LWMAT_dinitm4( LWDMatrix4 m,
+                 double a1, double b1, double c1, double d1,
+                 double a2, double b2, double c2, double d2,
+                 double a3, double b3, double c3, double d3,
+                 double a4, double b4, double c4, double d4 );
+extern double LWVEC_dangle( LWDVector a, LWDVector b );
+
+#endif
@@ -0,0 +1,364 @@
+/*
+======================================================================
+hostmain.c
+
+Runs a 3PointCircle ServerDesc entry against the headless host and
+times each invocation.
+
+Usage: 3PointCircle-host [options]
+  -t N         N random triangles in layer 1 (default 1)
+  -f file.obj  load geometry from an OBJ file instead
+  -m mode      selection mode: points, polygons or volume (default
+               polygons)
+  -p N         N points on a random circle in layer 1, all selected,
+               instead of triangles (implies -m points)
+  -k N         N such circles (default 1)
+  -u N         N more points scattered over the circles' box
+  -z           planar scan: the -p circles, of radius 2 to 10, and the
+               -u points in one 100 x 100 square of the z = 0 plane
+  -l N         an open polyline of N vertices in layer 1, selected,
+               winding four times round a wavy loop
+  -e sigma     noise added to the -p points (default 0)
+  -s name      command to run (default the first one, 3PointCircle)
+  -d N         run the MeshEditTool instead: click three points, then
+               drag the last one N steps, timing each redraw
+  -a string    command argument passed to the plug-in
+  -x Label=v   XPanel control override, may be repeated
+  -c           answer the XPanel with Cancel
+  -w ms        keep each XPanel open ms milliseconds, as a user would
+  -r N         number of timed invocations (default 1)
+  -S seed      random seed
+  -o out.obj   write the resulting mesh after the last invocation
+  -q           do not print plug-in messages
+====================================================================== */
+
+#include <lwserver.h>
+#include <lwmodeler.h>
+#include <com_math.h>
+#include <com_vecmatquat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "lwheadless.h"
+#include "../bench/bench.h"
+
+extern ServerRecord ServerDesc[];
+
+static ActivateFunc *findServer( const char *className, const char *name )
+{
+   ServerRecord *rec;
+
+   for ( rec = ServerDesc; rec->className; rec++ )
+      if ( !strcmp( rec->className, className ) && ( !name || !strcmp( rec->name, name )))
+         return rec->activate;
+   return NULL;
+}
+
+static int wireCount[ 2 ];   /* moveTo and lineTo calls */
+
+static void wireMove( void *data, LWFVector v, int type ) { wireCount[ 0 ]++; }
+static void wireLine( void *data, LWFVector v, int type ) { wireCount[ 1 ]++; }
+
+/*
+======================================================================
+toolFrame()
+
+What Modeler does after each mouse event: redraw the tool if it is
+dirty, then act on test(), replacing the previous build on an update.
+Returns the dirty bits.
+====================================================================== */
+static int toolFrame( LWMeshEditTool *tool, LWToolEvent *event, LWWireDrawAccess *draw,
+   int *built, int *builds )
+{
+   int dirty = tool->tool->dirty( tool->instance );
+
+   if ( dirty & LWT_DIRTY_WIREFRAME ) tool->tool->draw( tool->instance, draw );
+   if ( dirty & LWT_DIRTY_HELPTEXT ) tool->tool->help( tool->instance, event );
+
+   switch ( tool->test( tool->instance )) {
+      case LWT_TEST_UPDATE:
+         if ( *built ) hl_edit_undo();
+         tool->build( tool->instance, hl_edit_begin());
+         hl_edit_done();
+         *built = 1;
+         ( *builds )++;
+         break;
+      case LWT_TEST_REJECT:
+         if ( *built ) hl_edit_undo();
+         tool->end( tool->instance, 0 );
+         *built = 0;
+         break;
+      case LWT_TEST_ACCEPT:
+         tool->end( tool->instance, 1 );
+         *built = 0;
+         break;
+   }
+   return dirty;
+}
+
+/*
+======================================================================
+runTool()
+
+Click three random points, drag the third around a small circle for
+steps frames, then one frame without a move, and accept the ring.
+====================================================================== */
+static int runTool( ActivateFunc *activate, int steps, unsigned long long seed )
+{
+   LWToolFuncs funcs;
+   LWMeshEditTool tool;
+   LWToolEvent event;
+   LWWireDrawAccess draw;
+   double p[ 3 ], t, tmin = 1e30, tmax = 0.0, ttotal = 0.0;
+   int built = 0, builds = 0, draws, h, i, k, rc;
+
+   memset( &funcs, 0, sizeof( funcs ));
+   memset( &tool, 0, sizeof( tool ));
+   memset( &event, 0, sizeof( event ));
+   memset( &draw, 0, sizeof( draw ));
+   tool.tool = &funcs;
+   draw.moveTo = wireMove;
+   draw.lineTo = wireLine;
+
+   rc = activate( LWMESHEDITTOOL_VERSION, hl_global, &tool, NULL );
+   if ( rc != AFUNC_OK ) return rc;
+
+   for ( i = 0; i < 3; i++ ) {
+      for ( k = 0; k < 3; k++ )
+         event.posSnap[ k ] = event.posRaw[ k ] = bench_rand( &seed, -100.0, 100.0 );
+      h = funcs.start( tool.instance, &event );
+      funcs.adjust( tool.instance, &event, h );
+      toolFrame( &tool, &event, &draw, &built, &builds );
+   }
+
+   VCPY( p, event.posSnap );
+   for ( i = 0; i < steps; i++ ) {
+      event.posSnap[ 0 ] = p[ 0 ] + 10.0 * cos( 2.0 * PI * ( i + 1 ) / steps );
+      event.posSnap[ 1 ] = p[ 1 ] + 10.0 * sin( 2.0 * PI * ( i + 1 ) / steps );
+      VCPY( event.posRaw, event.posSnap );
+
+      t = bench_now();
+      funcs.adjust( tool.instance, &event, 2 );
+      toolFrame( &tool, &event, &draw, &built, &builds );
+      t = bench_now() - t;
+
+      ttotal += t;
+      if ( t < tmin ) tmin = t;
+      if ( t > tmax ) tmax = t;
+   }
+
+   /* the handle did not move, so neither a redraw nor a build */
+   draws = wireCount[ 0 ];
+   funcs.adjust( tool.instance, &event, 2 );
+   h = toolFrame( &tool, &event, &draw, &built, &builds );
+
+   funcs.event( tool.instance, LWT_EVENT_ACTIVATE );
+   toolFrame( &tool, &event, &draw, &built, &builds );
+   funcs.done( tool.instance );
+
+   printf( "tool steps %d  min %.3f us  mean %.3f us  max %.3f us  redraws %d  builds %d  "
+      "idle %s  points %d  polygons %d\n",
+      steps, tmin * 1e6, steps ? ttotal * 1e6 / steps : 0.0, tmax * 1e6, draws, builds,
+      ( h || wireCount[ 0 ] != draws ) ? "dirty" : "clean", hl_point_count( 0 ), hl_poly_count( 0 ));
+   return AFUNC_OK;
+}
+
+static void buildScene( const char *objFile, int triangles, int selMode,
+   int circlePoints, int circleCount, int outliers, int planar, int polyline, double noise,
+   unsigned long long seed )
+{
+   int i, idx[ 3 ];
+
+   hl_reset();
+   hl_set_mode( selMode );
+
+   if ( polyline > 0 ) {
+      int *chain = malloc( polyline * sizeof( int ));
+
+      for ( i = 0; i < polyline; i++ ) {
+         double a = 8.0 * PI * i / polyline;
+         double r = 20.0 + 6.0 * cos( 5.0 * a );
+
+         chain[ i ] = hl_add_point( 1, r * cos( a ) + noise * bench_rand( &seed, -1.0, 1.0 ),
+            r * sin( a ) + noise * bench_rand( &seed, -1.0, 1.0 ), 0.1 * a, 0 );
+      }
+      hl_add_curve( 1, polyline, chain, 1 );
+      free( chain );
+      return;
+   }
+
+   while ( circlePoints > 0 && circleCount-- > 0 ) {
+      double c[ 3 ], n[ 3 ], u[ 3 ], v[ 3 ], r, len, a, e;
+      int k;
+
+      for ( k = 0; k < 3; k++ ) {
+         c[ k ] = bench_rand( &seed, -100.0, 100.0 );
+         n[ k ] = bench_rand( &seed, -1.0, 1.0 );
+      }
+      r = bench_rand( &seed, 1.0, 50.0 );
+      if ( planar ) {
+         r = bench_rand( &seed, 2.0, 10.0 );
+         c[ 0 ] = bench_rand( &seed, -50.0 + r, 50.0 - r );
+         c[ 1 ] = bench_rand( &seed, -50.0 + r, 50.0 - r );
+         c[ 2 ] = n[ 0 ] = n[ 1 ] = 0.0;
+         n[ 2 ] = 1.0;
+      }
+
+      /* u, v span the plane normal to n */
+      len = sqrt( n[ 0 ] * n[ 0 ] + n[ 1 ] * n[ 1 ] + n[ 2 ] * n[ 2 ] );
+      for ( k = 0; k < 3; k++ ) n[ k ] /= len;
+      u[ 0 ] = n[ 1 ]; u[ 1 ] = -n[ 0 ]; u[ 2 ] = 0.0;
+      len = sqrt( u[ 0 ] * u[ 0 ] + u[ 1 ] * u[ 1 ] );
+      if ( len == 0.0 ) { u[ 0 ] = 1.0; len = 1.0; }
+      for ( k = 0; k < 3; k++ ) u[ k ] /= len;
+      v[ 0 ] = n[ 1 ] * u[ 2 ] - n[ 2 ] * u[ 1 ];
+      v[ 1 ] = n[ 2 ] * u[ 0 ] - n[ 0 ] * u[ 2 ];
+      v[ 2 ] = n[ 0 ] * u[ 1 ] - n[ 1 ] * u[ 0 ];
+
+      for ( i = 0; i < circlePoints; i++ ) {
+         double p[ 3 ];
+
+         a = bench_rand( &seed, 0.0, 2.0 * PI );
+         e = noise * bench_rand( &seed, -1.0, 1.0 );
+         for ( k = 0; k < 3; k++ )
+            p[ k ] = c[ k ] + ( r + e ) * ( cos( a ) * u[ k ] + sin( a ) * v[ k ] )
+               + noise * bench_rand( &seed, -1.0, 1.0 ) * n[ k ];
+         hl_add_point( 1, p[ 0 ], p[ 1 ], p[ 2 ], 1 );
+      }
+   }
+   if ( circlePoints > 0 ) {
+      for ( i = 0; i < outliers; i++ ) {
+         double h = planar ? 50.0 : 150.0;
+         double x = bench_rand( &seed, -h, h );
+         double y = bench_rand( &seed, -h, h );
+
+         hl_add_point( 1, x, y, planar ? 0.0 : bench_rand( &seed, -h, h ), 1 );
+      }
+      return;
+   }
+
+   if ( objFile ) {
+      if ( hl_load_obj( objFile, 1, selMode == 1 ) < 0 ) {
+         fprintf( stderr, "cannot read %s\n", objFile );
+         exit( 1 );
+      }
+   }
+   else {
+      for ( i = 0; i < triangles; i++ ) {
+         double cx = bench_rand( &seed, -100.0, 100.0 );
+         double cy = bench_rand( &seed, -100.0, 100.0 );
+         double cz = bench_rand( &seed, -100.0, 100.0 );
+         int k;
+
+         for ( k = 0; k < 3; k++ )
+            idx[ k ] = hl_add_point( 1, cx + bench_rand( &seed, -1.0, 1.0 ),
+               cy + bench_rand( &seed, -1.0, 1.0 ), cz + bench_rand( &seed, -1.0, 1.0 ), 0 );
+         hl_add_poly( 1, 3, idx, selMode == 1 );
+      }
+   }
+
+   /* point mode works on the first three points */
+   if ( selMode == 0 )
+      for ( i = 0; i < 3; i++ ) hl_select_point( i, 1 );
+}
+
+int main( int argc, char **argv )
+{
+   const char *objFile = NULL, *argument = NULL, *outFile = NULL, *server = NULL;
+   int triangles = 1, selMode = 1, circlePoints = 0, repeats = 1, i, rc = AFUNC_OK;
+   int circleCount = 1, outliers = 0, planar = 0, drags = 0, polyline = 0;
+   double noise = 0.0;
+   unsigned long long seed = 1;
+   double t, tmin = 1e30, ttotal = 0.0;
+   ActivateFunc *activate;
+
+   for ( i = 1; i < argc; i++ ) {
+      const char *a = argv[ i ];
+      const char *v = ( i + 1 < argc ) ? argv[ i + 1 ] : NULL;
+
+      if ( !strcmp( a, "-c" )) { hl_xpanel_ok( 0 ); continue; }
+      if ( !strcmp( a, "-q" )) { hl_quiet( 1 ); continue; }
+      if ( !strcmp( a, "-z" )) { planar = 1; continue; }
+      if ( !v ) {
+         fprintf( stderr, "missing value for %s\n", a );
+         return 2;
+      }
+      if ( !strcmp( a, "-t" )) triangles = atoi( v );
+      else if ( !strcmp( a, "-f" )) objFile = v;
+      else if ( !strcmp( a, "-m" )) {
+         if ( !strcmp( v, "points" )) selMode = 0;
+         else if ( !strcmp( v, "polygons" )) selMode = 1;
+         else if ( !strcmp( v, "volume" )) selMode = 2;
+         else {
+            fprintf( stderr, "unknown selection mode %s\n", v );
+            return 2;
+         }
+      }
+      else if ( !strcmp( a, "-p" )) { circlePoints = atoi( v ); selMode = 0; }
+      else if ( !strcmp( a, "-k" )) circleCount = atoi( v );
+      else if ( !strcmp( a, "-u" )) outliers = atoi( v );
+      else if ( !strcmp( a, "-l" )) polyline = atoi( v );
+      else if ( !strcmp( a, "-e" )) noise = atof( v );
+      else if ( !strcmp( a, "-s" )) server = v;
+      else if ( !strcmp( a, "-d" )) drags = atoi( v );
+      else if ( !strcmp( a, "-a" )) argument = v;
+      else if ( !strcmp( a, "-x" )) hl_xpanel_set( v );
+      else if ( !strcmp( a, "-w" )) hl_xpanel_wait( atoi( v ));
+      else if ( !strcmp( a, "-r" )) repeats = atoi( v );
+      else if ( !strcmp( a, "-S" )) seed = strtoull( v, NULL, 10 );
+      else if ( !strcmp( a, "-o" )) outFile = v;
+      else {
+         fprintf( stderr, "unknown option %s\n", a );
+         return 2;
+      }
+      i++;
+   }
+
+   if ( drags > 0 ) {
+      activate = findServer( LWMESHEDITTOOL_CLASS, server );
+      if ( !activate ) {
+         fprintf( stderr, "no %s server in ServerDesc\n", LWMESHEDITTOOL_CLASS );
+         return 1;
+      }
+      buildScene( objFile, triangles, selMode, circlePoints, circleCount, outliers, planar, polyline,
+         noise, seed );
+      rc = runTool( activate, drags, seed );
+      if ( outFile && !hl_write_obj( outFile )) {
+         fprintf( stderr, "cannot write %s\n", outFile );
+         return 1;
+      }
+      return rc == AFUNC_OK ? 0 : 1;
+   }
+
+   activate = findServer( LWMODCOMMAND_CLASS, server );
+   if ( !activate ) {
+      fprintf( stderr, "no %s server %s in ServerDesc\n", LWMODCOMMAND_CLASS, server ? server : "" );
+      return 1;
+   }
+
+   for ( i = 0; i < repeats; i++ ) {
+      buildScene( objFile, triangles, selMode, circlePoints, circleCount, outliers, planar, polyline,
+         noise, seed );
+
+      t = bench_now();
+      rc = activate( LWMODCOMMAND_VERSION, hl_global, hl_local( argument ), NULL );
+      t = bench_now() - t;
+
+      ttotal += t;
+      if ( t < tmin ) tmin = t;
+      if ( rc != AFUNC_OK ) break;
+   }
+
+   printf( "result %d  invocations %d  min %.3f ms  mean %.3f ms  "
+      "points %d  polygons %d  selected %d  messages %d  panels %d\n",
+      rc, i < repeats ? i + 1 : repeats, tmin * 1e3, ttotal * 1e3 / ( i < repeats ? i + 1 : repeats ),
+      hl_point_count( 0 ), hl_poly_count( 0 ), hl_selected( 0 ), hl_message_count(),
+      hl_xpanel_count());
+
+   if ( outFile && !hl_write_obj( outFile )) {
+      fprintf( stderr, "cannot write %s\n", outFile );
+      return 1;
+   }
+   return rc == AFUNC_OK ? 0 : 1;
+}
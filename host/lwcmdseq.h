@@ -0,0 +1,28 @@
+/*
+======================================================================
+lwcmdseq.h
+
+Headless host stand-in for the LightWave SDK header of the same name.
+====================================================================== */
+
+#ifndef LWSDK_CMDSEQ_H
+#define LWSDK_CMDSEQ_H
+
+#include <lwmeshedt.h>
+
+#define LWMODCOMMAND_CLASS   "CommandSequence"
+#define LWMODCOMMAND_VERSION 2
+
+typedef int LWCommandCode;
+
+typedef struct st_LWModCommand {
+   void           *data;
+   const char     *argument;
+   LWCommandCode (*lookup)( void *, const char *cmdName );
+   int           (*execute)( void *, LWCommandCode cmd, int argc,
+                    const void *argv, EltOpSelect, void *result );
+   MeshEditBegin  *editBegin;
+   int           (*evaluate)( void *, const char *command );
+} LWModCommand;
+
+#endif
@@ -0,0 +1,13 @@
+/*
+======================================================================
+lwcomlib.h
+
+Headless host stand-in for the LightWave SDK common_library.
+====================================================================== */
+
+#ifndef LWSDK_COMLIB_H
+#define LWSDK_COMLIB_H
+
+#include <lwtypes.h>
+
+#endif
@@ -0,0 +1,1071 @@
+/*
+======================================================================
+lwheadless.c
+
+In-memory implementation of the LightWave host services used by
+3PointCircle: LWStateQueryFuncs, LWMessageFuncs, LWXPanelFuncs, the
+LWModCommand evaluate() commands the plug-in issues, the cs* and me*
+modeler_library wrappers and the common_library matrix routines.
+
+Points and polygons live in growable arrays and are never moved, so
+their IDs are simply the array index plus one.  Deleted elements are
+flagged and skipped by every scan.
+====================================================================== */
+
+#include <lwserver.h>
+#include <lwmodeler.h>
+#include <lwxpanel.h>
+#include <lwmodlib.h>
+#include <com_math.h>
+#include <com_vecmatquat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include "lwheadless.h"
+
+typedef struct st_HLPoint {
+   int           layer;
+   int           flags;
+   EDPointInfo   info;
+} HLPoint;
+
+typedef struct st_HLPoly {
+   int           layer;
+   int           flags;
+   unsigned int  type;
+   int           first;
+   int           count;
+   EDPolygonInfo info;
+} HLPoly;
+
+static HLPoint  *pnts;
+static int       npnts, cpnts;
+static HLPoly   *pols;
+static int       npols, cpols;
+static LWPntID  *polPnts;
+static int       npolPnts, cpolPnts;
+
+static int       fgLayer[ HL_MAX_LAYERS + 1 ];
+static int       bgLayer[ HL_MAX_LAYERS + 1 ];
+static int       selMode;
+static int       quiet;
+static int       messages;
+
+static int       sessionOpen;
+static int       sessionPnts, sessionPols, sessionPolPnts;
+static int       sessionPicked;
+
+#define PNT_ID( i )   ( (LWPntID)(intptr_t)( (i) + 1 ) )
+#define PNT_IDX( id ) ( (int)(intptr_t)( id ) - 1 )
+#define POL_ID( i )   ( (LWPolID)(intptr_t)( (i) + 1 ) )
+#define POL_IDX( id ) ( (int)(intptr_t)( id ) - 1 )
+
+/* elements selected in the open session, for EDSELM_CLEARCURRENT */
+#define HL_DF_PICKED  (1<<8)
+
+static void *grow( void *array, int *cap, int need, size_t size )
+{
+   int ncap = *cap ? *cap : 256;
+   void *p;
+
+   if ( need <= *cap ) return array;
+   while ( ncap < need ) ncap *= 2;
+   p = realloc( array, ncap * size );
+   if ( !p ) {
+      fprintf( stderr, "lwheadless: out of memory\n" );
+      exit( 1 );
+   }
+   *cap = ncap;
+   return p;
+}
+
+static int primaryLayer( void )
+{
+   int i;
+
+   for ( i = 1; i <= HL_MAX_LAYERS; i++ )
+      if ( fgLayer[ i ] ) return i;
+   return 1;
+}
+
+static int inLayers( int layer, EltOpLayer ol )
+{
+   switch ( ol ) {
+      case OPLYR_PRIMARY:  return layer == primaryLayer();
+      case OPLYR_FG:
+      case OPLYR_SELECT:   return fgLayer[ layer ];
+      case OPLYR_BG:       return bgLayer[ layer ];
+      default:             return 1;
+   }
+}
+
+/*
+======================================================================
+Scene setup
+====================================================================== */
+
+void hl_reset( void )
+{
+   npnts = npols = npolPnts = 0;
+   memset( fgLayer, 0, sizeof( fgLayer ));
+   memset( bgLayer, 0, sizeof( bgLayer ));
+   fgLayer[ 1 ] = 1;
+   selMode = 0;
+   sessionOpen = 0;
+}
+
+int hl_add_point( int layer, double x, double y, double z, int select )
+{
+   HLPoint *p;
+
+   pnts = grow( pnts, &cpnts, npnts + 1, sizeof( HLPoint ));
+   p = &pnts[ npnts ];
+   memset( p, 0, sizeof( *p ));
+   p->layer = layer;
+   p->flags = select ? EDDF_SELECT : 0;
+   p->info.position[ 0 ] = x;
+   p->info.position[ 1 ] = y;
+   p->info.position[ 2 ] = z;
+   return npnts++;
+}
+
+int hl_add_poly( int layer, int numPnts, const int *points, int select )
+{
+   HLPoly *p;
+   int i;
+
+   pols = grow( pols, &cpols, npols + 1, sizeof( HLPoly ));
+   polPnts = grow( polPnts, &cpolPnts, npolPnts + numPnts, sizeof( LWPntID ));
+   p = &pols[ npols ];
+   memset( p, 0, sizeof( *p ));
+   p->layer = layer;
+   p->flags = select ? EDDF_SELECT : 0;
+   p->type = LWPOLTYPE_FACE;
+   p->first = npolPnts;
+   p->count = numPnts;
+   for ( i = 0; i < numPnts; i++ )
+      polPnts[ npolPnts++ ] = PNT_ID( points[ i ] );
+   return npols++;
+}
+
+int hl_add_curve( int layer, int numPnts, const int *points, int select )
+{
+   int pol = hl_add_poly( layer, numPnts, points, select );
+
+   pols[ pol ].type = LWPOLTYPE_CURV;
+   return pol;
+}
+
+void hl_select_point( int index, int select )
+{
+   if ( index < 0 || index >= npnts ) return;
+   if ( select ) pnts[ index ].flags |= EDDF_SELECT; else pnts[ index ].flags &= ~EDDF_SELECT;
+}
+
+void hl_set_mode( int selmode )
+{
+   selMode = selmode;
+}
+
+static void parseLayers( const char *list, int *set )
+{
+   const char *s = list;
+   int n;
+
+   memset( set, 0, ( HL_MAX_LAYERS + 1 ) * sizeof( int ));
+   while ( s && *s ) {
+      while ( *s && !isdigit( (unsigned char)*s )) s++;
+      if ( !*s ) break;
+      n = atoi( s );
+      if ( n >= 1 && n <= HL_MAX_LAYERS ) set[ n ] = 1;
+      while ( isdigit( (unsigned char)*s )) s++;
+   }
+}
+
+void hl_set_layers( const char *fg, const char *bg )
+{
+   if ( fg ) parseLayers( fg, fgLayer );
+   if ( bg ) parseLayers( bg, bgLayer );
+}
+
+int hl_load_obj( const char *path, int layer, int select )
+{
+   FILE *fp;
+   char line[ 1024 ];
+   int base = npnts, count = 0;
+
+   fp = fopen( path, "r" );
+   if ( !fp ) return -1;
+
+   while ( fgets( line, sizeof( line ), fp )) {
+      if ( line[ 0 ] == 'v' && line[ 1 ] == ' ' ) {
+         double x, y, z;
+
+         if ( sscanf( line + 2, "%lf %lf %lf", &x, &y, &z ) == 3 )
+            hl_add_point( layer, x, y, z, 0 );
+      }
+      else if (( line[ 0 ] == 'f' || line[ 0 ] == 'l' ) && line[ 1 ] == ' ' ) {
+         int idx[ 256 ], n = 0;
+         char *s = line + 2, *end;
+
+         while ( n < 256 ) {
+            long v = strtol( s, &end, 10 );
+            if ( end == s ) break;
+            idx[ n++ ] = base + (int)v - 1;
+            s = end;
+            while ( *s && !isspace( (unsigned char)*s )) s++;   /* skip /vt/vn */
+         }
+         if ( n >= 1 ) {
+            if ( line[ 0 ] == 'l' ) hl_add_curve( layer, n, idx, select );
+            else hl_add_poly( layer, n, idx, select );
+            count++;
+         }
+      }
+   }
+   fclose( fp );
+   return count;
+}
+
+int hl_write_obj( const char *path )
+{
+   FILE *fp;
+   int *index, i, j, n = 0;
+
+   fp = fopen( path, "w" );
+   if ( !fp ) return 0;
+
+   index = malloc(( npnts + 1 ) * sizeof( int ));
+   for ( i = 0; i < npnts; i++ ) {
+      if ( pnts[ i ].flags & EDDF_DELETE ) continue;
+      index[ i ] = ++n;
+      fprintf( fp, "v %.17g %.17g %.17g\n", pnts[ i ].info.position[ 0 ],
+         pnts[ i ].info.position[ 1 ], pnts[ i ].info.position[ 2 ] );
+   }
+   for ( i = 0; i < npols; i++ ) {
+      if ( pols[ i ].flags & EDDF_DELETE ) continue;
+      fprintf( fp, pols[ i ].count > 2 && pols[ i ].type == LWPOLTYPE_FACE ? "f" : "l" );
+      for ( j = 0; j < pols[ i ].count; j++ )
+         fprintf( fp, " %d", index[ PNT_IDX( polPnts[ pols[ i ].first + j ] ) ] );
+      fprintf( fp, "\n" );
+   }
+   free( index );
+   fclose( fp );
+   return 1;
+}
+
+int hl_point_count( int layer )
+{
+   int i, n = 0;
+
+   for ( i = 0; i < npnts; i++ )
+      if ( !( pnts[ i ].flags & EDDF_DELETE ) && ( !layer || pnts[ i ].layer == layer )) n++;
+   return n;
+}
+
+int hl_poly_count( int layer )
+{
+   int i, n = 0;
+
+   for ( i = 0; i < npols; i++ )
+      if ( !( pols[ i ].flags & EDDF_DELETE ) && ( !layer || pols[ i ].layer == layer )) n++;
+   return n;
+}
+
+int hl_selected( int layer )
+{
+   int i, n = 0;
+
+   if ( selMode == 0 ) {
+      for ( i = 0; i < npnts; i++ )
+         if ( !( pnts[ i ].flags & EDDF_DELETE ) && ( pnts[ i ].flags & EDDF_SELECT )
+            && ( !layer || pnts[ i ].layer == layer )) n++;
+      return n;
+   }
+   for ( i = 0; i < npols; i++ )
+      if ( !( pols[ i ].flags & EDDF_DELETE ) && ( pols[ i ].flags & EDDF_SELECT )
+         && ( !layer || pols[ i ].layer == layer )) n++;
+   return n;
+}
+
+int hl_message_count( void )
+{
+   return messages;
+}
+
+void hl_quiet( int q )
+{
+   quiet = q;
+}
+
+/*
+======================================================================
+LWMessageFuncs
+====================================================================== */
+
+static void msgPrint( const char *kind, const char *a, const char *b )
+{
+   messages++;
+   if ( quiet ) return;
+   fprintf( stderr, "[%s] %s%s%s\n", kind, a ? a : "", b ? " " : "", b ? b : "" );
+}
+
+static void msgInfo( const char *a, const char *b )    { msgPrint( "info", a, b ); }
+static void msgError( const char *a, const char *b )   { msgPrint( "error", a, b ); }
+static void msgWarning( const char *a, const char *b ) { msgPrint( "warning", a, b ); }
+static int  msgAsk( const char *t, const char *a, const char *b ) { msgPrint( "ask", a, b ); return 1; }
+
+static LWMessageFuncs messageFuncs = {
+   msgInfo, msgError, msgWarning, msgAsk, msgAsk, msgAsk, msgAsk
+};
+
+/*
+======================================================================
+LWStateQueryFuncs
+====================================================================== */
+
+static int qNumLayers( void )
+{
+   return HL_MAX_LAYERS;
+}
+
+static int layerUsed( int layer )
+{
+   int i;
+
+   for ( i = 0; i < npnts; i++ )
+      if ( pnts[ i ].layer == layer && !( pnts[ i ].flags & EDDF_DELETE )) return 1;
+   for ( i = 0; i < npols; i++ )
+      if ( pols[ i ].layer == layer && !( pols[ i ].flags & EDDF_DELETE )) return 1;
+   return 0;
+}
+
+static unsigned int qLayerMask( EltOpLayer ol )
+{
+   unsigned int mask = 0;
+   int i;
+
+   for ( i = 1; i <= 32; i++ )
+      if ( inLayers( i, ol )) mask |= 1u << ( i - 1 );
+   return mask;
+}
+
+static const char *qSurface( void )
+{
+   return "Default";
+}
+
+static unsigned int qBBox( EltOpLayer ol, double *minmax )
+{
+   unsigned int n = 0;
+   int i, j;
+
+   for ( i = 0; i < npnts; i++ ) {
+      if (( pnts[ i ].flags & EDDF_DELETE ) || !inLayers( pnts[ i ].layer, ol )) continue;
+      for ( j = 0; j < 3; j++ ) {
+         double v = pnts[ i ].info.position[ j ];
+         if ( !n || v < minmax[ j * 2 ] ) minmax[ j * 2 ] = v;
+         if ( !n || v > minmax[ j * 2 + 1 ] ) minmax[ j * 2 + 1 ] = v;
+      }
+      n++;
+   }
+   return n;
+}
+
+static const char *qLayerList( EltOpLayer ol, const char *obj )
+{
+   static char buf[ HL_MAX_LAYERS * 4 ];
+   int i, use;
+
+   buf[ 0 ] = 0;
+   for ( i = 1; i <= HL_MAX_LAYERS; i++ ) {
+      switch ( ol ) {
+         case OPLYR_NONEMPTY: use = layerUsed( i ); break;
+         case OPLYR_EMPTY:    use = !layerUsed( i ); break;
+         default:             use = inLayers( i, ol ); break;
+      }
+      if ( !use ) continue;
+      sprintf( buf + strlen( buf ), "%s%d", buf[ 0 ] ? " " : "", i );
+   }
+   return buf;
+}
+
+static const char *qObject( void )
+{
+   return "Unnamed";
+}
+
+static int qMode( int setting )
+{
+   return setting == LWM_MODE_SELECTION ? selMode : 0;
+}
+
+static LWStateQueryFuncs queryFuncs = {
+   qNumLayers, qLayerMask, qSurface, qBBox, qLayerList, qObject, qMode
+};
+
+/*
+======================================================================
+LWXPanelFuncs
+
+Forms only.  Values are kept per control ID; post() applies any
+"Label=value" overrides registered with hl_xpanel_set(), waits the
+think time set with hl_xpanel_wait() and returns the answer set with
+hl_xpanel_ok().
+====================================================================== */
+
+#define XP_MAX_CTL 32
+#define XP_MAX_SET 32
+
+typedef struct st_LWXPanel {
+   int           n;
+   unsigned long cid[ XP_MAX_CTL ];
+   char          label[ XP_MAX_CTL ][ 64 ];
+   char          type[ XP_MAX_CTL ][ 32 ];
+   int           ival[ XP_MAX_CTL ];
+   double        dval[ XP_MAX_CTL ];
+   char          sval[ XP_MAX_CTL ][ 256 ];
+} HLPanel;
+
+static int  xpOk = 1;
+static char xpSet[ XP_MAX_SET ][ 320 ];
+static int  xpNumSet;
+static int  xpPosts;
+static int  xpWait;
+
+void hl_xpanel_ok( int ok )
+{
+   xpOk = ok;
+}
+
+void hl_xpanel_wait( int ms )
+{
+   xpWait = ms > 0 ? ms : 0;
+}
+
+int hl_xpanel_count( void )
+{
+   return xpPosts;
+}
+
+int hl_xpanel_set( const char *assignment )
+{
+   if ( xpNumSet >= XP_MAX_SET || !strchr( assignment, '=' )) return 0;
+   strncpy( xpSet[ xpNumSet ], assignment, sizeof( xpSet[ 0 ] ) - 1 );
+   xpNumSet++;
+   return 1;
+}
+
+static int xpFind( HLPanel *p, unsigned long cid )
+{
+   int i;
+
+   for ( i = 0; i < p->n; i++ )
+      if ( p->cid[ i ] == cid ) return i;
+   return -1;
+}
+
+static int xpIsFloat( const char *type )
+{
+   return !strcmp( type, "float" ) || !strcmp( type, "distance" )
+      || !strcmp( type, "percent" ) || !strcmp( type, "angle" );
+}
+
+static int xpIsString( const char *type )
+{
+   return !strncmp( type, "s", 1 ) || !strcmp( type, "string" );
+}
+
+static LWXPanelID xpCreate( int type, LWXPanelControl *ctl )
+{
+   HLPanel *p;
+
+   if ( type != LWXP_FORM ) return NULL;
+   p = calloc( 1, sizeof( HLPanel ));
+   if ( !p ) return NULL;
+   for ( ; ctl->cid && p->n < XP_MAX_CTL; ctl++, p->n++ ) {
+      p->cid[ p->n ] = ctl->cid;
+      strncpy( p->label[ p->n ], ctl->label, sizeof( p->label[ 0 ] ) - 1 );
+      strncpy( p->type[ p->n ], ctl->ctrlclass, sizeof( p->type[ 0 ] ) - 1 );
+   }
+   return p;
+}
+
+static void xpDestroy( LWXPanelID panel )
+{
+   free( panel );
+}
+
+static void xpDescribe( LWXPanelID panel, LWXPanelDataDesc *data,
+   LWXPanelGetFunc *get, LWXPanelSetFunc *set )
+{
+}
+
+static void xpHint( LWXPanelID panel, unsigned long id, LWXPanelHint *hints )
+{
+}
+
+static void *xpFormGet( LWXPanelID panel, unsigned long vid )
+{
+   HLPanel *p = panel;
+   int i = xpFind( p, vid );
+
+   if ( i < 0 ) return NULL;
+   if ( xpIsFloat( p->type[ i ] )) return &p->dval[ i ];
+   if ( xpIsString( p->type[ i ] )) return p->sval[ i ];
+   return &p->ival[ i ];
+}
+
+static void xpFormSet( LWXPanelID panel, unsigned long vid, void *value )
+{
+   HLPanel *p = panel;
+   int i = xpFind( p, vid );
+
+   if ( i < 0 || !value ) return;
+   if ( xpIsFloat( p->type[ i ] )) p->dval[ i ] = *(double *)value;
+   else if ( xpIsString( p->type[ i ] )) strncpy( p->sval[ i ], value, sizeof( p->sval[ 0 ] ) - 1 );
+   else p->ival[ i ] = *(int *)value;
+}
+
+static int xpPost( LWXPanelID panel )
+{
+   HLPanel *p = panel;
+   int i, j;
+
+   xpPosts++;
+   if ( xpWait ) {
+      struct timespec ts;
+
+      ts.tv_sec = xpWait / 1000;
+      ts.tv_nsec = ( xpWait % 1000 ) * 1000000L;
+      nanosleep( &ts, NULL );
+   }
+   for ( j = 0; j < xpNumSet; j++ ) {
+      const char *eq = strchr( xpSet[ j ], '=' );
+      size_t len = eq - xpSet[ j ];
+
+      for ( i = 0; i < p->n; i++ ) {
+         if ( strlen( p->label[ i ] ) != len || strncmp( p->label[ i ], xpSet[ j ], len )) continue;
+         if ( xpIsFloat( p->type[ i ] )) p->dval[ i ] = atof( eq + 1 );
+         else if ( xpIsString( p->type[ i ] )) strncpy( p->sval[ i ], eq + 1, sizeof( p->sval[ 0 ] ) - 1 );
+         else p->ival[ i ] = atoi( eq + 1 );
+      }
+   }
+   return xpOk;
+}
+
+static LWXPanelFuncs xpanelFuncs = {
+   1, xpCreate, xpDestroy, xpDescribe, xpHint, NULL, NULL,
+   xpFormGet, xpFormSet, NULL, NULL, xpPost, xpPost
+};
+
+/*
+======================================================================
+GlobalFunc
+====================================================================== */
+
+void *hl_global( const char *serviceName, int useMode )
+{
+   if ( !strcmp( serviceName, LWSTATEQUERYFUNCS_GLOBAL )) return &queryFuncs;
+   if ( !strcmp( serviceName, LWMESSAGEFUNCS_GLOBAL )) return &messageFuncs;
+   if ( !strcmp( serviceName, LWXPANELFUNCS_GLOBAL )) return &xpanelFuncs;
+   return NULL;
+}
+
+/*
+======================================================================
+MeshEditOp
+====================================================================== */
+
+static int countPoints( EltOpLayer ol, int mode )
+{
+   int i, n = 0;
+
+   for ( i = 0; i < npnts; i++ ) {
+      HLPoint *p = &pnts[ i ];
+
+      if ( !inLayers( p->layer, ol )) continue;
+      if ( mode == EDCOUNT_DELETE ? !( p->flags & EDDF_DELETE ) : ( p->flags & EDDF_DELETE )) continue;
+      if ( mode == EDCOUNT_SELECT && !( p->flags & EDDF_SELECT )) continue;
+      n++;
+   }
+   return n;
+}
+
+static int countPolys( EltOpLayer ol, int mode )
+{
+   int i, n = 0;
+
+   for ( i = 0; i < npols; i++ ) {
+      HLPoly *p = &pols[ i ];
+
+      if ( !inLayers( p->layer, ol )) continue;
+      if ( mode == EDCOUNT_DELETE ? !( p->flags & EDDF_DELETE ) : ( p->flags & EDDF_DELETE )) continue;
+      if ( mode == EDCOUNT_SELECT && !( p->flags & EDDF_SELECT )) continue;
+      n++;
+   }
+   return n;
+}
+
+static EDPointInfo *pointInfo( LWPntID id )
+{
+   int i = PNT_IDX( id );
+   HLPoint *p;
+
+   if ( i < 0 || i >= npnts ) return NULL;
+   p = &pnts[ i ];
+   p->info.pnt = id;
+   p->info.layer = p->layer;
+   p->info.flags = p->flags;
+   return &p->info;
+}
+
+static EDPolygonInfo *polyInfo( LWPolID id )
+{
+   int i = POL_IDX( id );
+   HLPoly *p;
+
+   if ( i < 0 || i >= npols ) return NULL;
+   p = &pols[ i ];
+   p->info.pol = id;
+   p->info.layer = p->layer;
+   p->info.flags = p->flags;
+   p->info.numPnts = p->count;
+   p->info.points = polPnts + p->first;
+   p->info.surface = "Default";
+   p->info.type = p->type;
+   return &p->info;
+}
+
+static EDError scanPoints( EDPointScanFunc *func, void *data, EltOpLayer ol )
+{
+   int i, n = npnts;   /* points added during the scan are not visited */
+   EDError err;
+
+   for ( i = 0; i < n; i++ ) {
+      if (( pnts[ i ].flags & EDDF_DELETE ) || !inLayers( pnts[ i ].layer, ol )) continue;
+      if (( err = func( data, pointInfo( PNT_ID( i ))))) return err;
+   }
+   return EDERR_NONE;
+}
+
+static EDError scanPolys( EDPolyScanFunc *func, void *data, EltOpLayer ol )
+{
+   int i, n = npols;
+   EDError err;
+
+   for ( i = 0; i < n; i++ ) {
+      if (( pols[ i ].flags & EDDF_DELETE ) || !inLayers( pols[ i ].layer, ol )) continue;
+      if (( err = func( data, polyInfo( POL_ID( i ))))) return err;
+   }
+   return EDERR_NONE;
+}
+
+static LWPntID addPoint( double *xyz )
+{
+   return PNT_ID( hl_add_point( primaryLayer(), xyz[ 0 ], xyz[ 1 ], xyz[ 2 ], 0 ));
+}
+
+static LWPolID addFace( const char *surf, int numPnt, const LWPntID *ids )
+{
+   int stackIdx[ 64 ], *idx = stackIdx, i, pol;
+
+   if ( numPnt <= 0 ) return NULL;
+   if ( numPnt > 64 ) idx = malloc( numPnt * sizeof( int ));
+   for ( i = 0; i < numPnt; i++ ) idx[ i ] = PNT_IDX( ids[ i ] );
+   pol = hl_add_poly( primaryLayer(), numPnt, idx, 0 );
+   if ( idx != stackIdx ) free( idx );
+   return POL_ID( pol );
+}
+
+static void opDone( EDStateRef s, EDError err, int selm )          { csMeshDone( err, selm ); }
+static int opPointCount( EDStateRef s, EltOpLayer ol, int mode )   { return countPoints( ol, mode ); }
+static int opPolyCount( EDStateRef s, EltOpLayer ol, int mode )    { return countPolys( ol, mode ); }
+static EDError opPointScan( EDStateRef s, EDPointScanFunc *f, void *d, EltOpLayer ol ) { return scanPoints( f, d, ol ); }
+static EDError opPolyScan( EDStateRef s, EDPolyScanFunc *f, void *d, EltOpLayer ol )   { return scanPolys( f, d, ol ); }
+static EDPointInfo *opPointInfo( EDStateRef s, LWPntID id )        { return pointInfo( id ); }
+static EDPolygonInfo *opPolyInfo( EDStateRef s, LWPolID id )       { return polyInfo( id ); }
+static LWPntID opAddPoint( EDStateRef s, double *xyz )             { return addPoint( xyz ); }
+static LWPolID opAddFace( EDStateRef s, const char *surf, int n, const LWPntID *p ) { return addFace( surf, n, p ); }
+
+static EDError opRemPoint( EDStateRef s, LWPntID id )
+{
+   int i = PNT_IDX( id );
+
+   if ( i < 0 || i >= npnts ) return EDERR_BADARGS;
+   pnts[ i ].flags |= EDDF_DELETE;
+   return EDERR_NONE;
+}
+
+static EDError opRemPoly( EDStateRef s, LWPolID id )
+{
+   int i = POL_IDX( id );
+
+   if ( i < 0 || i >= npols ) return EDERR_BADARGS;
+   pols[ i ].flags |= EDDF_DELETE;
+   return EDERR_NONE;
+}
+
+static EDError opPntMove( EDStateRef s, LWPntID id, const double *pos )
+{
+   int i = PNT_IDX( id );
+
+   if ( i < 0 || i >= npnts ) return EDERR_BADARGS;
+   memcpy( pnts[ i ].info.position, pos, 3 * sizeof( double ));
+   return EDERR_NONE;
+}
+
+static EDError opPntSelect( EDStateRef s, LWPntID id, int set )
+{
+   int i = PNT_IDX( id );
+
+   if ( i < 0 || i >= npnts ) return EDERR_BADARGS;
+   if ( set ) pnts[ i ].flags |= EDDF_SELECT | HL_DF_PICKED; else pnts[ i ].flags &= ~EDDF_SELECT;
+   sessionPicked = 1;
+   return EDERR_NONE;
+}
+
+static EDError opPolSelect( EDStateRef s, LWPolID id, int set )
+{
+   int i = POL_IDX( id );
+
+   if ( i < 0 || i >= npols ) return EDERR_BADARGS;
+   if ( set ) pols[ i ].flags |= EDDF_SELECT | HL_DF_PICKED; else pols[ i ].flags &= ~EDDF_SELECT;
+   sessionPicked = 1;
+   return EDERR_NONE;
+}
+
+static MeshEditOp editOp = {
+   NULL, 1, opDone, opPointCount, opPolyCount, opPointScan, opPolyScan,
+   opPointInfo, opPolyInfo, opAddPoint, opAddFace, opRemPoint, opRemPoly,
+   opPntMove, opPntSelect, opPolSelect
+};
+
+static MeshEditOp *editBegin( int pntBuf, int polBuf, EltOpSelect sel )
+{
+   sessionOpen = 1;
+   sessionPnts = npnts;
+   sessionPols = npols;
+   sessionPolPnts = npolPnts;
+   editOp.layerNum = primaryLayer();
+   return &editOp;
+}
+
+/*
+======================================================================
+MeshEditTool builds
+
+Modeler undoes a tool's last build before the next one, and keeps
+the last one when the tool is dropped.  hl_edit_undo() takes back the
+most recent session.
+====================================================================== */
+
+MeshEditOp *hl_edit_begin( void )
+{
+   return editBegin( 0, 0, OPSEL_USER );
+}
+
+void hl_edit_done( void )
+{
+   csMeshDone( EDERR_NONE, 0 );
+}
+
+void hl_edit_undo( void )
+{
+   if ( sessionOpen ) return;
+   npnts = sessionPnts;
+   npols = sessionPols;
+   npolPnts = sessionPolPnts;
+}
+
+/*
+======================================================================
+LWModCommand
+
+evaluate() understands the commands the plug-in issues: SETLAYER,
+SETALAYER, SETBLAYER, SEL_POINT and SEL_POLYGON with a volume.
+====================================================================== */
+
+static int parseVolume( const char *s, double *lo, double *hi )
+{
+   double a[ 3 ], b[ 3 ];
+   int i;
+
+   s = strchr( s, '<' );
+   if ( !s || sscanf( s, "<%lf %lf %lf>", &a[ 0 ], &a[ 1 ], &a[ 2 ] ) != 3 ) return 0;
+   s = strchr( s + 1, '<' );
+   if ( !s || sscanf( s, "<%lf %lf %lf>", &b[ 0 ], &b[ 1 ], &b[ 2 ] ) != 3 ) return 0;
+   for ( i = 0; i < 3; i++ ) {
+      lo[ i ] = a[ i ] < b[ i ] ? a[ i ] : b[ i ];
+      hi[ i ] = a[ i ] < b[ i ] ? b[ i ] : a[ i ];
+   }
+   return 1;
+}
+
+static int pointInBox( int i, const double *lo, const double *hi )
+{
+   const double *p = pnts[ i ].info.position;
+
+   return p[ 0 ] >= lo[ 0 ] && p[ 0 ] <= hi[ 0 ] && p[ 1 ] >= lo[ 1 ] && p[ 1 ] <= hi[ 1 ]
+      && p[ 2 ] >= lo[ 2 ] && p[ 2 ] <= hi[ 2 ];
+}
+
+static int selectVolume( const char *args, int polygons )
+{
+   double lo[ 3 ], hi[ 3 ];
+   int set, i, j, inside;
+
+   set = !strncmp( args, "SET", 3 );
+   if ( !set && strncmp( args, "CLEAR", 5 )) return EDERR_BADARGS;
+   if ( !parseVolume( args, lo, hi )) return EDERR_BADARGS;
+
+   selMode = polygons ? 1 : 0;
+   if ( !polygons ) {
+      for ( i = 0; i < npnts; i++ ) {
+         if (( pnts[ i ].flags & EDDF_DELETE ) || !fgLayer[ pnts[ i ].layer ] || !pointInBox( i, lo, hi )) continue;
+         if ( set ) pnts[ i ].flags |= EDDF_SELECT; else pnts[ i ].flags &= ~EDDF_SELECT;
+      }
+      return EDERR_NONE;
+   }
+   for ( i = 0; i < npols; i++ ) {
+      if (( pols[ i ].flags & EDDF_DELETE ) || !fgLayer[ pols[ i ].layer ] ) continue;
+      for ( inside = 1, j = 0; j < pols[ i ].count && inside; j++ )
+         inside = pointInBox( PNT_IDX( polPnts[ pols[ i ].first + j ] ), lo, hi );
+      if ( !inside ) continue;
+      if ( set ) pols[ i ].flags |= EDDF_SELECT; else pols[ i ].flags &= ~EDDF_SELECT;
+   }
+   return EDERR_NONE;
+}
+
+static const char *quotedArg( const char *s, char *buf, size_t size )
+{
+   const char *e;
+
+   while ( *s == ' ' ) s++;
+   if ( *s == '"' ) {
+      s++;
+      e = strchr( s, '"' );
+      if ( !e ) e = s + strlen( s );
+   }
+   else e = s + strlen( s );
+   if ((size_t)( e - s ) >= size ) e = s + size - 1;
+   memcpy( buf, s, e - s );
+   buf[ e - s ] = 0;
+   return buf;
+}
+
+static int evaluate( void *data, const char *command )
+{
+   char buf[ 512 ];
+
+   if ( !strncmp( command, "SETLAYER ", 9 )) {
+      int layer = atoi( quotedArg( command + 9, buf, sizeof( buf )));
+      if ( layer < 1 || layer > HL_MAX_LAYERS ) return EDERR_BADLAYER;
+      memset( fgLayer, 0, sizeof( fgLayer ));
+      fgLayer[ layer ] = 1;
+      return EDERR_NONE;
+   }
+   if ( !strncmp( command, "SETALAYER ", 10 )) {
+      parseLayers( quotedArg( command + 10, buf, sizeof( buf )), fgLayer );
+      return EDERR_NONE;
+   }
+   if ( !strncmp( command, "SETBLAYER ", 10 )) {
+      parseLayers( quotedArg( command + 10, buf, sizeof( buf )), bgLayer );
+      return EDERR_NONE;
+   }
+   if ( !strncmp( command, "SEL_POINT ", 10 )) return selectVolume( command + 10, 0 );
+   if ( !strncmp( command, "SEL_POLYGON ", 12 )) return selectVolume( command + 12, 1 );
+
+   if ( !quiet ) fprintf( stderr, "lwheadless: unknown command \"%s\"\n", command );
+   return EDERR_BADARGS;
+}
+
+static LWModCommand modCommand;
+
+LWModCommand *hl_local( const char *argument )
+{
+   memset( &modCommand, 0, sizeof( modCommand ));
+   modCommand.argument = argument;
+   modCommand.editBegin = editBegin;
+   modCommand.evaluate = evaluate;
+   return &modCommand;
+}
+
+/*
+======================================================================
+modeler_library
+====================================================================== */
+
+static ModData modData;
+
+ModData *csInit( GlobalFunc *global, LWModCommand *local )
+{
+   modData.gFunc = global;
+   modData.local = local;
+   modData.edit = NULL;
+   return &modData;
+}
+
+MeshEditOp *csMeshBegin( int pntBuf, int polBuf, EltOpSelect sel )
+{
+   modData.edit = editBegin( pntBuf, polBuf, sel );
+   return modData.edit;
+}
+
+void csMeshDone( EDError err, int selm )
+{
+   int i;
+
+   if ( !sessionOpen ) return;
+   if ( err != EDERR_NONE ) {   /* discard everything added in this session */
+      npnts = sessionPnts;
+      npols = sessionPols;
+      npolPnts = sessionPolPnts;
+   }
+
+   /* the elements selected in the session replace the selection */
+   for ( i = 0; ( sessionPicked || ( selm & EDSELM_CLEARCURRENT )) && i < npnts; i++ ) {
+      if (( selm & EDSELM_CLEARCURRENT ) && !( pnts[ i ].flags & HL_DF_PICKED ))
+         pnts[ i ].flags &= ~EDDF_SELECT;
+      pnts[ i ].flags &= ~HL_DF_PICKED;
+   }
+   for ( i = 0; ( sessionPicked || ( selm & EDSELM_CLEARCURRENT )) && i < npols; i++ ) {
+      if (( selm & EDSELM_CLEARCURRENT ) && !( pols[ i ].flags & HL_DF_PICKED ))
+         pols[ i ].flags &= ~EDDF_SELECT;
+      pols[ i ].flags &= ~HL_DF_PICKED;
+   }
+   sessionPicked = 0;
+   if ( selm & EDSELM_FORCEPOLS ) selMode = 1;
+   if ( selm & EDSELM_FORCEVRTS ) selMode = 0;
+   sessionOpen = 0;
+   modData.edit = NULL;
+}
+
+int mePointCount( EltOpLayer ol, int mode )                   { return countPoints( ol, mode ); }
+int mePolyCount( EltOpLayer ol, int mode )                    { return countPolys( ol, mode ); }
+EDError mePointScan( EDPointScanFunc *f, void *d, EltOpLayer ol ) { return scanPoints( f, d, ol ); }
+EDError mePolyScan( EDPolyScanFunc *f, void *d, EltOpLayer ol )   { return scanPolys( f, d, ol ); }
+EDPointInfo *mePointInfo( LWPntID id )                        { return pointInfo( id ); }
+EDPolygonInfo *mePolyInfo( LWPolID id )                       { return polyInfo( id ); }
+LWPntID meAddPoint( double *xyz )                             { return addPoint( xyz ); }
+LWPolID meAddFace( const char *surf, int n, const LWPntID *p ) { return addFace( surf, n, p ); }
+
+int csMakeDisc( double *radius, double top, double bottom, const char *axis,
+   int sides, int segments, double *center )
+{
+   int a = 2, u, v, i, *idx;
+   double pos[ 3 ];
+
+   if ( sides < 3 ) return 0;
+   if ( axis && ( axis[ 0 ] == 'X' || axis[ 0 ] == 'x' )) a = 0;
+   if ( axis && ( axis[ 0 ] == 'Y' || axis[ 0 ] == 'y' )) a = 1;
+   u = ( a + 1 ) % 3;
+   v = ( a + 2 ) % 3;
+
+   idx = malloc( sides * sizeof( int ));
+   for ( i = 0; i < sides; i++ ) {
+      double t = 2.0 * PI * i / sides;
+
+      pos[ a ] = center[ a ] + top;
+      pos[ u ] = center[ u ] + radius[ u ] * cos( t );
+      pos[ v ] = center[ v ] + radius[ v ] * sin( t );
+      idx[ i ] = hl_add_point( primaryLayer(), pos[ 0 ], pos[ 1 ], pos[ 2 ], 0 );
+   }
+   hl_add_poly( primaryLayer(), sides, idx, 0 );
+   free( idx );
+   return 1;
+}
+
+int csDelete( void )
+{
+   int i, j, used;
+
+   for ( i = 0; i < npols; i++ ) {
+      if (( pols[ i ].flags & EDDF_DELETE ) || !fgLayer[ pols[ i ].layer ] ) continue;
+      if ( selMode == 1 ) {
+         if ( pols[ i ].flags & EDDF_SELECT ) pols[ i ].flags |= EDDF_DELETE;
+         continue;
+      }
+      for ( used = 0, j = 0; j < pols[ i ].count && !used; j++ )
+         used = pnts[ PNT_IDX( polPnts[ pols[ i ].first + j ] ) ].flags & EDDF_SELECT;
+      if ( used ) pols[ i ].flags |= EDDF_DELETE;
+   }
+   if ( selMode == 0 ) {
+      for ( i = 0; i < npnts; i++ )
+         if ( fgLayer[ pnts[ i ].layer ] && ( pnts[ i ].flags & EDDF_SELECT )) pnts[ i ].flags |= EDDF_DELETE;
+   }
+   return 1;
+}
+
+/*
+======================================================================
+common_library
+
+LightWave matrices act on row vectors: b = a * m, translation in
+row 3.
+====================================================================== */
+
+void LWMAT_didentity4( LWDMatrix4 m )
+{
+   int i, j;
+
+   for ( i = 0; i < 4; i++ )
+      for ( j = 0; j < 4; j++ )
+         m[ i ][ j ] = ( i == j ) ? 1.0 : 0.0;
+}
+
+void LWMAT_dcopym4( LWDMatrix4 to, LWDMatrix4 from )
+{
+   memcpy( to, from, sizeof( LWDMatrix4 ));
+}
+
+void LWMAT_dmatmul4( LWDMatrix4 a, LWDMatrix4 b, LWDMatrix4 c )
+{
+   LWDMatrix4 t;
+   int i, j, k;
+
+   for ( i = 0; i < 4; i++ )
+      for ( j = 0; j < 4; j++ ) {
+         t[ i ][ j ] = 0.0;
+         for ( k = 0; k < 4; k++ ) t[ i ][ j ] += a[ i ][ k ] * b[ k ][ j ];
+      }
+   memcpy( c, t, sizeof( LWDMatrix4 ));
+}
+
+void LWMAT_dtransformp( LWDVector a, LWDMatrix4 m, LWDVector b )
+{
+   LWDVector t;
+   int j;
+
+   for ( j = 0; j < 3; j++ )
+      t[ j ] = a[ 0 ] * m[ 0 ][ j ] + a[ 1 ] * m[ 1 ][ j ] + a[ 2 ] * m[ 2 ][ j ] + m[ 3 ][ j ];
+   b[ 0 ] = t[ 0 ]; b[ 1 ] = t[ 1 ]; b[ 2 ] = t[ 2 ];
+}
+
+void LWMAT_dinitm4( LWDMatrix4 m,
+   double a1, double b1, double c1, double d1,
+   double a2, double b2, double c2, double d2,
+   double a3, double b3, double c3, double d3,
+   double a4, double b4, double c4, double d4 )
+{
+   m[ 0 ][ 0 ] = a1; m[ 0 ][ 1 ] = b1; m[ 0 ][ 2 ] = c1; m[ 0 ][ 3 ] = d1;
+   m[ 1 ][ 0 ] = a2; m[ 1 ][ 1 ] = b2; m[ 1 ][ 2 ] = c2; m[ 1 ][ 3 ] = d2;
+   m[ 2 ][ 0 ] = a3; m[ 2 ][ 1 ] = b3; m[ 2 ][ 2 ] = c3; m[ 2 ][ 3 ] = d3;
+   m[ 3 ][ 0 ] = a4; m[ 3 ][ 1 ] = b4; m[ 3 ][ 2 ] = c4; m[ 3 ][ 3 ] = d4;
+}
+
+double LWVEC_dangle( LWDVector a, LWDVector b )
+{
+   double la, lb, c;
+
+   la = sqrt( a[ 0 ] * a[ 0 ] + a[ 1 ] * a[ 1 ] + a[ 2 ] * a[ 2 ] );
+   lb = sqrt( b[ 0 ] * b[ 0 ] + b[ 1 ] * b[ 1 ] + b[ 2 ] * b[ 2 ] );
+   if ( la == 0.0 || lb == 0.0 ) return 0.0;
+   c = ( a[ 0 ] * b[ 0 ] + a[ 1 ] * b[ 1 ] + a[ 2 ] * b[ 2 ] ) / ( la * lb );
+   if ( c > 1.0 ) c = 1.0;
+   if ( c < -1.0 ) c = -1.0;
+   return acos( c );
+}
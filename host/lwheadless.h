@@ -0,0 +1,51 @@
+/*
+======================================================================
+lwheadless.h
+
+Headless LightWave Modeler host.  Provides the globals, LWModCommand
+and modeler_library calls 3PointCircle uses over an in-memory mesh so
+the plug-in can be run and timed without Modeler.
+====================================================================== */
+
+#ifndef LWHEADLESS_H
+#define LWHEADLESS_H
+
+#include <lwserver.h>
+#include <lwmodeler.h>
+
+#define HL_MAX_LAYERS 64
+
+/* scene setup */
+void  hl_reset( void );
+int   hl_add_point( int layer, double x, double y, double z, int select );
+int   hl_add_poly( int layer, int numPnts, const int *points, int select );
+int   hl_add_curve( int layer, int numPnts, const int *points, int select );
+void  hl_select_point( int index, int select );
+void  hl_set_mode( int selmode );
+void  hl_set_layers( const char *fg, const char *bg );
+int   hl_load_obj( const char *path, int layer, int select );
+int   hl_write_obj( const char *path );
+
+/* XPanel stand-in: post() returns ok and applies "Label=value" overrides */
+void  hl_xpanel_ok( int ok );
+int   hl_xpanel_set( const char *assignment );
+int   hl_xpanel_count( void );
+void  hl_xpanel_wait( int ms );   /* think time of each post() */
+
+/* queries */
+int   hl_point_count( int layer );
+int   hl_poly_count( int layer );
+int   hl_selected( int layer );   /* in the current selection mode */
+int   hl_message_count( void );
+void  hl_quiet( int quiet );
+
+/* MeshEditTool builds, undone with hl_edit_undo() */
+MeshEditOp *hl_edit_begin( void );
+void  hl_edit_done( void );
+void  hl_edit_undo( void );
+
+/* plug-in side */
+void         *hl_global( const char *serviceName, int useMode );
+LWModCommand *hl_local( const char *argument );
+
+#endif
@@ -0,0 +1,23 @@
+/*
+======================================================================
+lwhost.h
+
+Headless host stand-in for the LightWave SDK header of the same name.
+====================================================================== */
+
+#ifndef LWSDK_HOST_H
+#define LWSDK_HOST_H
+
+#define LWMESSAGEFUNCS_GLOBAL "Info Messages 2"
+
+typedef struct st_LWMessageFuncs {
+   void (*info)( const char *, const char * );
+   void (*error)( const char *, const char * );
+   void (*warning)( const char *, const char * );
+   int  (*okCancel)( const char *ttl, const char *info, const char *info2 );
+   int  (*yesNo)( const char *ttl, const char *info, const char *info2 );
+   int  (*yesNoCan)( const char *ttl, const char *info, const char *info2 );
+   int  (*yesNoAll)( const char *ttl, const char *info, const char *info2 );
+} LWMessageFuncs;
+
+#endif
@@ -0,0 +1,118 @@
+/*
+======================================================================
+lwmeshedt.h
+
+Headless host stand-in for the LightWave SDK header of the same name.
+====================================================================== */
+
+#ifndef LWSDK_MESHEDT_H
+#define LWSDK_MESHEDT_H
+
+#include <lwtypes.h>
+#include <lwtool.h>
+
+typedef enum en_EltOpLayer {
+   OPLYR_PRIMARY,
+   OPLYR_FG,
+   OPLYR_BG,
+   OPLYR_SELECT,
+   OPLYR_ALL,
+   OPLYR_EMPTY,
+   OPLYR_NONEMPTY
+} EltOpLayer;
+
+typedef enum en_EltOpSelect {
+   OPSEL_GLOBAL,
+   OPSEL_USER,
+   OPSEL_DIRECT
+} EltOpSelect;
+
+typedef int EDError;
+#define EDERR_NONE      0
+#define EDERR_NOMEMORY  1
+#define EDERR_BADLAYER  2
+#define EDERR_BADSURF   3
+#define EDERR_USERABORT 4
+#define EDERR_BADARGS   5
+#define EDERR_BADVMAP   6
+
+#define EDDF_SELECT (1<<0)
+#define EDDF_DELETE (1<<1)
+
+/* polygon types, from lwmeshes.h */
+#define LWPOLTYPE_FACE LWID_('F','A','C','E')
+#define LWPOLTYPE_CURV LWID_('C','U','R','V')
+
+#define EDCOUNT_ALL    0
+#define EDCOUNT_SELECT 1
+#define EDCOUNT_DELETE 2
+
+#define EDSELM_CLEARCURRENT (1<<0)
+#define EDSELM_SELECTNEW    (1<<1)
+#define EDSELM_FORCEVRTS    (1<<2)
+#define EDSELM_FORCEPOLS    (1<<3)
+
+typedef struct st_EDPointInfo {
+   LWPntID       pnt;
+   void         *userData;
+   int           layer;
+   int           flags;
+   double        position[ 3 ];
+   float        *vmapVec;
+} EDPointInfo;
+
+typedef struct st_EDPolygonInfo {
+   LWPolID        pol;
+   void          *userData;
+   int            layer;
+   int            flags;
+   int            numPnts;
+   const LWPntID *points;
+   const char    *surface;
+   unsigned int   type;
+} EDPolygonInfo;
+
+typedef EDError EDPointScanFunc( void *, const EDPointInfo * );
+typedef EDError EDPolyScanFunc( void *, const EDPolygonInfo * );
+
+typedef struct st_EDState *EDStateRef;
+
+typedef struct st_MeshEditOp {
+   EDStateRef     state;
+   int            layerNum;
+   void          (*done)( EDStateRef, EDError, int selm );
+   int           (*pointCount)( EDStateRef, EltOpLayer, int mode );
+   int           (*polyCount)( EDStateRef, EltOpLayer, int mode );
+   EDError       (*pointScan)( EDStateRef, EDPointScanFunc *, void *, EltOpLayer );
+   EDError       (*polyScan)( EDStateRef, EDPolyScanFunc *, void *, EltOpLayer );
+   EDPointInfo  *(*pointInfo)( EDStateRef, LWPntID );
+   EDPolygonInfo *(*polyInfo)( EDStateRef, LWPolID );
+   LWPntID       (*addPoint)( EDStateRef, double *xyz );
+   LWPolID       (*addFace)( EDStateRef, const char *surf, int numPnt, const LWPntID * );
+   EDError       (*remPoint)( EDStateRef, LWPntID );
+   EDError       (*remPoly)( EDStateRef, LWPolID );
+   EDError       (*pntMove)( EDStateRef, LWPntID, const double * );
+   EDError       (*pntSelect)( EDStateRef, LWPntID, int );
+   EDError       (*polSelect)( EDStateRef, LWPolID, int );
+} MeshEditOp;
+
+typedef MeshEditOp *MeshEditBegin( int pntBuf, int polBuf, EltOpSelect );
+
+#define LWMESHEDITTOOL_CLASS   "MeshEditTool"
+#define LWMESHEDITTOOL_VERSION 5
+
+#define LWT_TEST_NOTHING 0
+#define LWT_TEST_UPDATE  1
+#define LWT_TEST_ACCEPT  2
+#define LWT_TEST_REJECT  3
+#define LWT_TEST_CLONE   4
+
+typedef struct st_LWMeshEditTool {
+   LWInstance     instance;
+   LWToolFuncs   *tool;
+   int          (*test)( LWInstance );
+   LWError      (*build)( LWInstance, MeshEditOp * );
+   void         (*end)( LWInstance, int keep );
+} LWMeshEditTool;
+
+#endif
@@ -0,0 +1,28 @@
+/*
+======================================================================
+lwmodeler.h
+
+Headless host stand-in for the LightWave SDK header of the same name.
+====================================================================== */
+
+#ifndef LWSDK_MODELER_H
+#define LWSDK_MODELER_H
+
+#include <lwcmdseq.h>
+
+#define LWSTATEQUERYFUNCS_GLOBAL "LWM: State Query 3"
+
+#define LWM_MODE_SELECTION 0
+#define LWM_MODE_SYMMETRY  1
+
+typedef struct st_LWStateQueryFuncs {
+   int           (*numLayers)( void );
+   unsigned int  (*layerMask)( EltOpLayer );
+   const char   *(*surface)( void );
+   unsigned int  (*bbox)( EltOpLayer, double *minmax );
+   const char   *(*layerList)( EltOpLayer, const char * );
+   const char   *(*object)( void );
+   int           (*mode)( int );
+} LWStateQueryFuncs;
+
+#endif
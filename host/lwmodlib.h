@@ -0,0 +1,39 @@
+/*
+======================================================================
+lwmodlib.h
+
+Headless host stand-in for the LightWave SDK modeler_library.  The
+cs* command wrappers and me* mesh edit wrappers are implemented by
+lwhost.c over an in-memory mesh.
+====================================================================== */
+
+#ifndef LWSDK_MODLIB_H
+#define LWSDK_MODLIB_H
+
+#include <lwserver.h>
+#include <lwmodeler.h>
+
+typedef struct st_ModData {
+   GlobalFunc   *gFunc;
+   LWModCommand *local;
+   MeshEditOp   *edit;
+   int           result;
+} ModData;
+
+extern ModData       *csInit( GlobalFunc *, LWModCommand * );
+extern MeshEditOp    *csMeshBegin( int pntBuf, int polBuf, EltOpSelect );
+extern void           csMeshDone( EDError, int selm );
+extern int            csMakeDisc( double *radius, double top, double bottom,
+                         const char *axis, int sides, int segments, double *center );
+extern int            csDelete( void );
+
+extern int            mePointCount( EltOpLayer, int mode );
+extern int            mePolyCount( EltOpLayer, int mode );
+extern EDError        mePointScan( EDPointScanFunc *, void *, EltOpLayer );
+extern EDError        mePolyScan( EDPolyScanFunc *, void *, EltOpLayer );
+extern EDPointInfo   *mePointInfo( LWPntID );
+extern EDPolygonInfo *mePolyInfo( LWPolID );
+extern LWPntID        meAddPoint( double *xyz );
+extern LWPolID        meAddFace( const char *surf, int numPnt, const LWPntID * );
+
+#endif
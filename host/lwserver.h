@@ -0,0 +1,50 @@
+/*
+======================================================================
+lwserver.h
+
+Headless host stand-in for the LightWave SDK header of the same name.
+====================================================================== */
+
+#ifndef LWSDK_SERVER_H
+#define LWSDK_SERVER_H
+
+#include <lwtypes.h>
+
+typedef void *GlobalFunc( const char *serviceName, int useMode );
+typedef int ActivateFunc( long version, GlobalFunc *global, void *local,
+   void *serverData );
+
+typedef struct st_ServerTagInfo {
+   const char *string;
+   unsigned int tag;
+} ServerTagInfo;
+
+typedef struct st_ServerRecord {
+   const char    *className;
+   const char    *name;
+   ActivateFunc  *activate;
+   ServerTagInfo *tagInfo;
+} ServerRecord;
+
+#define AFUNC_OK         0
+#define AFUNC_BADVERSION 1
+#define AFUNC_BADGLOBAL  2
+#define AFUNC_BADLOCAL   3
+#define AFUNC_BADAPP     4
+#define AFUNC_BADAPP_SILENT 5
+
+#define GFUSE_TRANSIENT 0
+#define GFUSE_ACQUIRE   0x80000000
+#define GFUSE_RELEASE   0x40000000
+
+#ifdef _WIN32
+#define XCALL_(t) t
+#define XCALL_INIT
+#else
+#define XCALL_(t) t
+#define XCALL_INIT
+#endif
+
+#include <lwhost.h>
+
+#endif
@@ -0,0 +1,75 @@
+/*
+======================================================================
+lwtool.h
+
+Headless host stand-in for the LightWave SDK header of the same name.
+====================================================================== */
+
+#ifndef LWSDK_TOOL_H
+#define LWSDK_TOOL_H
+
+#include <lwtypes.h>
+#include <lwxpanel.h>
+
+#define LWWIRE_SOLID    0
+#define LWWIRE_DASH     1
+
+#define LWWIRE_ABSOLUTE 0
+#define LWWIRE_RELATIVE 1
+#define LWWIRE_SCREEN   2
+
+typedef struct st_LWWireDrawAccess {
+   void   *data;
+   void  (*moveTo)( void *, LWFVector, int );
+   void  (*lineTo)( void *, LWFVector, int );
+   void  (*spline)( void *, LWFVector, LWFVector, LWFVector, int );
+   void  (*circle)( void *, double, int );
+   int     axis;
+   void  (*text)( void *, const char *, int );
+   double  pxScale;
+} LWWireDrawAccess;
+
+#define LWTOOLF_CONSTRAIN (1<<0)
+#define LWTOOLF_CONS_X    (1<<1)
+#define LWTOOLF_CONS_Y    (1<<2)
+#define LWTOOLF_ALT_BUTTON (1<<3)
+#define LWTOOLF_MULTICLICK (1<<4)
+
+typedef struct st_LWToolEvent {
+   LWDVector posSnap;
+   LWDVector posRaw;
+   LWDVector axis;
+   LWDVector ax;
+   LWDVector ay;
+   double    pxRaw, pyRaw;
+   double    pxSnap, pySnap;
+   int       dx, dy;
+   int       px, py;
+   int       portAxis;
+   int       flags;
+} LWToolEvent;
+
+typedef struct st_LWToolFuncs {
+   void         (*done)( LWInstance );
+   void         (*draw)( LWInstance, LWWireDrawAccess * );
+   const char  *(*help)( LWInstance, LWToolEvent * );
+   int          (*dirty)( LWInstance );
+   int          (*count)( LWInstance, LWToolEvent * );
+   int          (*handle)( LWInstance, LWToolEvent *, int i, LWDVector pos );
+   int          (*start)( LWInstance, LWToolEvent * );
+   int          (*adjust)( LWInstance, LWToolEvent *, int i );
+   int          (*down)( LWInstance, LWToolEvent * );
+   void         (*move)( LWInstance, LWToolEvent * );
+   void         (*up)( LWInstance, LWToolEvent * );
+   void         (*event)( LWInstance, int code );
+   LWXPanelID   (*panel)( LWInstance );
+} LWToolFuncs;
+
+#define LWT_DIRTY_WIREFRAME (1<<0)
+#define LWT_DIRTY_HELPTEXT  (1<<1)
+
+#define LWT_EVENT_DROP     0
+#define LWT_EVENT_RESET    1
+#define LWT_EVENT_ACTIVATE 2
+
+#endif
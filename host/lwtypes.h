@@ -0,0 +1,25 @@
+/*
+======================================================================
+lwtypes.h
+
+Headless host stand-in for the LightWave SDK header of the same name.
+Only the declarations used by 3PointCircle are provided.
+====================================================================== */
+
+#ifndef LWSDK_TYPES_H
+#define LWSDK_TYPES_H
+
+typedef float  LWFVector[ 3 ];
+typedef double LWDVector[ 3 ];
+typedef float  LWFMatrix4[ 4 ][ 4 ];
+typedef double LWDMatrix4[ 4 ][ 4 ];
+
+typedef struct st_GCoreVertex  *LWPntID;
+typedef struct st_GCorePolygon *LWPolID;
+
+typedef void *LWInstance;
+typedef const char *LWError;
+typedef unsigned int LWID;
+#define LWID_( a, b, c, d ) ((((unsigned int)(a))<<24)|(((unsigned int)(b))<<16)|(((unsigned int)(c))<<8)|((unsigned int)(d)))
+
+#endif
@@ -0,0 +1,69 @@
+/*
+======================================================================
+lwxpanel.h
+
+Headless host stand-in for the LightWave SDK header of the same name.
+====================================================================== */
+
+#ifndef LWSDK_XPANEL_H
+#define LWSDK_XPANEL_H
+
+#define LWXPANELFUNCS_GLOBAL "LWXPanel"
+
+#define LWXP_VIEW 1
+#define LWXP_FORM 2
+
+typedef struct st_LWXPanel *LWXPanelID;
+typedef void *LWXPanelHint;
+
+typedef struct st_LWXPanelControl {
+   unsigned long cid;
+   const char   *label;
+   const char   *ctrlclass;
+} LWXPanelControl;
+
+typedef struct st_LWXPanelDataDesc {
+   unsigned long vid;
+   const char   *name;
+   const char   *datatype;
+} LWXPanelDataDesc;
+
+typedef void *LWXPanelGetFunc( void *inst, unsigned long vid );
+typedef int   LWXPanelSetFunc( void *inst, unsigned long vid, void *value );
+
+/* LWXPanelSetFunc results */
+#define LWXPRC_NONE 0
+#define LWXPRC_DFLT 1
+#define LWXPRC_DRAW 2
+#define LWXPRC_FULL 3
+
+#define XPTAG_END     0
+#define XPTAG_LABEL   0x4C41424C
+#define XPTAG_STRLIST 0x53544C53
+#define XPTAG_MIN     0x4D494E20
+#define XPTAG_MAX     0x4D415820
+
+#define XpEND                 (LWXPanelHint)XPTAG_END
+#define XpLABEL( cid, lbl )   (LWXPanelHint)XPTAG_LABEL, (LWXPanelHint)(cid), (LWXPanelHint)(lbl)
+#define XpSTRLIST( cid, lst ) (LWXPanelHint)XPTAG_STRLIST, (LWXPanelHint)(cid), (LWXPanelHint)(lst)
+#define XpMIN( cid, n )       (LWXPanelHint)XPTAG_MIN, (LWXPanelHint)(cid), (LWXPanelHint)(long)(n)
+#define XpMAX( cid, n )       (LWXPanelHint)XPTAG_MAX, (LWXPanelHint)(cid), (LWXPanelHint)(long)(n)
+
+typedef struct st_LWXPanelFuncs {
+   int          version;
+   LWXPanelID (*create)( int type, LWXPanelControl *data );
+   void       (*destroy)( LWXPanelID panel );
+   void       (*describe)( LWXPanelID panel, LWXPanelDataDesc *data,
+                 LWXPanelGetFunc *get, LWXPanelSetFunc *set );
+   void       (*hint)( LWXPanelID panel, unsigned long id, LWXPanelHint *hints );
+   void      *(*getData)( LWXPanelID panel, unsigned long id );
+   void       (*setData)( LWXPanelID panel, unsigned long id, void *data );
+   void      *(*formGet)( LWXPanelID panel, unsigned long vid );
+   void       (*formSet)( LWXPanelID panel, unsigned long vid, void *value );
+   void       (*viewInst)( LWXPanelID panel, void *inst );
+   void       (*viewRefresh)( LWXPanelID panel );
+   int        (*post)( LWXPanelID panel );
+   int        (*open)( LWXPanelID panel );
+} LWXPanelFuncs;
+
+#endif
@@ -0,0 +1,123 @@
+/*
+======================================================================
+kmarena.c
+
+Per-invocation memory arena.
+
+Blocks form a list with the current block at the head.  Requests
+larger than a quarter block get a block of their own, inserted behind
+the head so the head keeps its free space.
+====================================================================== */
+
+#include <stdlib.h>
+#include <string.h>
+#include "kmarena.h"
+
+#define KMARENA_ALIGN 16
+
+struct st_KMArenaBlock {
+   KMArenaBlock *next;
+   size_t        size;
+   size_t        used;
+   double        align;   /* data follows, aligned for doubles */
+};
+
+#define KMARENA_HEADER  (( sizeof( KMArenaBlock ) + KMARENA_ALIGN - 1 ) & ~(size_t)( KMARENA_ALIGN - 1 ))
+
+static KMArenaBlock *newBlock( size_t size )
+{
+   KMArenaBlock *b;
+
+   b = (KMArenaBlock *)malloc( KMARENA_HEADER + size );
+   if ( !b ) return NULL;
+   b->next = NULL;
+   b->size = size;
+   b->used = 0;
+   return b;
+}
+
+/*
+======================================================================
+KMArenaInit()
+
+Start with an empty arena.  No memory is taken until the first
+allocation.
+====================================================================== */
+void KMArenaInit( KMArena *arena )
+{
+   arena->head = NULL;
+   arena->total = 0;
+}
+
+/*
+======================================================================
+KMArenaAlloc()
+
+Return size bytes aligned to 16, or NULL when out of memory.  The
+memory is not initialized.
+====================================================================== */
+void *KMArenaAlloc( KMArena *arena, size_t size )
+{
+   KMArenaBlock *b = arena->head;
+
+   size = ( size + KMARENA_ALIGN - 1 ) & ~(size_t)( KMARENA_ALIGN - 1 );
+   if ( size == 0 ) size = KMARENA_ALIGN;
+
+   if ( b && b->size - b->used >= size ) {
+      b->used += size;
+      return (char *)b + KMARENA_HEADER + b->used - size;
+   }
+
+   if ( size > KMARENA_BLOCK / 4 ) {
+      b = newBlock( size );
+      if ( !b ) return NULL;
+      b->used = size;
+      if ( arena->head ) {
+         b->next = arena->head->next;
+         arena->head->next = b;
+      }
+      else arena->head = b;
+   }
+   else {
+      b = newBlock( KMARENA_BLOCK );
+      if ( !b ) return NULL;
+      b->used = size;
+      b->next = arena->head;
+      arena->head = b;
+   }
+   arena->total += b->size;
+   return (char *)b + KMARENA_HEADER;
+}
+
+/*
+======================================================================
+KMArenaStrdup()
+
+Copy a string into the arena.
+====================================================================== */
+char *KMArenaStrdup( KMArena *arena, const char *s )
+{
+   size_t n = strlen( s ) + 1;
+   char *d = (char *)KMArenaAlloc( arena, n );
+
+   if ( d ) memcpy( d, s, n );
+   return d;
+}
+
+/*
+======================================================================
+KMArenaFree()
+
+Release every block.  The arena is empty and can be used again.
+====================================================================== */
+void KMArenaFree( KMArena *arena )
+{
+   KMArenaBlock *b, *next;
+
+   for ( b = arena->head; b; b = next ) {
+      next = b->next;
+      free( b );
+   }
+   arena->head = NULL;
+   arena->total = 0;
+}
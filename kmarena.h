@@ -0,0 +1,28 @@
+/*
+======================================================================
+kmarena.h
+
+Per-invocation memory arena.  Allocations are carved from large blocks
+and released all at once with KMArenaFree().
+====================================================================== */
+
+#ifndef KMARENA_H
+#define KMARENA_H
+
+#include <stddef.h>
+
+#define KMARENA_BLOCK ( 64 * 1024 )
+
+typedef struct st_KMArenaBlock KMArenaBlock;
+
+typedef struct st_KMArena {
+   KMArenaBlock *head;
+   size_t        total;
+} KMArena;
+
+void  KMArenaInit( KMArena *arena );
+void *KMArenaAlloc( KMArena *arena, size_t size );
+char *KMArenaStrdup( KMArena *arena, const char *s );
+void  KMArenaFree( KMArena *arena );
+
+#endif
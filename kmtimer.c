@@ -0,0 +1,186 @@
+/*
+======================================================================
+kmtimer.c
+
+Per-phase timing of Activate().
+
+KM_TRACE is read once, by the first KMTimerBegin().  The session
+histograms are static and updated by KMTimerEndRun(); bucket b counts
+the phases that took under 2^b microseconds and at least half that.
+Modeler runs the command on one thread, so they need no locking.
+====================================================================== */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "kmtimer.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#define KMT_BUCKETS 26   /* the last one takes everything over 16 s */
+
+static const char *phaseName[ KMT_PHASES + 1 ] = {
+   "scan", "panel", "layers", "solve", "build", "restore", "total"
+};
+
+static int    checked = 0;
+static int    traceOn = 0;
+static char   tracePath[ 260 ];
+static long   runs = 0;
+static long   count[ KMT_PHASES + 1 ];
+static double sum[ KMT_PHASES + 1 ];
+static double most[ KMT_PHASES + 1 ];
+static long   hist[ KMT_PHASES + 1 ][ KMT_BUCKETS ];
+
+static double now( void )
+{
+#ifdef _WIN32
+   LARGE_INTEGER freq, ticks;
+
+   QueryPerformanceFrequency( &freq );
+   QueryPerformanceCounter( &ticks );
+   return (double)ticks.QuadPart / (double)freq.QuadPart;
+#else
+   struct timespec ts;
+
+   clock_gettime( CLOCK_MONOTONIC, &ts );
+   return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+static FILE *openTrace( void )
+{
+   return tracePath[ 0 ] ? fopen( tracePath, "a" ) : stderr;
+}
+
+static void closeTrace( FILE *fp )
+{
+   if ( fp != stderr ) fclose( fp );
+}
+
+static void record( int phase, double t )
+{
+   double limit = 1e-6;
+   int b = 0;
+
+   while ( b < KMT_BUCKETS - 1 && t >= limit ) {
+      limit *= 2.0;
+      b++;
+   }
+   hist[ phase ][ b ]++;
+   count[ phase ]++;
+   sum[ phase ] += t;
+   if ( t > most[ phase ] ) most[ phase ] = t;
+}
+
+/*
+======================================================================
+report()
+
+Write the session histograms, at exit.
+====================================================================== */
+static void report( void )
+{
+   FILE *fp;
+   double limit;
+   int p, b;
+
+   if ( runs == 0 || !( fp = openTrace() )) return;
+
+   fprintf( fp, "3PointCircle phase times over %ld invocations: count, mean, max,"
+      " then count per bucket by upper bound\n", runs );
+   for ( p = 0; p <= KMT_PHASES; p++ ) {
+      if ( count[ p ] == 0 ) continue;
+      fprintf( fp, "  %-8s %6ld %10.3f ms %10.3f ms ", phaseName[ p ], count[ p ],
+         sum[ p ] * 1e3 / count[ p ], most[ p ] * 1e3 );
+      for ( b = 0, limit = 1e-6; b < KMT_BUCKETS; b++, limit *= 2.0 ) {
+         if ( hist[ p ][ b ] == 0 ) continue;
+         if ( b == KMT_BUCKETS - 1 ) fprintf( fp, " >16s:%ld", hist[ p ][ b ] );
+         else if ( limit < 1e-3 ) fprintf( fp, " <%.0fus:%ld", limit * 1e6, hist[ p ][ b ] );
+         else if ( limit < 1.0 ) fprintf( fp, " <%.0fms:%ld", limit * 1e3, hist[ p ][ b ] );
+         else fprintf( fp, " <%.0fs:%ld", limit, hist[ p ][ b ] );
+      }
+      fprintf( fp, "\n" );
+   }
+   closeTrace( fp );
+}
+
+/*
+======================================================================
+KMTimerBegin()
+
+Start timing an invocation, if KM_TRACE is set.
+====================================================================== */
+void KMTimerBegin( KMTimer *timer )
+{
+   if ( !checked ) {
+      const char *env = getenv( "KM_TRACE" );
+
+      checked = 1;
+      if ( env && env[ 0 ] && strcmp( env, "0" )) {
+         traceOn = 1;
+         if ( strcmp( env, "1" ) && strcmp( env, "stderr" )) {
+            strncpy( tracePath, env, sizeof( tracePath ) - 1 );
+            tracePath[ sizeof( tracePath ) - 1 ] = 0;
+         }
+         atexit( report );
+      }
+   }
+
+   timer->enabled = traceOn;
+   if ( !traceOn ) return;
+
+   memset( timer->phase, 0, sizeof( timer->phase ));
+   timer->marked = 0;
+   timer->start = timer->last = now();
+}
+
+/*
+======================================================================
+KMTimerMarkPhase()
+
+Charge the time since the last mark to phase.  Called through the
+KMTimerMark() macro.
+====================================================================== */
+void KMTimerMarkPhase( KMTimer *timer, int phase )
+{
+   double t = now();
+
+   timer->phase[ phase ] += t - timer->last;
+   timer->marked |= 1 << phase;
+   timer->last = t;
+}
+
+/*
+======================================================================
+KMTimerEndRun()
+
+Add the phases reached to the histograms and write the trace line.
+Called through the KMTimerEnd() macro at the end of Activate().
+====================================================================== */
+void KMTimerEndRun( KMTimer *timer, int circles )
+{
+   double total = now() - timer->start;
+   FILE *fp;
+   int p;
+
+   runs++;
+   for ( p = 0; p < KMT_PHASES; p++ )
+      if ( timer->marked & ( 1 << p )) record( p, timer->phase[ p ] );
+   record( KMT_PHASES, total );
+
+   if ( !( fp = openTrace() )) return;
+   fprintf( fp, "3PointCircle %ld:", runs );
+   for ( p = 0; p < KMT_PHASES; p++ ) {
+      if ( timer->marked & ( 1 << p ))
+         fprintf( fp, " %s %.3f", phaseName[ p ], timer->phase[ p ] * 1e3 );
+      else
+         fprintf( fp, " %s -", phaseName[ p ] );
+   }
+   fprintf( fp, " total %.3f ms, %d circles\n", total * 1e3, circles );
+   closeTrace( fp );
+}
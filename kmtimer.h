@@ -0,0 +1,45 @@
+/*
+======================================================================
+kmtimer.h
+
+Per-phase timing of Activate().  Set the environment variable
+KM_TRACE to "1" or "stderr" for one line per invocation on stderr, or
+to a file name to append the lines to that file.  A histogram of every
+phase over the whole session is written to the same place when the
+plug-in is unloaded.  With KM_TRACE unset each mark is one test of
+timer.enabled.
+====================================================================== */
+
+#ifndef KMTIMER_H
+#define KMTIMER_H
+
+enum {
+   KMT_SCAN = 0,     /* selection counts and scans */
+   KMT_PANEL,        /* the XPanel, while the user looks at it */
+   KMT_LAYERS,       /* layer lists */
+   KMT_SOLVE,        /* circle math and fit refinement scans */
+   KMT_BUILD,        /* ring vertices and the new polygons */
+   KMT_RESTORE,      /* layer selection reset */
+   KMT_PHASES
+};
+
+typedef struct st_KMTimer {
+   int    enabled;
+   int    marked;    /* bit per phase reached */
+   double start;
+   double last;
+   double phase[ KMT_PHASES ];
+} KMTimer;
+
+void KMTimerBegin( KMTimer *timer );
+void KMTimerMarkPhase( KMTimer *timer, int phase );
+void KMTimerEndRun( KMTimer *timer, int circles );
+
+/* the phase since the last mark, or since KMTimerBegin(), ends now */
+#define KMTimerMark( timer, phase ) \
+   do { if (( timer )->enabled ) KMTimerMarkPhase( timer, phase ); } while ( 0 )
+
+#define KMTimerEnd( timer, circles ) \
+   do { if (( timer )->enabled ) KMTimerEndRun( timer, circles ); } while ( 0 )
+
+#endif
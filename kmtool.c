@@ -0,0 +1,410 @@
+/*
+======================================================================
+kmtool.c
+
+3PointCircleTool, the interactive MeshEditTool.
+
+Modeler calls the tool many times per mouse move, so the work is split
+by what actually changed.  start() and adjust() only store a handle and
+raise moved when its position differs.  solve() runs on the next
+draw() or build() that finds moved set: one ppp_circle3d, the side
+count, and one ppp_ring_emit into the ring buffer the tool owns.  The
+ring table is fetched again only when the side count changes.  draw()
+and build() otherwise read the buffer as it is, so a redraw without a
+drag costs one pass over the vertices.
+====================================================================== */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwserver.h>
+#include <lwmeshedt.h>
+#include <lwxpanel.h>
+#include <com_vecmatquat.h>
+#include "pppcir.h"
+#include "pppring.h"
+#include "kmtool.h"
+
+typedef struct st_KMTool {
+   LWXPanelFuncs *xpanf;
+   LWXPanelID  panel;
+   int         sides;        /* options, as in the command */
+   double      tolerance;
+   int         minSides;
+   int         maxSides;
+
+   double      handle[ 3 ][ 3 ];
+   int         handles;      /* placed so far */
+   int         moved;        /* a handle or an option changed since solve() */
+   int         dirty;        /* wireframe changed since draw() */
+   int         test;         /* LWT_TEST_* for the next test() */
+
+   int         valid;        /* three handles, not colinear */
+   v3_pos      center;
+   double      radius;
+   v3_vect     normal, axisU, axisV;
+   const ppp_ring *ring;
+   int         points;       /* vertices in ringXYZ */
+   int         capacity;
+   double    (*ringXYZ)[ 3 ];
+   LWPntID    *pntID;
+} KMTool;
+
+/*
+======================================================================
+solve()
+
+Bring the circle and ring buffer up to date with the handles.
+====================================================================== */
+static void solve( KMTool *tool )
+{
+   v3_pos p[ 3 ];
+   int i, sides;
+
+   if ( !tool->moved ) return;
+   tool->moved = 0;
+   tool->valid = 0;
+   if ( tool->handles < 3 ) return;
+
+   for ( i = 0; i < 3; i++ ) {
+      p[ i ].x = tool->handle[ i ][ 0 ];
+      p[ i ].y = tool->handle[ i ][ 1 ];
+      p[ i ].z = tool->handle[ i ][ 2 ];
+   }
+   if ( !ppp_circle3d( &p[ 0 ], &p[ 1 ], &p[ 2 ], &tool->center, &tool->radius,
+      &tool->normal, &tool->axisU, &tool->axisV )) return;
+
+   sides = tool->sides;
+   if ( tool->tolerance > 0.0 )
+      sides = ppp_ring_sides( tool->radius, tool->tolerance, tool->minSides, tool->maxSides );
+
+   if ( !tool->ring || tool->ring->sides != sides ) {
+      if ( !( tool->ring = ppp_ring_table( sides ))) return;
+   }
+
+   if ( sides > tool->capacity ) {
+      double ( *xyz )[ 3 ] = realloc( tool->ringXYZ, sides * sizeof( *xyz ));
+      LWPntID *id = realloc( tool->pntID, sides * sizeof( LWPntID ));
+
+      if ( xyz ) tool->ringXYZ = xyz;
+      if ( id ) tool->pntID = id;
+      if ( !xyz || !id ) return;
+      tool->capacity = sides;
+   }
+
+   ppp_ring_emit( tool->ring, &tool->center, tool->radius, &tool->axisU, &tool->axisV,
+      tool->ringXYZ );
+   tool->points = sides;
+   tool->valid = 1;
+}
+
+static void touch( KMTool *tool )
+{
+   tool->moved = 1;
+   tool->dirty = 1;
+   tool->test = LWT_TEST_UPDATE;
+}
+
+static void reset( KMTool *tool )
+{
+   tool->handles = 0;
+   tool->valid = 0;
+   tool->moved = 0;
+   tool->dirty = 1;
+}
+
+/*
+======================================================================
+Tool callbacks
+====================================================================== */
+
+static void Done( LWInstance inst )
+{
+   KMTool *tool = inst;
+
+   if ( tool->panel ) tool->xpanf->destroy( tool->panel );
+   free( tool->ringXYZ );
+   free( tool->pntID );
+   free( tool );
+}
+
+static void Draw( LWInstance inst, LWWireDrawAccess *draw )
+{
+   KMTool *tool = inst;
+   LWFVector v;
+   int i;
+
+   solve( tool );
+   tool->dirty = 0;
+
+   /* the handles, joined in order */
+   for ( i = 0; i < tool->handles; i++ ) {
+      VCPY( v, tool->handle[ i ] );
+      if ( i == 0 ) draw->moveTo( draw->data, v, LWWIRE_DASH );
+      else draw->lineTo( draw->data, v, LWWIRE_ABSOLUTE );
+   }
+
+   if ( !tool->valid ) return;
+   VCPY( v, tool->ringXYZ[ 0 ] );
+   draw->moveTo( draw->data, v, LWWIRE_SOLID );
+   for ( i = 1; i <= tool->points; i++ ) {
+      VCPY( v, tool->ringXYZ[ i % tool->points ] );
+      draw->lineTo( draw->data, v, LWWIRE_ABSOLUTE );
+   }
+}
+
+static const char *Help( LWInstance inst, LWToolEvent *event )
+{
+   KMTool *tool = inst;
+
+   if ( tool->handles < 3 ) return "Click to place the three points of the circle.";
+   if ( !tool->moved && !tool->valid ) return "The points are colinear; drag one of them.";
+   return "Drag a point to move the circle.";
+}
+
+static int Dirty( LWInstance inst )
+{
+   KMTool *tool = inst;
+
+   return tool->dirty ? LWT_DIRTY_WIREFRAME | LWT_DIRTY_HELPTEXT : 0;
+}
+
+static int Count( LWInstance inst, LWToolEvent *event )
+{
+   KMTool *tool = inst;
+
+   return tool->handles;
+}
+
+static int Handle( LWInstance inst, LWToolEvent *event, int i, LWDVector pos )
+{
+   KMTool *tool = inst;
+
+   VCPY( pos, tool->handle[ i ] );
+   return 1;
+}
+
+/*
+======================================================================
+Start()
+
+A click away from the handles places the next one, or picks up the
+nearest once all three are down.
+====================================================================== */
+static int Start( LWInstance inst, LWToolEvent *event )
+{
+   KMTool *tool = inst;
+   double d, best = 0.0;
+   int i, k = 0;
+
+   if ( tool->handles < 3 ) {
+      VCPY( tool->handle[ tool->handles ], event->posSnap );
+      touch( tool );
+      return tool->handles++;
+   }
+
+   for ( i = 0; i < 3; i++ ) {
+      d = ( tool->handle[ i ][ 0 ] - event->posRaw[ 0 ] ) * ( tool->handle[ i ][ 0 ] - event->posRaw[ 0 ] )
+        + ( tool->handle[ i ][ 1 ] - event->posRaw[ 1 ] ) * ( tool->handle[ i ][ 1 ] - event->posRaw[ 1 ] )
+        + ( tool->handle[ i ][ 2 ] - event->posRaw[ 2 ] ) * ( tool->handle[ i ][ 2 ] - event->posRaw[ 2 ] );
+      if ( i == 0 || d < best ) {
+         best = d;
+         k = i;
+      }
+   }
+   return k;
+}
+
+/*
+======================================================================
+Adjust()
+
+Drag handle i.  Nothing is marked when the snapped position is the
+one the handle already has.
+====================================================================== */
+static int Adjust( LWInstance inst, LWToolEvent *event, int i )
+{
+   KMTool *tool = inst;
+
+   if ( tool->handle[ i ][ 0 ] == event->posSnap[ 0 ]
+     && tool->handle[ i ][ 1 ] == event->posSnap[ 1 ]
+     && tool->handle[ i ][ 2 ] == event->posSnap[ 2 ] ) return i;
+
+   VCPY( tool->handle[ i ], event->posSnap );
+   touch( tool );
+   return i;
+}
+
+static void Event( LWInstance inst, int code )
+{
+   KMTool *tool = inst;
+
+   switch ( code ) {
+      case LWT_EVENT_DROP:
+         reset( tool );
+         tool->test = LWT_TEST_REJECT;
+         break;
+      case LWT_EVENT_RESET:
+         tool->sides = 32;
+         tool->tolerance = 0.0;
+         tool->minSides = 8;
+         tool->maxSides = 256;
+         if ( tool->handles == 3 ) touch( tool );
+         break;
+      case LWT_EVENT_ACTIVATE:
+         tool->test = LWT_TEST_ACCEPT;
+         break;
+   }
+}
+
+/*
+======================================================================
+Panel
+
+A view panel on the options.  Any change resolves the ring on the
+next draw.
+====================================================================== */
+
+enum { ID_SIDES = 0x8001, ID_TOLERANCE, ID_MINSIDES, ID_MAXSIDES };
+
+static void *PanelGet( void *inst, unsigned long vid )
+{
+   KMTool *tool = inst;
+
+   switch ( vid ) {
+      case ID_SIDES:     return &tool->sides;
+      case ID_TOLERANCE: return &tool->tolerance;
+      case ID_MINSIDES:  return &tool->minSides;
+      case ID_MAXSIDES:  return &tool->maxSides;
+   }
+   return NULL;
+}
+
+static int PanelSet( void *inst, unsigned long vid, void *value )
+{
+   KMTool *tool = inst;
+
+   switch ( vid ) {
+      case ID_SIDES:     tool->sides = *(int *)value;  break;
+      case ID_TOLERANCE: tool->tolerance = *(double *)value;  break;
+      case ID_MINSIDES:  tool->minSides = *(int *)value;  break;
+      case ID_MAXSIDES:  tool->maxSides = *(int *)value;  break;
+      default:           return LWXPRC_NONE;
+   }
+   if ( tool->sides < 3 ) tool->sides = 3;
+   if ( tool->minSides < 3 ) tool->minSides = 3;
+   if ( tool->maxSides < tool->minSides ) tool->maxSides = tool->minSides;
+   if ( tool->handles == 3 ) touch( tool );
+   return LWXPRC_DRAW;
+}
+
+static LWXPanelID Panel( LWInstance inst )
+{
+   KMTool *tool = inst;
+
+   static LWXPanelControl ctl[] = {
+      { ID_SIDES, "Number of Sides", "integer" },
+      { ID_TOLERANCE, "Chord Tolerance", "distance" },
+      { ID_MINSIDES, "Min Sides", "integer" },
+      { ID_MAXSIDES, "Max Sides", "integer" },
+      { 0 }
+   };
+   static LWXPanelDataDesc cdata[] = {
+      { ID_SIDES, "Number of Sides", "integer" },
+      { ID_TOLERANCE, "Chord Tolerance", "distance" },
+      { ID_MINSIDES, "Min Sides", "integer" },
+      { ID_MAXSIDES, "Max Sides", "integer" },
+      { 0 }
+   };
+
+   if ( tool->panel ) return tool->panel;
+   if ( !( tool->panel = tool->xpanf->create( LWXP_VIEW, ctl ))) return NULL;
+   tool->xpanf->describe( tool->panel, cdata, PanelGet, PanelSet );
+   tool->xpanf->viewInst( tool->panel, tool );
+   return tool->panel;
+}
+
+/*
+======================================================================
+MeshEditTool callbacks
+====================================================================== */
+
+static int Test( LWInstance inst )
+{
+   KMTool *tool = inst;
+   int test = tool->test;
+
+   tool->test = LWT_TEST_NOTHING;
+   return test;
+}
+
+/*
+======================================================================
+Build()
+
+Modeler undoes the previous build before calling this, so the ring
+is added whole each time, from the buffer solve() keeps.
+====================================================================== */
+static LWError Build( LWInstance inst, MeshEditOp *edit )
+{
+   KMTool *tool = inst;
+   int i;
+
+   solve( tool );
+   if ( !tool->valid ) return NULL;
+
+   for ( i = 0; i < tool->points; i++ )
+      tool->pntID[ i ] = edit->addPoint( edit->state, tool->ringXYZ[ i ] );
+   edit->addFace( edit->state, NULL, tool->points, tool->pntID );
+   return NULL;
+}
+
+/*
+======================================================================
+End()
+
+The ring was kept or dropped; either way the next click starts a
+new one.
+====================================================================== */
+static void End( LWInstance inst, int keep )
+{
+   KMTool *tool = inst;
+
+   reset( tool );
+}
+
+/*
+======================================================================
+ActivateTool()
+
+The activation function of 3PointCircleTool.
+====================================================================== */
+XCALL_( int )
+ActivateTool( long version, GlobalFunc *global, LWMeshEditTool *local,
+   void *serverData )
+{
+   KMTool *tool;
+
+   if ( version != LWMESHEDITTOOL_VERSION ) return AFUNC_BADVERSION;
+
+   if ( !( tool = calloc( 1, sizeof( KMTool )))) return AFUNC_BADAPP;
+   tool->xpanf = global( LWXPANELFUNCS_GLOBAL, GFUSE_TRANSIENT );
+   tool->sides = 32;
+   tool->minSides = 8;
+   tool->maxSides = 256;
+
+   local->instance = tool;
+   local->tool->done = Done;
+   local->tool->draw = Draw;
+   local->tool->help = Help;
+   local->tool->dirty = Dirty;
+   local->tool->count = Count;
+   local->tool->handle = Handle;
+   local->tool->start = Start;
+   local->tool->adjust = Adjust;
+   local->tool->event = Event;
+   local->tool->panel = tool->xpanf ? Panel : NULL;
+   local->test = Test;
+   local->build = Build;
+   local->end = End;
+   return AFUNC_OK;
+}
@@ -0,0 +1,19 @@
+/*
+======================================================================
+kmtool.h
+
+3PointCircleTool, the interactive MeshEditTool.  Click three points,
+then drag any of them; the ring through them follows live.
+====================================================================== */
+
+#ifndef KMTOOL_H
+#define KMTOOL_H
+
+#include <lwserver.h>
+#include <lwmeshedt.h>
+
+XCALL_( int )
+ActivateTool( long version, GlobalFunc *global, LWMeshEditTool *local,
+   void *serverData );
+
+#endif
@@ -0,0 +1,672 @@
+/*
+** pppbatch.c
+**
+** Contents: Batched 3 point circle for large sets of triples stored as
+**    structure-of-arrays, with SSE2 and AVX2 kernels selected at run time.
+**
+** Each triple i is given by (x1[i], y1[i]), (x2[i], y2[i]) and
+** (x3[i], y3[i]).  The kernels evaluate the determinant form used by
+** ppp_circle_closed in pppcir.c: one division per triple and no special
+** cases for horizontal or vertical bisectors.
+**
+** Tolerance: for triples whose smallest angle is above 1e-3 radians the
+** centers and radii agree with ppp_circle to within 1e-9 of the radius.
+** Beyond that both solvers lose digits in proportion to 1/sin(angle)
+** and only the results of the same solver should be compared.
+**
+** Degenerate triples are rejected as by ppp_classify in pppcir.c: the
+** vector kernels compute the orientation determinant with Shewchuk's
+** error bound and the sliver test with PPP_MIN_SINE in every lane, and
+** hand the few lanes whose sign the bound cannot settle to the scalar
+** kernel, which uses the exact ppp_orient2d.  The sliver test takes the
+** same differences and products in the same order as ppp_classify, so
+** a lane passes it exactly when ppp_classify would, unless one of them
+** is compiled with fused multiply-adds.  Invalid entries get a zero
+** center and radius and valid[i] == 0.
+**
+** ppp_circle_batch_mt splits the triples into chunks of PPP_MT_CHUNK and
+** runs ppp_circle_batch on them with ppp_parallel_for (pppthread.c).
+** Each chunk writes only its own slice of the outputs, so there are no
+** locks, and the outputs and count are the same for any thread count.
+**
+** ppp_affine_batch applies a 3 x 4 affine matrix to points stored as
+** structure-of-arrays and writes them interleaved, as meAddPoint takes
+** them.  It uses the same kernel selection.  Every kernel forms
+** m[k][3] + m[k][0] x + m[k][1] y + m[k][2] z left to right with
+** separate multiplies and adds, so all of them give the same bits.
+**
+** The kernel selection is read from worker threads, the panel thread
+** and the pppqual workers among them, so it is only touched with
+** atomic loads and stores.  The first read detects the CPU and stores
+** its choice with a compare and swap, which every racing first read
+** agrees with, and ppp_batch_set_isa stores its choice in one step.
+*/
+
+#include <float.h>
+#include <stdlib.h>
+#include "pppcir.h"
+#include "pppthread.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define PPP_X86 1
+#endif
+
+#if defined(PPP_X86) && (defined(__GNUC__) || defined(__clang__))
+#define PPP_HAVE_SSE2 1
+#define PPP_HAVE_AVX2 1
+#define PPP_TARGET(isa) __attribute__((target(isa)))
+#elif defined(PPP_X86) && defined(_MSC_VER)
+#if _MSC_VER >= 1310
+#define PPP_HAVE_SSE2 1
+#endif
+#if _MSC_VER >= 1700
+#define PPP_HAVE_AVX2 1
+#endif
+#define PPP_TARGET(isa)
+#endif
+
+#if defined(PPP_HAVE_SSE2) || defined(PPP_HAVE_AVX2)
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER) && (_MSC_VER >= 1400)
+#include <intrin.h>
+#define PPP_INTERLOCKED 1
+#endif
+
+static volatile long ppp_isa = PPP_ISA_AUTO;
+
+/* arguments of ppp_circle_batch_mt, shared by its workers */
+typedef struct PPP_BATCH_MT
+{
+ int n;
+ const double *x1, *y1, *x2, *y2, *x3, *y3;
+ double *cx, *cy, *radius;
+ unsigned char *valid;
+ int *count;
+} ppp_batch_mt;
+
+/* 2^-53, and the orient2d error bound of ppp_orient2d */
+#define PPP_EPSILON (DBL_EPSILON * 0.5)
+#define PPP_CCW_BOUND ((3.0 + 16.0 * PPP_EPSILON) * PPP_EPSILON)
+
+/*
+** Function ppp_batch_scalar -- Portable kernel, also used for the tail
+**    of the vector kernels
+**
+** Return value: int
+**  number of valid circles in [first, n)
+*/
+static int ppp_batch_scalar(int first, int n,
+      const double *x1, const double *y1,
+      const double *x2, const double *y2,
+      const double *x3, const double *y3,
+      double *cx, double *cy, double *radius, unsigned char *valid)
+{
+ int i, count = 0;
+
+ for (i = first; i < n; i++) {
+  double bx, by, qx, qy, b2, q2, d, inv, ux, uy, r2;
+  v2_pos p1, p2, p3;
+
+  p1.x = x1[i]; p1.y = y1[i];
+  p2.x = x2[i]; p2.y = y2[i];
+  p3.x = x3[i]; p3.y = y3[i];
+  if (ppp_classify(&p1, &p2, &p3, PPP_MIN_SINE) != PPP_TRIPLE_OK) {
+   cx[i] = cy[i] = radius[i] = 0.0;
+   valid[i] = 0;
+   continue;
+  }
+
+  bx = x2[i] - x1[i];
+  by = y2[i] - y1[i];
+  qx = x3[i] - x1[i];
+  qy = y3[i] - y1[i];
+  b2 = bx * bx + by * by;
+  q2 = qx * qx + qy * qy;
+  d = 2.0 * (bx * qy - by * qx);
+
+  if (d != 0.0) {
+   inv = 1.0 / d;
+   ux = (qy * b2 - by * q2) * inv;
+   uy = (bx * q2 - qx * b2) * inv;
+   r2 = ux * ux + uy * uy;
+  } else ux = uy = r2 = 0.0;
+
+  if ((d != 0.0) && (r2 <= DBL_MAX)) {
+   cx[i] = x1[i] + ux;
+   cy[i] = y1[i] + uy;
+   radius[i] = sqrt(r2);
+   valid[i] = 1;
+   count++;
+  } else {
+   cx[i] = cy[i] = radius[i] = 0.0;
+   valid[i] = 0;
+  }
+ }
+ return count;
+}
+
+#ifdef PPP_HAVE_SSE2
+/*
+** Function ppp_batch_sse2 -- Two triples per iteration
+*/
+PPP_TARGET("sse2")
+static int ppp_batch_sse2(int n,
+      const double *x1, const double *y1,
+      const double *x2, const double *y2,
+      const double *x3, const double *y3,
+      double *cx, double *cy, double *radius, unsigned char *valid)
+{
+ const __m128d zero = _mm_setzero_pd();
+ const __m128d one = _mm_set1_pd(1.0);
+ const __m128d two = _mm_set1_pd(2.0);
+ const __m128d big = _mm_set1_pd(DBL_MAX);
+ const __m128d bound = _mm_set1_pd(PPP_CCW_BOUND);
+ const __m128d sine2 = _mm_set1_pd(PPP_MIN_SINE * PPP_MIN_SINE);
+ const __m128d absmask = _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffLL));
+ int i, k, bits, unsure, count = 0;
+
+ for (i = 0; i + 2 <= n; i += 2) {
+  __m128d ax, ay, bx, by, qx, qy, b2, q2, d, inv, ux, uy, r2, ok;
+  __m128d dl, dr, ex, ey, e2, emin, sure, fat;
+
+  ax = _mm_loadu_pd(x1 + i);
+  ay = _mm_loadu_pd(y1 + i);
+  bx = _mm_sub_pd(_mm_loadu_pd(x2 + i), ax);
+  by = _mm_sub_pd(_mm_loadu_pd(y2 + i), ay);
+  qx = _mm_sub_pd(_mm_loadu_pd(x3 + i), ax);
+  qy = _mm_sub_pd(_mm_loadu_pd(y3 + i), ay);
+  b2 = _mm_add_pd(_mm_mul_pd(bx, bx), _mm_mul_pd(by, by));
+  q2 = _mm_add_pd(_mm_mul_pd(qx, qx), _mm_mul_pd(qy, qy));
+  dl = _mm_mul_pd(bx, qy);
+  dr = _mm_mul_pd(by, qx);
+  d = _mm_sub_pd(dl, dr);
+
+  /* orientation filter, and the sliver test of ppp_classify with its
+     third edge p3 - p2, not q - b, and its products in its order, so
+     that every lane rounds as it does */
+  sure = _mm_cmpgt_pd(_mm_and_pd(d, absmask),
+       _mm_mul_pd(bound, _mm_add_pd(_mm_and_pd(dl, absmask), _mm_and_pd(dr, absmask))));
+  ex = _mm_sub_pd(_mm_loadu_pd(x3 + i), _mm_loadu_pd(x2 + i));
+  ey = _mm_sub_pd(_mm_loadu_pd(y3 + i), _mm_loadu_pd(y2 + i));
+  e2 = _mm_add_pd(_mm_mul_pd(ex, ex), _mm_mul_pd(ey, ey));
+  emin = _mm_min_pd(_mm_min_pd(b2, q2), e2);
+  fat = _mm_cmpge_pd(_mm_mul_pd(_mm_mul_pd(d, d), emin),
+       _mm_mul_pd(_mm_mul_pd(_mm_mul_pd(sine2, b2), q2), e2));
+  d = _mm_mul_pd(two, d);
+
+  inv = _mm_div_pd(one, d);
+  ux = _mm_mul_pd(_mm_sub_pd(_mm_mul_pd(qy, b2), _mm_mul_pd(by, q2)), inv);
+  uy = _mm_mul_pd(_mm_sub_pd(_mm_mul_pd(bx, q2), _mm_mul_pd(qx, b2)), inv);
+  r2 = _mm_add_pd(_mm_mul_pd(ux, ux), _mm_mul_pd(uy, uy));
+
+  /* NaN and overflow both fail the r2 <= DBL_MAX compare */
+  ok = _mm_and_pd(_mm_and_pd(sure, fat),
+       _mm_and_pd(_mm_cmpneq_pd(d, zero), _mm_cmple_pd(r2, big)));
+
+  _mm_storeu_pd(cx + i, _mm_and_pd(ok, _mm_add_pd(ax, ux)));
+  _mm_storeu_pd(cy + i, _mm_and_pd(ok, _mm_add_pd(ay, uy)));
+  _mm_storeu_pd(radius + i, _mm_and_pd(ok, _mm_sqrt_pd(r2)));
+
+  bits = _mm_movemask_pd(ok);
+  valid[i] = (unsigned char)(bits & 1);
+  valid[i + 1] = (unsigned char)((bits >> 1) & 1);
+  count += (bits & 1) + ((bits >> 1) & 1);
+
+  /* lanes the filter could not settle are redone exactly */
+  unsure = ~_mm_movemask_pd(sure) & 3;
+  for (k = 0; unsure; k++, unsure >>= 1)
+   if (unsure & 1)
+    count += ppp_batch_scalar(i + k, i + k + 1, x1, y1, x2, y2, x3, y3,
+      cx, cy, radius, valid);
+ }
+ return count + ppp_batch_scalar(i, n, x1, y1, x2, y2, x3, y3,
+      cx, cy, radius, valid);
+}
+#endif
+
+#ifdef PPP_HAVE_AVX2
+/*
+** Function ppp_batch_avx2 -- Four triples per iteration
+*/
+PPP_TARGET("avx2")
+static int ppp_batch_avx2(int n,
+      const double *x1, const double *y1,
+      const double *x2, const double *y2,
+      const double *x3, const double *y3,
+      double *cx, double *cy, double *radius, unsigned char *valid)
+{
+ const __m256d zero = _mm256_setzero_pd();
+ const __m256d one = _mm256_set1_pd(1.0);
+ const __m256d two = _mm256_set1_pd(2.0);
+ const __m256d big = _mm256_set1_pd(DBL_MAX);
+ const __m256d bound = _mm256_set1_pd(PPP_CCW_BOUND);
+ const __m256d sine2 = _mm256_set1_pd(PPP_MIN_SINE * PPP_MIN_SINE);
+ const __m256d absmask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+ int i, k, bits, unsure, count = 0;
+
+ for (i = 0; i + 4 <= n; i += 4) {
+  __m256d ax, ay, bx, by, qx, qy, b2, q2, d, inv, ux, uy, r2, ok;
+  __m256d dl, dr, ex, ey, e2, emin, sure, fat;
+
+  ax = _mm256_loadu_pd(x1 + i);
+  ay = _mm256_loadu_pd(y1 + i);
+  bx = _mm256_sub_pd(_mm256_loadu_pd(x2 + i), ax);
+  by = _mm256_sub_pd(_mm256_loadu_pd(y2 + i), ay);
+  qx = _mm256_sub_pd(_mm256_loadu_pd(x3 + i), ax);
+  qy = _mm256_sub_pd(_mm256_loadu_pd(y3 + i), ay);
+  b2 = _mm256_add_pd(_mm256_mul_pd(bx, bx), _mm256_mul_pd(by, by));
+  q2 = _mm256_add_pd(_mm256_mul_pd(qx, qx), _mm256_mul_pd(qy, qy));
+  dl = _mm256_mul_pd(bx, qy);
+  dr = _mm256_mul_pd(by, qx);
+  d = _mm256_sub_pd(dl, dr);
+
+  sure = _mm256_cmp_pd(_mm256_and_pd(d, absmask),
+       _mm256_mul_pd(bound, _mm256_add_pd(_mm256_and_pd(dl, absmask),
+       _mm256_and_pd(dr, absmask))), _CMP_GT_OQ);
+  ex = _mm256_sub_pd(_mm256_loadu_pd(x3 + i), _mm256_loadu_pd(x2 + i));
+  ey = _mm256_sub_pd(_mm256_loadu_pd(y3 + i), _mm256_loadu_pd(y2 + i));
+  e2 = _mm256_add_pd(_mm256_mul_pd(ex, ex), _mm256_mul_pd(ey, ey));
+  emin = _mm256_min_pd(_mm256_min_pd(b2, q2), e2);
+  fat = _mm256_cmp_pd(_mm256_mul_pd(_mm256_mul_pd(d, d), emin),
+       _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(sine2, b2), q2), e2), _CMP_GE_OQ);
+  d = _mm256_mul_pd(two, d);
+
+  inv = _mm256_div_pd(one, d);
+  ux = _mm256_mul_pd(_mm256_sub_pd(_mm256_mul_pd(qy, b2), _mm256_mul_pd(by, q2)), inv);
+  uy = _mm256_mul_pd(_mm256_sub_pd(_mm256_mul_pd(bx, q2), _mm256_mul_pd(qx, b2)), inv);
+  r2 = _mm256_add_pd(_mm256_mul_pd(ux, ux), _mm256_mul_pd(uy, uy));
+
+  ok = _mm256_and_pd(_mm256_and_pd(sure, fat),
+       _mm256_and_pd(_mm256_cmp_pd(d, zero, _CMP_NEQ_OQ),
+       _mm256_cmp_pd(r2, big, _CMP_LE_OQ)));
+
+  _mm256_storeu_pd(cx + i, _mm256_and_pd(ok, _mm256_add_pd(ax, ux)));
+  _mm256_storeu_pd(cy + i, _mm256_and_pd(ok, _mm256_add_pd(ay, uy)));
+  _mm256_storeu_pd(radius + i, _mm256_and_pd(ok, _mm256_sqrt_pd(r2)));
+
+  bits = _mm256_movemask_pd(ok);
+  for (k = 0; k < 4; k++) {
+   valid[i + k] = (unsigned char)((bits >> k) & 1);
+   count += (bits >> k) & 1;
+  }
+
+  unsure = ~_mm256_movemask_pd(sure) & 15;
+  for (k = 0; unsure; k++, unsure >>= 1)
+   if (unsure & 1)
+    count += ppp_batch_scalar(i + k, i + k + 1, x1, y1, x2, y2, x3, y3,
+      cx, cy, radius, valid);
+ }
+ return count + ppp_batch_scalar(i, n, x1, y1, x2, y2, x3, y3,
+      cx, cy, radius, valid);
+}
+#endif
+
+/*
+** Function ppp_affine_scalar -- Portable affine kernel, also used for
+**    the tail of the vector kernels
+*/
+static void ppp_affine_scalar(int first, int n, const double m[3][4],
+      const double *x, const double *y, const double *z, double (*xyz)[3])
+{
+ double c[3][4];
+ int i, j, k;
+
+ /* in locals, which the stores to xyz cannot overwrite */
+ for (k = 0; k < 3; k++)
+  for (j = 0; j < 4; j++) c[k][j] = m[k][j];
+
+ if (z) {
+  for (i = first; i < n; i++) {
+   xyz[i][0] = c[0][3] + c[0][0] * x[i] + c[0][1] * y[i] + c[0][2] * z[i];
+   xyz[i][1] = c[1][3] + c[1][0] * x[i] + c[1][1] * y[i] + c[1][2] * z[i];
+   xyz[i][2] = c[2][3] + c[2][0] * x[i] + c[2][1] * y[i] + c[2][2] * z[i];
+  }
+ } else {
+  for (i = first; i < n; i++) {
+   xyz[i][0] = c[0][3] + c[0][0] * x[i] + c[0][1] * y[i];
+   xyz[i][1] = c[1][3] + c[1][0] * x[i] + c[1][1] * y[i];
+   xyz[i][2] = c[2][3] + c[2][0] * x[i] + c[2][1] * y[i];
+  }
+ }
+}
+
+#ifdef PPP_HAVE_SSE2
+/*
+** Function ppp_affine_sse2 -- Two points per iteration
+*/
+PPP_TARGET("sse2")
+static void ppp_affine_sse2(int n, const double m[3][4],
+      const double *x, const double *y, const double *z, double (*xyz)[3])
+{
+ __m128d c[3][4];
+ double *out = xyz[0];
+ int i, j, k;
+
+ for (k = 0; k < 3; k++)
+  for (j = 0; j < 4; j++) c[k][j] = _mm_set1_pd(m[k][j]);
+
+ for (i = 0; i + 2 <= n; i += 2) {
+  __m128d px, py, pz, r[3];
+
+  px = _mm_loadu_pd(x + i);
+  py = _mm_loadu_pd(y + i);
+  for (k = 0; k < 3; k++)
+   r[k] = _mm_add_pd(_mm_add_pd(c[k][3], _mm_mul_pd(c[k][0], px)), _mm_mul_pd(c[k][1], py));
+  if (z) {
+   pz = _mm_loadu_pd(z + i);
+   for (k = 0; k < 3; k++) r[k] = _mm_add_pd(r[k], _mm_mul_pd(c[k][2], pz));
+  }
+
+  /* x0 y0 | z0 x1 | y1 z1 */
+  _mm_storeu_pd(out + 3 * i, _mm_unpacklo_pd(r[0], r[1]));
+  _mm_storeu_pd(out + 3 * i + 2, _mm_shuffle_pd(r[2], r[0], 2));
+  _mm_storeu_pd(out + 3 * i + 4, _mm_unpackhi_pd(r[1], r[2]));
+ }
+ ppp_affine_scalar(i, n, m, x, y, z, xyz);
+}
+#endif
+
+#ifdef PPP_HAVE_AVX2
+/*
+** Function ppp_affine_avx2 -- Four points per iteration
+*/
+PPP_TARGET("avx2")
+static void ppp_affine_avx2(int n, const double m[3][4],
+      const double *x, const double *y, const double *z, double (*xyz)[3])
+{
+ __m256d c[3][4];
+ double *out = xyz[0];
+ int i, j, k;
+
+ for (k = 0; k < 3; k++)
+  for (j = 0; j < 4; j++) c[k][j] = _mm256_set1_pd(m[k][j]);
+
+ for (i = 0; i + 4 <= n; i += 4) {
+  __m256d px, py, pz, r[3], lo, hi, s, u;
+
+  px = _mm256_loadu_pd(x + i);
+  py = _mm256_loadu_pd(y + i);
+  for (k = 0; k < 3; k++)
+   r[k] = _mm256_add_pd(_mm256_add_pd(c[k][3], _mm256_mul_pd(c[k][0], px)),
+        _mm256_mul_pd(c[k][1], py));
+  if (z) {
+   pz = _mm256_loadu_pd(z + i);
+   for (k = 0; k < 3; k++) r[k] = _mm256_add_pd(r[k], _mm256_mul_pd(c[k][2], pz));
+  }
+
+  /* x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3 */
+  lo = _mm256_unpacklo_pd(r[0], r[1]);    /* x0 y0 x2 y2 */
+  hi = _mm256_unpackhi_pd(r[0], r[1]);    /* x1 y1 x3 y3 */
+  s = _mm256_shuffle_pd(r[2], hi, 0x0);   /* z0 x1 z2 x3 */
+  u = _mm256_shuffle_pd(hi, r[2], 0xF);   /* y1 z1 y3 z3 */
+  _mm256_storeu_pd(out + 3 * i, _mm256_permute2f128_pd(lo, s, 0x20));
+  _mm256_storeu_pd(out + 3 * i + 4, _mm256_permute2f128_pd(u, lo, 0x30));
+  _mm256_storeu_pd(out + 3 * i + 8, _mm256_permute2f128_pd(s, u, 0x31));
+ }
+
+ /*
+ ** The compiler does not clear the upper halves on the way out of a
+ ** target("avx2") function, and the SSE code after it stalls on them
+ */
+ _mm256_zeroupper();
+ ppp_affine_scalar(i, n, m, x, y, z, xyz);
+}
+#endif
+
+/*
+** Function ppp_cpu_isa -- Best instruction set supported by this CPU
+**    and operating system
+*/
+static int ppp_cpu_isa(void)
+{
+#if defined(PPP_X86) && (defined(__GNUC__) || defined(__clang__))
+ __builtin_cpu_init();
+ if (__builtin_cpu_supports("avx2")) return PPP_ISA_AVX2;
+ if (__builtin_cpu_supports("sse2")) return PPP_ISA_SSE2;
+#elif defined(PPP_X86) && defined(PPP_INTERLOCKED)
+ int info[4];
+
+ __cpuid(info, 0);
+ if (info[0] >= 7) {
+#ifdef PPP_HAVE_AVX2
+  int leaf1[4];
+
+  __cpuid(leaf1, 1);
+  __cpuidex(info, 7, 0);
+  /* AVX2 needs OSXSAVE and the OS saving the YMM state */
+  if ((info[1] & (1 << 5)) && (leaf1[2] & (1 << 27))
+      && ((_xgetbv(0) & 6) == 6)) return PPP_ISA_AVX2;
+#endif
+ }
+ __cpuid(info, 1);
+ if (info[3] & (1 << 26)) return PPP_ISA_SSE2;
+#endif
+ return PPP_ISA_SCALAR;
+}
+
+/*
+** Function ppp_best_isa -- Best instruction set with a kernel built in
+*/
+static int ppp_best_isa(void)
+{
+ int isa = ppp_cpu_isa();
+
+#ifndef PPP_HAVE_AVX2
+ if (isa == PPP_ISA_AVX2) isa = PPP_ISA_SSE2;
+#endif
+#ifndef PPP_HAVE_SSE2
+ if (isa == PPP_ISA_SSE2) isa = PPP_ISA_SCALAR;
+#endif
+ return isa;
+}
+
+/*
+** Function isa_load, isa_cas, isa_store -- Atomic access to ppp_isa
+**
+** Compilers before Visual C++ 2005 have no intrinsics for them and get
+** plain volatile accesses, which x86 makes atomic for an aligned long.
+** A racing first read there stores the same value anyway.
+*/
+static long isa_load(void)
+{
+#if defined(PPP_INTERLOCKED)
+ return _InterlockedCompareExchange(&ppp_isa, 0, 0);
+#elif defined(_MSC_VER)
+ return ppp_isa;
+#else
+ return __atomic_load_n(&ppp_isa, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static void isa_cas(long expected, long desired)
+{
+#if defined(PPP_INTERLOCKED)
+ _InterlockedCompareExchange(&ppp_isa, desired, expected);
+#elif defined(_MSC_VER)
+ if (ppp_isa == expected) ppp_isa = desired;
+#else
+ __atomic_compare_exchange_n(&ppp_isa, &expected, desired, 0,
+   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static void isa_store(long value)
+{
+#if defined(PPP_INTERLOCKED)
+ _InterlockedExchange(&ppp_isa, value);
+#elif defined(_MSC_VER)
+ ppp_isa = value;
+#else
+ __atomic_store_n(&ppp_isa, value, __ATOMIC_RELEASE);
+#endif
+}
+
+/*
+** Function ppp_batch_isa -- Instruction set ppp_circle_batch will use
+*/
+int ppp_batch_isa(void)
+{
+ long isa = isa_load();
+
+ /* a ppp_batch_set_isa racing the first read wins */
+ if (isa == PPP_ISA_AUTO) {
+  isa_cas(PPP_ISA_AUTO, ppp_best_isa());
+  isa = isa_load();
+ }
+ return (int)isa;
+}
+
+/*
+** Function ppp_batch_set_isa -- Force an instruction set, mainly for
+**    benchmarking and comparing kernels
+**
+** Return value: int
+**  true  isa selected
+**  false isa not supported here, selection unchanged
+*/
+int ppp_batch_set_isa(int isa)
+{
+ int best = ppp_best_isa();
+
+ if (isa == PPP_ISA_AUTO) isa = best;
+ else if ((isa < PPP_ISA_SCALAR) || (isa > best)) return false;
+ isa_store(isa);
+ return true;
+}
+
+const char *ppp_batch_isa_name(int isa)
+{
+ switch (isa) {
+  case PPP_ISA_SCALAR: return "scalar";
+  case PPP_ISA_SSE2:   return "sse2";
+  case PPP_ISA_AVX2:   return "avx2";
+ }
+ return "auto";
+}
+
+/*
+** Function ppp_circle_batch -- Find the circles through n triples
+**
+** Inputs:
+**  n       number of triples
+**  x1..y3  coordinate arrays of the first, second and third points
+**  cx, cy  storage for n center coordinates
+**  radius  storage for n radii
+**  valid   storage for n flags, 1 where a circle was found
+**
+** Return value: int
+**  number of triples for which a circle was found
+*/
+int ppp_circle_batch(int n,
+      const double *x1, const double *y1,
+      const double *x2, const double *y2,
+      const double *x3, const double *y3,
+      double *cx, double *cy, double *radius, unsigned char *valid)
+{
+ if (n <= 0) return 0;
+
+ switch (ppp_batch_isa()) {
+#ifdef PPP_HAVE_AVX2
+  case PPP_ISA_AVX2:
+   return ppp_batch_avx2(n, x1, y1, x2, y2, x3, y3, cx, cy, radius, valid);
+#endif
+#ifdef PPP_HAVE_SSE2
+  case PPP_ISA_SSE2:
+   return ppp_batch_sse2(n, x1, y1, x2, y2, x3, y3, cx, cy, radius, valid);
+#endif
+ }
+ return ppp_batch_scalar(0, n, x1, y1, x2, y2, x3, y3, cx, cy, radius, valid);
+}
+
+/*
+** Function ppp_affine_batch -- Transform n points by a 3 x 4 affine
+**    matrix
+**
+** Inputs:
+**  n        number of points
+**  m        the matrix; point k' = m[k][0] x + m[k][1] y + m[k][2] z
+**    + m[k][3]
+**  x, y, z  coordinate arrays; z may be NULL for points in the x, y
+**    plane
+**  xyz      storage for n transformed points, interleaved
+*/
+void ppp_affine_batch(int n, const double m[3][4],
+      const double *x, const double *y, const double *z, double (*xyz)[3])
+{
+ if (n <= 0) return;
+
+ switch (ppp_batch_isa()) {
+#ifdef PPP_HAVE_AVX2
+  case PPP_ISA_AVX2:
+   ppp_affine_avx2(n, m, x, y, z, xyz);
+   return;
+#endif
+#ifdef PPP_HAVE_SSE2
+  case PPP_ISA_SSE2:
+   ppp_affine_sse2(n, m, x, y, z, xyz);
+   return;
+#endif
+ }
+ ppp_affine_scalar(0, n, m, x, y, z, xyz);
+}
+
+/*
+** Function batch_chunk -- ppp_parallel_for body of ppp_circle_batch_mt
+*/
+static void batch_chunk(void *ctx, int worker, int chunk)
+{
+ ppp_batch_mt *job = (ppp_batch_mt *)ctx;
+ int first = chunk * PPP_MT_CHUNK;
+ int n = job->n - first;
+
+ if (n > PPP_MT_CHUNK) n = PPP_MT_CHUNK;
+ job->count[chunk] = ppp_circle_batch(n, job->x1 + first, job->y1 + first,
+   job->x2 + first, job->y2 + first, job->x3 + first, job->y3 + first,
+   job->cx + first, job->cy + first, job->radius + first, job->valid + first);
+}
+
+/*
+** Function ppp_circle_batch_mt -- Find the circles through n triples on
+**    several threads
+**
+** Inputs:
+**  threads  number of threads including the caller, 0 or less for one
+**    per processor
+**  remaining inputs and return value as for ppp_circle_batch
+*/
+int ppp_circle_batch_mt(int n,
+      const double *x1, const double *y1,
+      const double *x2, const double *y2,
+      const double *x3, const double *y3,
+      double *cx, double *cy, double *radius, unsigned char *valid,
+      int threads)
+{
+ ppp_batch_mt job;
+ int chunks, i, count = 0;
+
+ if (n <= 0) return 0;
+ chunks = (n + PPP_MT_CHUNK - 1) / PPP_MT_CHUNK;
+ if ((chunks == 1) || (threads == 1))
+  return ppp_circle_batch(n, x1, y1, x2, y2, x3, y3, cx, cy, radius, valid);
+
+ /* one count per chunk, summed in order afterwards */
+ job.count = (int *)malloc(chunks * sizeof(int));
+ if (!job.count)
+  return ppp_circle_batch(n, x1, y1, x2, y2, x3, y3, cx, cy, radius, valid);
+
+ job.n = n;
+ job.x1 = x1; job.y1 = y1;
+ job.x2 = x2; job.y2 = y2;
+ job.x3 = x3; job.y3 = y3;
+ job.cx = cx; job.cy = cy; job.radius = radius;
+ job.valid = valid;
+
+ /* pick the kernel before the workers read it */
+ ppp_batch_isa();
+ ppp_parallel_for(chunks, threads, batch_chunk, &job);
+
+ for (i = 0; i < chunks; i++) count += job.count[i];
+ free(job.count);
+ return count;
+}
@@ -1,162 +1,483 @@
-/*
-** pppcir.c
-**
-** Originally from rmrice@eskimo.com on the COMP.GRAPHICS.ALGORITHMS forum
-**
-** Contents: Routine for 3 point circle with supporting routines
-**    to calculate v2 line intersection and v2 distance.
-**
-** The code is self contained except for a call to the standard library
-** function 'sqrt'. 
-** 
-** If you intend to interface this code with another program note that 
-** all position and vector parameters of the three functions (ppp_circle, 
-** line_intersect and v2_dist) are passed as pointers to structures. The
-** radius parameter is also a pointer; 
-**
-*/
-/*
-#include <math.h>
-
-#define false 0
-#define true (!false)
-
-typedef struct V2_DIST_VECT
-{
- double x;
- double y;
-} v2_dist_vect;
-
-typedef v2_dist_vect v2_vect;
-typedef v2_dist_vect v2_pos;
-*/
-#include "pppcir.h"
-
-/*
-** Function v2_dist -- Find the distance between 2 points in 2D space
-**
-** Inputs:
-**  a  pointer to point on first line
-**  b  pointer to point on second line
-**
-** Return value: double
-**  calculated distance
-*/
-static double v2_dist(v2_pos *a, v2_pos *b)
-{
- double dx, dy;
-
- dx = (a->x - b->x);
- dy = (a->y - b->y);
- return (sqrt((dx * dx) + (dy * dy)));
-}
-
-/*
-** Function line_intersect -- Find the intersection of 2 lines in 2D space
-**
-** Inputs:
-**  p1  pointer to point on first line
-**  p2  pointer to point on second line
-**  d1  pointer to slope vector of first line
-**  d2  pointer to slope vector of second line
-**  ip  pointer to storage for intersection position values
-**
-** Return value: int
-**  true *ip contents valid -- intersection found
-**  false *ip contents undefined -- intersection NOT found
-**    should only happen when passed two parallel lines
-*/
-static short line_intersect(v2_pos *p1, v2_pos *p2,
-       v2_vect *d1, v2_vect *d2, v2_pos *ip)
-{
- double m1, m2;
- int stat = true;
-
- if(d1->x != 0.0) m1 = d1->y / d1->x;
- if(d2->x != 0.0) m2 = d2->y / d2->x;
-
- if((d1->x != 0.0) && (d2->x != 0.0)) {
-  double temp_x, m, b1, b2;
-
-  m = m1 - m2;
-  if (fabs(m) != 0.0){ 
-   b1 = p1->y - m1 * p1->x;
-   b2 = p2->y - m2 * p2->x;
-   temp_x = (b2 - b1) / m;
-   if((m1 == 0.0) || (m2 == 0.0)) {
-    ip->x = temp_x;
-    ip->y = ((b2 * m1) - (b1 * m2)) / m;
-   } else {
-    m1 = 1.0 / m1;
-    m2 = 1.0 / m2;
-    m = (m1 - m2);
-    if (m != 0.0) {
-     ip->x = temp_x;
-     b1 = p1->x -  m1 * p1->y;
-     b2 = p2->x -  m2 * p2->y;
-     ip->y = (b2 - b1) / m;
-    } else stat = false; /* Error: should never happen? */
-   }
-  } else stat = false; /* Error: parallel non-vertical lines */
- } else if(d1->x != 0.0) {
-  ip->x = p2->x;
-  m2 = p1->y - (p1->x * m1);
-  ip->y =  (m1 * p2->x) + m2;
- } else if(d2->x != 0.0) {
-  ip->x = p1->x;
-  m1 = p2->y - (p2->x * m2);
-  ip->y =  (m2 * p1->x) + m1;
- } else stat = false;   /* Error: parallel vertical lines */ return stat;
-}
-
-/*
-** Function ppp_circle -- Find circle passing through 3 given points
-**
-** Inputs:
-**  p1  pointer to first given point
-**      p2      pointer to second given point
-**      p3      pointer to third given point
-**  center pointer to storage for circle center position values
-**  radius pointer to storage for circle radius value
-**
-** Return value: int
-**  true  *center and *radius values valid -- circle was found
-**  false *center and *radius values undefined -- circle was NOT
-**    found should only happen when passed 3 points on a
-**    straight line
-**
-** For the ppp_circle function, if all three points are different the  
-** results are as expected, but note that . . .
-** 
-**     if p1 and p2 are the same or p1 and p3 are the same the circle 
-** will be horizontally centered on p1 and pass thru all three points, 
-**
-** and if p2 and p3 are the same then the center is calculated to
-** be the midpoint of the line between them and p1.
-*/
-int ppp_circle(v2_pos *p1, v2_pos *p2, v2_pos *p3,
-      v2_pos *center, double *radius)
-{
- v2_vect d1, d2;
- v2_pos mp1, mp2;
- int have_center = true;
-
- /* calculate perpendicular slope vectors */
- d1.y = p2->x - p1->x;
- d2.y = p3->x - p1->x;
- d1.x = p1->y - p2->y;
- d2.x = p1->y - p3->y;
-
- /* calculate midpoint position values */
- mp1.x = (p1->x + p2->x) * 0.5;
- mp1.y = (p1->y + p2->y) * 0.5;
- mp2.x = (p1->x + p3->x) * 0.5;
- mp2.y = (p1->y + p3->y) * 0.5;
-
- if ((mp1.x == mp2.x) && (mp1.y == mp2.y)) {
-  *center = mp1;
- } else have_center = line_intersect(&mp1, &mp2, &d1, &d2, center);
-
- if (have_center) *radius = v2_dist(center, p1);
- return (have_center);
-}
+/*
+** pppcir.c
+**
+** Originally from rmrice@eskimo.com on the COMP.GRAPHICS.ALGORITHMS forum
+**
+** Contents: Routine for 3 point circle with supporting routines
+**    to calculate v2 line intersection and v2 distance, and the exact
+**    orientation test that decides which triples are degenerate.
+**
+** The code is self contained except for a call to the standard library
+** function 'sqrt'. 
+**
+** The arithmetic of ppp_circle and ppp_circle_closed, with the v2
+** line intersection and distance helpers, lives in the precision
+** generic ppptmpl.h; the functions here call its double instantiation
+** from pppgen.h (ppp_line_intersect_d, ppp_v2_dist_d, ...).
+** 
+** If you intend to interface this code with another program note that 
+** all position and vector parameters of the three functions (ppp_circle, 
+** line_intersect and v2_dist) are passed as pointers to structures. The
+** radius parameter is also a pointer; 
+**
+*/
+/*
+#include <math.h>
+
+#define false 0
+#define true (!false)
+
+typedef struct V2_DIST_VECT
+{
+ double x;
+ double y;
+} v2_dist_vect;
+
+typedef v2_dist_vect v2_vect;
+typedef v2_dist_vect v2_pos;
+*/
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pppgen.h"
+
+static int orient2d_exact(const v2_pos *a, const v2_pos *b, const v2_pos *c);
+
+/* 2^-53, and Shewchuk's error bound on the rounded orient2d determinant */
+#define PPP_EPSILON (DBL_EPSILON * 0.5)
+#define PPP_CCW_BOUND ((3.0 + 16.0 * PPP_EPSILON) * PPP_EPSILON)
+
+/*
+** Function two_sum -- a + b as the rounded sum x plus the exact error y
+*/
+static void two_sum(double a, double b, double *x, double *y)
+{
+ double bv, av;
+
+ *x = a + b;
+ bv = *x - a;
+ av = *x - bv;
+ *y = (a - av) + (b - bv);
+}
+
+/*
+** Function two_product -- a * b as the rounded product x plus the exact
+**    error y, by Dekker's splitting (valid below about 1e300)
+*/
+static void two_product(double a, double b, double *x, double *y)
+{
+ const double splitter = 134217729.0; /* 2^27 + 1 */
+ double c, ahi, alo, bhi, blo, err;
+
+ *x = a * b;
+ c = splitter * a; ahi = c - (c - a); alo = a - ahi;
+ c = splitter * b; bhi = c - (c - b); blo = b - bhi;
+ err = *x - ahi * bhi;
+ err -= alo * bhi;
+ err -= ahi * blo;
+ *y = alo * blo - err;
+}
+
+/*
+** Function orient2d_exact -- Sign of the orientation determinant in
+**    exact arithmetic
+**
+** The determinant is expanded into its six products,
+**
+**    ax by - ax cy - ay bx + ay cx + bx cy - by cx
+**
+** each split exactly into two doubles, and the twelve terms are summed
+** into a nonoverlapping expansion (Shewchuk's grow_expansion).  The
+** largest nonzero component of an expansion carries its sign.
+*/
+static int orient2d_exact(const v2_pos *a, const v2_pos *b, const v2_pos *c)
+{
+ double term[12], e[13], q, h;
+ int i, j, k, len = 0;
+
+ two_product(a->x, b->y, &term[0], &term[1]);
+ two_product(-a->x, c->y, &term[2], &term[3]);
+ two_product(-a->y, b->x, &term[4], &term[5]);
+ two_product(a->y, c->x, &term[6], &term[7]);
+ two_product(b->x, c->y, &term[8], &term[9]);
+ two_product(-b->y, c->x, &term[10], &term[11]);
+
+ for (i = 0; i < 12; i++) {
+  q = term[i];
+  for (j = 0, k = 0; j < len; j++) {
+   two_sum(q, e[j], &q, &h);
+   if (h != 0.0) e[k++] = h;
+  }
+  if (q != 0.0) e[k++] = q;
+  len = k;
+ }
+ if (len == 0) return 0;
+ return (e[len - 1] > 0.0) ? 1 : -1;
+}
+
+/*
+** Function ppp_orient2d -- Find on which side of the line a b the
+**    point c lies, exactly
+**
+** Inputs:
+**  a  pointer to first point of the line
+**  b  pointer to second point of the line
+**  c  pointer to the point tested
+**
+** Return value: int
+**  1   a, b, c counterclockwise
+**  -1  a, b, c clockwise
+**  0   a, b, c on a line, or two of them coincident
+**
+** The rounded determinant decides whenever it is larger than its
+** error bound, which is nearly always.  Only the rest go through the
+** exact expansion.
+*/
+int ppp_orient2d(const v2_pos *a, const v2_pos *b, const v2_pos *c)
+{
+ double detleft, detright, det, detsum;
+
+ detleft = (a->x - c->x) * (b->y - c->y);
+ detright = (a->y - c->y) * (b->x - c->x);
+ det = detleft - detright;
+
+ /* with opposite signs |det| == detsum and the test always passes, so
+    there is no need to branch on the signs */
+ detsum = fabs(detleft) + fabs(detright);
+ if (fabs(det) > PPP_CCW_BOUND * detsum) return (det > 0.0) - (det < 0.0);
+ PPP_COUNT(PPP_COUNT_ORIENT_EXACT);
+ return orient2d_exact(a, b, c);
+}
+
+/*
+** Function ppp_classify -- Decide whether a triple makes a usable circle
+**
+** Inputs:
+**  p1, p2, p3  pointers to the given points
+**  min_sine    smallest acceptable sine of the smallest angle
+**
+** Return value: int
+**  PPP_TRIPLE_OK         the triple makes a circle
+**  PPP_TRIPLE_SLIVER     the smallest angle is below min_sine
+**  PPP_TRIPLE_COLLINEAR  the points are on a line or two coincide
+**
+** The sine of the smallest angle is |d| / (|e1| |e2|) for the two
+** longest edges e1 and e2, where d is the orientation determinant, so
+** the test needs no square root or division.
+*/
+int ppp_classify(const v2_pos *p1, const v2_pos *p2, const v2_pos *p3,
+      double min_sine)
+{
+ double bx, by, cx, cy, ex, ey, b2, c2, e2, emin, d;
+
+ PPP_COUNT(PPP_COUNT_CLASSIFY);
+ if (ppp_orient2d(p1, p2, p3) == 0) {
+  PPP_COUNT(PPP_COUNT_COLLINEAR);
+  return PPP_TRIPLE_COLLINEAR;
+ }
+ if (min_sine <= 0.0) return PPP_TRIPLE_OK;
+
+ bx = p2->x - p1->x; by = p2->y - p1->y;
+ cx = p3->x - p1->x; cy = p3->y - p1->y;
+ ex = p3->x - p2->x; ey = p3->y - p2->y;
+ b2 = bx * bx + by * by;
+ c2 = cx * cx + cy * cy;
+ e2 = ex * ex + ey * ey;
+ emin = (b2 < c2) ? b2 : c2;
+ if (e2 < emin) emin = e2;
+ d = bx * cy - by * cx;
+
+ if (!(d * d * emin >= min_sine * min_sine * b2 * c2 * e2)) {
+  PPP_COUNT(PPP_COUNT_SLIVER);
+  return PPP_TRIPLE_SLIVER;
+ }
+ return PPP_TRIPLE_OK;
+}
+
+/*
+** Function ppp_circle -- Find circle passing through 3 given points
+**
+** Inputs:
+**  p1  pointer to first given point
+**      p2      pointer to second given point
+**      p3      pointer to third given point
+**  center pointer to storage for circle center position values
+**  radius pointer to storage for circle radius value
+**
+** Return value: int
+**  true  *center and *radius values valid -- circle was found
+**  false *center and *radius values undefined -- circle was NOT
+**    found, ppp_classify does not pass the points with PPP_MIN_SINE
+**
+** Three points on a line, two coincident points and slivers are
+** rejected up front, so the slope arithmetic of ppp_circle_slope never
+** sees them.
+*/
+int ppp_circle(v2_pos *p1, v2_pos *p2, v2_pos *p3,
+      v2_pos *center, double *radius)
+{
+ if (ppp_classify(p1, p2, p3, PPP_MIN_SINE) != PPP_TRIPLE_OK) return false;
+ return ppp_circle_slope_d(p1, p2, p3, center, radius);
+}
+
+/*
+** Function ppp_circle_closed -- Find circle passing through 3 given points
+**    using the determinant form of the circumcenter
+**
+** Inputs and return value as for ppp_circle.
+**
+** Working relative to p1, with b = p2 - p1 and c = p3 - p1, the center
+** offset is
+**
+**    d  = 2 (bx cy - by cx)
+**    ux = (cy |b|^2 - by |c|^2) / d
+**    uy = (bx |c|^2 - cx |b|^2) / d
+**
+** There are no slope special cases and one reciprocal.  Degenerate
+** triples are rejected by ppp_classify as in ppp_circle.
+*/
+int ppp_circle_closed(v2_pos *p1, v2_pos *p2, v2_pos *p3,
+      v2_pos *center, double *radius)
+{
+ if (ppp_classify(p1, p2, p3, PPP_MIN_SINE) != PPP_TRIPLE_OK) return false;
+ return ppp_circle_det_d(p1, p2, p3, center, radius);
+}
+
+/*
+** Function ppp_circle_solve -- Find circle passing through 3 given points
+**    with a selectable solver
+**
+** Inputs:
+**  solver PPP_SOLVER_REFERENCE for ppp_circle, PPP_SOLVER_CLOSED for
+**    ppp_circle_closed
+**  remaining inputs and return value as for ppp_circle
+*/
+int ppp_circle_solve(int solver, v2_pos *p1, v2_pos *p2, v2_pos *p3,
+      v2_pos *center, double *radius)
+{
+ if (solver == PPP_SOLVER_REFERENCE)
+  return ppp_circle(p1, p2, p3, center, radius);
+ return ppp_circle_closed(p1, p2, p3, center, radius);
+}
+
+/*
+** Function ppp_circle3d -- Find circle passing through 3 given points
+**    in 3D space, with its plane
+**
+** Inputs:
+**  p1      pointer to first given point
+**  p2      pointer to second given point
+**  p3      pointer to third given point
+**  center  pointer to storage for circle center position values
+**  radius  pointer to storage for circle radius value
+**  normal  pointer to storage for the unit normal of the circle plane
+**  u       pointer to storage for the unit in-plane axis from p1 toward p2
+**  v       pointer to storage for the unit in-plane axis normal x u,
+**    on the side of p3
+**
+** Return value: int
+**  true  all outputs valid -- circle was found
+**  false outputs undefined -- the points are on a line or coincident,
+**    decided exactly, or make a sliver as for ppp_classify
+**
+** With a = p2 - p1 and b = p3 - p1 the center is
+**
+**    p1 + ((|a|^2 b - |b|^2 a) x (a x b)) / (2 |a x b|^2)
+**
+** so no angles are needed.  u, v and normal form a right handed
+** orthonormal basis: a point (x, y) on the circle in the plane is
+** center + x u + y v.
+*/
+int ppp_circle3d(v3_pos *p1, v3_pos *p2, v3_pos *p3, v3_pos *center, double *radius,
+      v3_vect *normal, v3_vect *u, v3_vect *v)
+{
+ v3_vect a, b, n, w;
+ v2_pos q1, q2, q3;
+ double a2, b2, e2, emin, n2, inv, len;
+
+ /* on a line exactly when all three axis projections are */
+ q1.x = p1->y; q1.y = p1->z; q2.x = p2->y; q2.y = p2->z; q3.x = p3->y; q3.y = p3->z;
+ if (ppp_orient2d(&q1, &q2, &q3) == 0) {
+  q1.x = p1->z; q1.y = p1->x; q2.x = p2->z; q2.y = p2->x; q3.x = p3->z; q3.y = p3->x;
+  if (ppp_orient2d(&q1, &q2, &q3) == 0) {
+   q1.x = p1->x; q1.y = p1->y; q2.x = p2->x; q2.y = p2->y; q3.x = p3->x; q3.y = p3->y;
+   if (ppp_orient2d(&q1, &q2, &q3) == 0) return false;
+  }
+ }
+
+ a.x = p2->x - p1->x; a.y = p2->y - p1->y; a.z = p2->z - p1->z;
+ b.x = p3->x - p1->x; b.y = p3->y - p1->y; b.z = p3->z - p1->z;
+
+ /* plane normal, |n| = |a| |b| sin of the angle at p1 */
+ n.x = a.y * b.z - a.z * b.y;
+ n.y = a.z * b.x - a.x * b.z;
+ n.z = a.x * b.y - a.y * b.x;
+ n2 = n.x * n.x + n.y * n.y + n.z * n.z;
+
+ a2 = a.x * a.x + a.y * a.y + a.z * a.z;
+ b2 = b.x * b.x + b.y * b.y + b.z * b.z;
+ w.x = b.x - a.x; w.y = b.y - a.y; w.z = b.z - a.z;
+ e2 = w.x * w.x + w.y * w.y + w.z * w.z;
+
+ /* sliver test of ppp_classify */
+ emin = (a2 < b2) ? a2 : b2;
+ if (e2 < emin) emin = e2;
+ if (!(n2 * emin >= PPP_MIN_SINE * PPP_MIN_SINE * a2 * b2 * e2)) return false;
+ if (n2 == 0.0) return false;
+
+ w.x = a2 * b.x - b2 * a.x;
+ w.y = a2 * b.y - b2 * a.y;
+ w.z = a2 * b.z - b2 * a.z;
+
+ inv = 0.5 / n2;
+ center->x = (w.y * n.z - w.z * n.y) * inv;
+ center->y = (w.z * n.x - w.x * n.z) * inv;
+ center->z = (w.x * n.y - w.y * n.x) * inv;
+ *radius = sqrt(center->x * center->x + center->y * center->y + center->z * center->z);
+ if (!(*radius <= DBL_MAX)) return false;
+ center->x += p1->x;
+ center->y += p1->y;
+ center->z += p1->z;
+
+ len = 1.0 / sqrt(n2);
+ normal->x = n.x * len; normal->y = n.y * len; normal->z = n.z * len;
+
+ len = 1.0 / sqrt(a2);
+ u->x = a.x * len; u->y = a.y * len; u->z = a.z * len;
+
+ v->x = normal->y * u->z - normal->z * u->y;
+ v->y = normal->z * u->x - normal->x * u->z;
+ v->z = normal->x * u->y - normal->y * u->x;
+
+ return true;
+}
+
+#ifdef PPP_COUNTERS
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define PPP_TLS __declspec(thread)
+#else
+#define PPP_TLS __thread
+#endif
+
+typedef struct PPP_COUNTER_BLOCK
+{
+ ppp_counters counters;
+ struct PPP_COUNTER_BLOCK *next;
+} ppp_counter_block;
+
+/* every block ever handed out; blocks are never freed */
+static ppp_counter_block *volatile counter_blocks = NULL;
+static PPP_TLS ppp_counter_block *counter_own = NULL;
+static ppp_counters counter_lost;
+
+static int counter_push(ppp_counter_block *block)
+{
+ ppp_counter_block *head = counter_blocks;
+
+ block->next = head;
+#if defined(_MSC_VER)
+ return _InterlockedCompareExchangePointer((void *volatile *)&counter_blocks,
+   block, head) == head;
+#else
+ return __atomic_compare_exchange_n(&counter_blocks, &head, block, 0,
+   __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+#endif
+}
+
+#endif
+
+/*
+** Function ppp_counters_own -- The counter block of the calling thread,
+**    made and linked into the list of blocks on first use
+**
+** If it cannot be allocated the counts go to a shared block that is
+** not read back.
+*/
+ppp_counters *ppp_counters_own(void)
+{
+#ifdef PPP_COUNTERS
+ ppp_counter_block *block = counter_own;
+
+ if (block) return &block->counters;
+ block = (ppp_counter_block *)calloc(1, sizeof(*block));
+ if (!block) return &counter_lost;
+ while (!counter_push(block));
+ counter_own = block;
+ return &block->counters;
+#else
+ static ppp_counters unused;
+
+ return &unused;
+#endif
+}
+
+/*
+** Function ppp_counters_thread -- Copy the counts of the calling thread
+**
+** Return value: int
+**  true  *counters set
+**  false built without PPP_COUNTERS, *counters zeroed
+*/
+int ppp_counters_thread(ppp_counters *counters)
+{
+#ifdef PPP_COUNTERS
+ *counters = *ppp_counters_own();
+ return true;
+#else
+ memset(counters, 0, sizeof(*counters));
+ return false;
+#endif
+}
+
+/*
+** Function ppp_counters_total -- Sum the counts of all threads
+**
+** Other threads may still be counting; their blocks are read as they
+** are.
+**
+** Return value: int
+**  as for ppp_counters_thread
+*/
+int ppp_counters_total(ppp_counters *counters)
+{
+#ifdef PPP_COUNTERS
+ ppp_counter_block *block;
+ int i;
+
+ memset(counters, 0, sizeof(*counters));
+ for (block = counter_blocks; block; block = block->next)
+  for (i = 0; i < PPP_COUNTERS_N; i++)
+   counters->n[i] += block->counters.n[i];
+ return true;
+#else
+ memset(counters, 0, sizeof(*counters));
+ return false;
+#endif
+}
+
+/*
+** Function ppp_counters_reset -- Zero the counts of the calling thread
+*/
+void ppp_counters_reset(void)
+{
+#ifdef PPP_COUNTERS
+ memset(ppp_counters_own(), 0, sizeof(ppp_counters));
+#endif
+}
+
+/*
+** Function ppp_counter_name -- Short name of a PPP_COUNT_ index
+*/
+const char *ppp_counter_name(int counter)
+{
+ static const char *name[PPP_COUNTERS_N] = {
+  "classify", "collinear", "sliver", "orient_exact",
+  "slope", "same_midpoint", "sloped", "horizontal", "parallel",
+  "inverse_fail", "vertical_1", "vertical_2", "vertical_both"
+ };
+
+ if ((counter < 0) || (counter >= PPP_COUNTERS_N)) return "";
+ return name[counter];
+}
@@ -1,24 +1,158 @@
-/*
-** pppcir.h
-*/
-
-#include <math.h>
-
-#define false 0
-#define true (!false)
-
-typedef struct V2_DIST_VECT
-{
- double x;
- double y;
-} v2_dist_vect;
-
-typedef v2_dist_vect v2_vect;
-typedef v2_dist_vect v2_pos;
-
-
-static double v2_dist(v2_pos *a, v2_pos *b);
-
-static short line_intersect(v2_pos *p1, v2_pos *p2, v2_vect *d1, v2_vect *d2, v2_pos *ip);
-
-int ppp_circle(v2_pos *p1, v2_pos *p2, v2_pos *p3, v2_pos *center, double *radius);
+/*
+** pppcir.h
+*/
+
+#ifndef PPPCIR_H
+#define PPPCIR_H
+
+#include <math.h>
+
+#define false 0
+#define true (!false)
+
+typedef struct V2_DIST_VECT
+{
+ double x;
+ double y;
+} v2_dist_vect;
+
+typedef v2_dist_vect v2_vect;
+typedef v2_dist_vect v2_pos;
+
+typedef struct V3_DIST_VECT
+{
+ double x;
+ double y;
+ double z;
+} v3_dist_vect;
+
+typedef v3_dist_vect v3_vect;
+typedef v3_dist_vect v3_pos;
+
+
+int ppp_circle(v2_pos *p1, v2_pos *p2, v2_pos *p3, v2_pos *center, double *radius);
+
+/*
+** Degenerate triples.  Every solver rejects three points on a line or
+** two coincident points, decided by the exact ppp_orient2d, and any
+** triple whose smallest angle has a sine below PPP_MIN_SINE, whose
+** circle would be over about 1 / (2 PPP_MIN_SINE) times its longest
+** edge.
+*/
+#ifndef PPP_MIN_SINE
+#define PPP_MIN_SINE 1e-6
+#endif
+
+#define PPP_TRIPLE_OK        0
+#define PPP_TRIPLE_SLIVER    1
+#define PPP_TRIPLE_COLLINEAR 2
+
+int ppp_orient2d(const v2_pos *a, const v2_pos *b, const v2_pos *c);
+
+int ppp_classify(const v2_pos *p1, const v2_pos *p2, const v2_pos *p3, double min_sine);
+
+/*
+** Solvers for ppp_circle_solve.  PPP_SOLVER_REFERENCE is the original
+** slope based ppp_circle, PPP_SOLVER_CLOSED the determinant form.
+*/
+#define PPP_SOLVER_REFERENCE 0
+#define PPP_SOLVER_CLOSED    1
+
+#ifndef PPP_SOLVER_DEFAULT
+#define PPP_SOLVER_DEFAULT PPP_SOLVER_CLOSED
+#endif
+
+int ppp_circle_closed(v2_pos *p1, v2_pos *p2, v2_pos *p3, v2_pos *center, double *radius);
+
+int ppp_circle_solve(int solver, v2_pos *p1, v2_pos *p2, v2_pos *p3, v2_pos *center, double *radius);
+
+int ppp_circle3d(v3_pos *p1, v3_pos *p2, v3_pos *p3, v3_pos *center, double *radius,
+      v3_vect *normal, v3_vect *u, v3_vect *v);
+
+/*
+** Branch counters.  Built with PPP_COUNTERS defined, ppp_classify,
+** ppp_orient2d and the slope solver (ppp_circle_slope and
+** ppp_line_intersect, all precisions) count which way they went, in a
+** block of counters per thread.  ppp_counters_thread reads the block
+** of the calling thread, ppp_counters_total the sum over every thread
+** that has counted, including threads that have since ended.  Without
+** PPP_COUNTERS nothing is counted and both return false.
+*/
+#define PPP_COUNT_CLASSIFY       0  /* ppp_classify calls */
+#define PPP_COUNT_COLLINEAR      1  /*  ... on a line or coincident */
+#define PPP_COUNT_SLIVER         2  /*  ... smallest angle too small */
+#define PPP_COUNT_ORIENT_EXACT   3  /* ppp_orient2d needing the expansion */
+#define PPP_COUNT_SLOPE          4  /* ppp_circle_slope calls */
+#define PPP_COUNT_SAME_MIDPOINT  5  /*  ... coincident midpoints */
+#define PPP_COUNT_SLOPED         6  /* ppp_line_intersect, both lines sloped */
+#define PPP_COUNT_HORIZONTAL     7  /*  ... one of them horizontal */
+#define PPP_COUNT_PARALLEL       8  /*  ... parallel, no intersection */
+#define PPP_COUNT_INVERSE_FAIL   9  /*  ... equal inverse slopes, failed */
+#define PPP_COUNT_VERTICAL_1    10  /*  ... first line vertical */
+#define PPP_COUNT_VERTICAL_2    11  /*  ... second line vertical */
+#define PPP_COUNT_VERTICAL_BOTH 12  /*  ... both vertical, failed */
+#define PPP_COUNTERS_N          13
+
+typedef struct PPP_COUNTS
+{
+ unsigned long long n[PPP_COUNTERS_N];
+} ppp_counters;
+
+int ppp_counters_thread(ppp_counters *counters);
+int ppp_counters_total(ppp_counters *counters);
+void ppp_counters_reset(void);
+const char *ppp_counter_name(int counter);
+
+/* the block of the calling thread, for PPP_COUNT */
+ppp_counters *ppp_counters_own(void);
+
+#ifdef PPP_COUNTERS
+#define PPP_COUNT(counter) (ppp_counters_own()->n[counter]++)
+#else
+#define PPP_COUNT(counter) ((void)0)
+#endif
+
+/*
+** Batched circumcircle kernel (pppbatch.c)
+**
+** Instruction sets selectable for ppp_circle_batch.  PPP_ISA_AUTO picks
+** the best one the running CPU supports.
+*/
+#define PPP_ISA_AUTO   -1
+#define PPP_ISA_SCALAR 0
+#define PPP_ISA_SSE2   1
+#define PPP_ISA_AVX2   2
+
+int ppp_circle_batch(int n,
+      const double *x1, const double *y1,
+      const double *x2, const double *y2,
+      const double *x3, const double *y3,
+      double *cx, double *cy, double *radius, unsigned char *valid);
+
+/*
+** Triples per work item of ppp_circle_batch_mt: inputs and outputs of
+** a chunk take about 300 KB, so a chunk stays in a per core cache.
+*/
+#ifndef PPP_MT_CHUNK
+#define PPP_MT_CHUNK 4096
+#endif
+
+int ppp_circle_batch_mt(int n,
+      const double *x1, const double *y1,
+      const double *x2, const double *y2,
+      const double *x3, const double *y3,
+      double *cx, double *cy, double *radius, unsigned char *valid,
+      int threads);
+
+/*
+** Affine transform of structure-of-arrays points to interleaved xyz,
+** with the same kernel selection as ppp_circle_batch.
+*/
+void ppp_affine_batch(int n, const double m[3][4],
+      const double *x, const double *y, const double *z, double (*xyz)[3]);
+
+int ppp_batch_isa(void);
+int ppp_batch_set_isa(int isa);
+const char *ppp_batch_isa_name(int isa);
+
+#endif
@@ -0,0 +1,256 @@
+/*
+** pppcurv.c
+**
+** Contents: Osculating circles along polylines, the circle through
+**    every three consecutive vertices, in one streaming pass.
+**
+** Around a vertex p, with a the edge coming in and b the edge going
+** out, the center x (relative to p) lies on the bisector plane of
+** each edge and in the plane of the two edges:
+**
+**    a . x = -|a|^2 / 2      b . x = |b|^2 / 2      n . x = 0
+**
+** with n = a x b.  By Cramer's rule, since a . (b x n) = |n|^2,
+**
+**    x = (|b|^2 / 2 (n x a) - |a|^2 / 2 (b x n)) / |n|^2
+**      = n x (|b|^2 / 2 a + |a|^2 / 2 b) / |n|^2
+**
+** The bisector of an edge, its direction and half its squared length,
+** is made once when the edge comes in and reused by the window after
+** it, which is all ppp_circle would compute twice.  Everything is
+** relative to p, so coordinates far from the origin cost no accuracy.
+**
+** Windows whose edges are within asin(PPP_MIN_SINE) of parallel are
+** straight when the path goes on and cusps when it turns back.  Either
+** way the circle would be over about 1 / (2 PPP_MIN_SINE) times the
+** edges, which for a cusp says nothing of the turn, so a cusp gets a
+** radius of 0 and is a violation of any min_radius.
+*/
+
+#include "pppcurv.h"
+
+/*
+** Function curv_window -- Circle of the window around p
+**
+** Inputs:
+**  c      the walk, for the totals
+**  index  of p in the sequence
+**  p      the vertex
+**  a      edge coming in and half its squared length
+**  b      edge going out and half its squared length
+**  out    the window
+*/
+static void curv_window(ppp_curv *c, long index, const double *p,
+   const double *a, double ha, const double *b, double hb, ppp_curv_vertex *out)
+{
+ double n[3], w[3], x[3], nn, inv;
+
+ out->index = index;
+ out->center.x = p[0];
+ out->center.y = p[1];
+ out->center.z = p[2];
+
+ if ((ha == 0.0) || (hb == 0.0)) {
+  out->kind = PPP_CURV_NONE;
+  out->radius = HUGE_VAL;
+  out->violation = false;
+  return;
+ }
+
+ n[0] = a[1] * b[2] - a[2] * b[1];
+ n[1] = a[2] * b[0] - a[0] * b[2];
+ n[2] = a[0] * b[1] - a[1] * b[0];
+ nn = n[0] * n[0] + n[1] * n[1] + n[2] * n[2];
+
+ /* |n|^2 = |a|^2 |b|^2 sin^2, and ha hb = |a|^2 |b|^2 / 4 */
+ if (!(nn > 4.0 * PPP_MIN_SINE * PPP_MIN_SINE * ha * hb)) {
+  if (a[0] * b[0] + a[1] * b[1] + a[2] * b[2] < 0.0) {
+   out->kind = PPP_CURV_CUSP;
+   out->radius = 0.0;
+   c->cusps++;
+  } else {
+   out->kind = PPP_CURV_STRAIGHT;
+   out->radius = HUGE_VAL;
+   c->straight++;
+  }
+ } else {
+  w[0] = hb * a[0] + ha * b[0];
+  w[1] = hb * a[1] + ha * b[1];
+  w[2] = hb * a[2] + ha * b[2];
+  inv = 1.0 / nn;
+  x[0] = (n[1] * w[2] - n[2] * w[1]) * inv;
+  x[1] = (n[2] * w[0] - n[0] * w[2]) * inv;
+  x[2] = (n[0] * w[1] - n[1] * w[0]) * inv;
+  out->kind = PPP_CURV_OK;
+  out->radius = sqrt(x[0] * x[0] + x[1] * x[1] + x[2] * x[2]);
+  out->center.x = p[0] + x[0];
+  out->center.y = p[1] + x[1];
+  out->center.z = p[2] + x[2];
+ }
+
+ out->violation = (out->radius < c->min_radius);
+ if (out->violation) c->violations++;
+ if (out->radius < c->radius_min) {
+  c->radius_min = out->radius;
+  c->radius_min_at = index;
+ }
+}
+
+/*
+** Function ppp_curv_init -- Start a walk along a polyline
+**
+** Inputs:
+**  c           the walk
+**  closed      the last vertex joins the first
+**  min_radius  windows tighter than this are violations, 0 for none
+*/
+void ppp_curv_init(ppp_curv *c, int closed, double min_radius)
+{
+ c->closed = closed;
+ c->min_radius = (min_radius > 0.0) ? min_radius : 0.0;
+ c->n = 0;
+ c->half = c->half0 = 0.0;
+ c->straight = c->cusps = c->violations = 0;
+ c->radius_min = HUGE_VAL;
+ c->radius_min_at = -1;
+}
+
+/*
+** Function ppp_curv_add -- Add the next vertex
+**
+** Inputs:
+**  c    the walk
+**  p    pointer to the x, y and z of the vertex
+**  out  the window around the vertex before p, once there is one
+**
+** Return value: int
+**  the number of windows written to out, 0 or 1
+*/
+int ppp_curv_add(ppp_curv *c, const double *p, ppp_curv_vertex *out)
+{
+ double d[3], half;
+ int k, emitted = 0;
+
+ if (c->n == 0) {
+  for (k = 0; k < 3; k++) c->prev[k] = c->first[k] = p[k];
+  c->n = 1;
+  return 0;
+ }
+
+ for (k = 0; k < 3; k++) d[k] = p[k] - c->prev[k];
+ half = 0.5 * (d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+
+ if (c->n >= 2) {
+  curv_window(c, c->n - 1, c->prev, c->d, c->half, d, half, out);
+  emitted = 1;
+ } else {
+  for (k = 0; k < 3; k++) c->d0[k] = d[k];
+  c->half0 = half;
+ }
+
+ for (k = 0; k < 3; k++) {
+  c->d[k] = d[k];
+  c->prev[k] = p[k];
+ }
+ c->half = half;
+ c->n++;
+ return emitted;
+}
+
+/*
+** Function ppp_curv_finish -- End the walk
+**
+** Inputs:
+**  c    the walk
+**  out  room for two windows
+**
+** Return value: int
+**  the number of windows written to out: for a closed polyline of 3 or
+**  more vertices the last vertex's and the first's, otherwise none
+*/
+int ppp_curv_finish(ppp_curv *c, ppp_curv_vertex *out)
+{
+ double d[3], half;
+ int k;
+
+ if (!c->closed || (c->n < 3)) return 0;
+
+ for (k = 0; k < 3; k++) d[k] = c->first[k] - c->prev[k];
+ half = 0.5 * (d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+
+ curv_window(c, c->n - 1, c->prev, c->d, c->half, d, half, &out[0]);
+ curv_window(c, 0, c->first, d, half, c->d0, c->half0, &out[1]);
+ return 2;
+}
+
+/*
+** Function ppp_curv_polyline -- Windows of a whole polyline
+**
+** Inputs:
+**  n           vertex count
+**  xyz         the vertices
+**  closed      the last vertex joins the first
+**  min_radius  windows tighter than this are violations, 0 for none
+**  out         n windows, in vertex order; the ends of an open polyline
+**    are PPP_CURV_NONE
+**
+** Return value: long
+**  the number of violations
+*/
+long ppp_curv_polyline(long n, const double (*xyz)[3], int closed, double min_radius,
+   ppp_curv_vertex *out)
+{
+ ppp_curv c;
+ ppp_curv_vertex last[2];
+ double a[3], b[3], ha, hb;
+ long i;
+
+ ppp_curv_init(&c, closed, min_radius);
+
+ /*
+ ** The same walk as ppp_curv_add, with the last edge kept in locals
+ ** rather than in c, which the compiler would store and reload
+ */
+ if (n >= 2) {
+  a[0] = xyz[1][0] - xyz[0][0];
+  a[1] = xyz[1][1] - xyz[0][1];
+  a[2] = xyz[1][2] - xyz[0][2];
+  ha = 0.5 * (a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+  for (i = 0; i < 3; i++) {
+   c.first[i] = xyz[0][i];
+   c.d0[i] = a[i];
+  }
+  c.half0 = ha;
+  for (i = 1; i < n - 1; i++) {
+   b[0] = xyz[i + 1][0] - xyz[i][0];
+   b[1] = xyz[i + 1][1] - xyz[i][1];
+   b[2] = xyz[i + 1][2] - xyz[i][2];
+   hb = 0.5 * (b[0] * b[0] + b[1] * b[1] + b[2] * b[2]);
+   curv_window(&c, i, xyz[i], a, ha, b, hb, &out[i]);
+   a[0] = b[0]; a[1] = b[1]; a[2] = b[2];
+   ha = hb;
+  }
+  for (i = 0; i < 3; i++) {
+   c.prev[i] = xyz[n - 1][i];
+   c.d[i] = a[i];
+  }
+  c.half = ha;
+  c.n = n;
+ }
+
+ if (ppp_curv_finish(&c, last) == 2) {
+  out[n - 1] = last[0];
+  out[0] = last[1];
+ } else {
+  for (i = 0; i < n; i += (n > 1) ? n - 1 : 1) {
+   out[i].index = i;
+   out[i].kind = PPP_CURV_NONE;
+   out[i].violation = false;
+   out[i].radius = HUGE_VAL;
+   out[i].center.x = xyz[i][0];
+   out[i].center.y = xyz[i][1];
+   out[i].center.z = xyz[i][2];
+  }
+ }
+ return c.violations;
+}
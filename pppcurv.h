@@ -0,0 +1,60 @@
+/*
+** pppcurv.h
+*/
+
+#ifndef PPPCURV_H
+#define PPPCURV_H
+
+#include "pppcir.h"
+
+/*
+** What the window of three consecutive vertices around a vertex is.
+** A straight window has an infinite radius, a cusp, where the path
+** turns back on itself, a radius of 0.  The ends of an open polyline
+** and vertices next to a coincident one have no window.
+*/
+#define PPP_CURV_OK       0
+#define PPP_CURV_STRAIGHT 1
+#define PPP_CURV_CUSP     2
+#define PPP_CURV_NONE     3
+
+typedef struct PPP_CURV_VERTEX
+{
+ long index;        /* vertex in the sequence, from 0 */
+ int kind;          /* PPP_CURV_* */
+ int violation;     /* radius below min_radius */
+ double radius;
+ v3_pos center;     /* the vertex itself unless PPP_CURV_OK */
+} ppp_curv_vertex;
+
+/*
+** A walk along one polyline.  Each edge's bisector plane, normal d and
+** offset |d|^2 / 2 from the edge's start, is made once and shared by
+** the windows on both sides of it.
+*/
+typedef struct PPP_CURV
+{
+ int closed;
+ double min_radius;     /* 0 for no violations */
+ long n;                /* vertices added */
+ double prev[3];        /* the last vertex */
+ double d[3], half;     /* bisector of the last edge */
+ double first[3];       /* closed: the first vertex */
+ double d0[3], half0;   /* closed: bisector of the first edge */
+
+ /* totals */
+ long straight, cusps, violations;
+ double radius_min;     /* tightest window, HUGE_VAL if none */
+ long radius_min_at;
+} ppp_curv;
+
+void ppp_curv_init(ppp_curv *c, int closed, double min_radius);
+
+int ppp_curv_add(ppp_curv *c, const double *p, ppp_curv_vertex *out);
+
+int ppp_curv_finish(ppp_curv *c, ppp_curv_vertex *out);
+
+long ppp_curv_polyline(long n, const double (*xyz)[3], int closed, double min_radius,
+      ppp_curv_vertex *out);
+
+#endif
@@ -0,0 +1,399 @@
+/*
+** pppfit.c
+**
+** Contents: Least squares circle through any number of 3D points, in
+**    one streaming pass with constant memory.
+**
+** ppp_fit_add accumulates the moments of (x, y, z, 1) up to 4th order
+** relative to the first point, 35 sums in all.  ppp_fit_solve then
+**
+**  1. takes the centroid and covariance from the 2nd order moments and
+**     fits the plane through the centroid normal to the eigenvector of
+**     the smallest eigenvalue,
+**  2. projects the 3rd and 4th order moments onto the plane axes, which
+**     gives the centered 2D moments Mxx .. Mzz with z = x^2 + y^2,
+**  3. solves the Kasa or Pratt algebraic fit on those moments (Pratt by
+**     Newton iteration on its characteristic polynomial, after Chernov),
+**  4. estimates the RMS residual from the same moments, using the
+**     algebraic distance (d^2 - r^2) / 2r for the in-plane part and the
+**     smallest eigenvalue for the out of plane part.
+**
+** The algebraic fits are not the geometric least squares circle.
+** ppp_fit_refine takes Gauss-Newton steps on the geometric residual
+** |q - c| - r of the points q projected onto the fitted plane, one more
+** pass over the points per step, and gives the exact RMS distance of
+** the points from the circle.
+*/
+
+#include <float.h>
+#include "pppfit.h"
+
+static void jacobi3(double a[3][3], double w[3], double e[3][3]);
+
+/*
+** Function ppp_fit_init -- Start an empty fit
+*/
+void ppp_fit_init(ppp_fit *fit)
+{
+ int i;
+
+ fit->n = 0;
+ fit->origin.x = fit->origin.y = fit->origin.z = 0.0;
+ for (i = 0; i < PPP_FIT_MOMENTS; i++) fit->m[i] = 0.0;
+}
+
+/*
+** Function ppp_fit_add -- Add one point to a fit
+**
+** Inputs:
+**  fit  pointer to the fit
+**  p    pointer to the x, y and z of the point
+*/
+void ppp_fit_add(ppp_fit *fit, const double *p)
+{
+ double q[4], qi, qij, qijk;
+ int i, j, k, l, c = 0;
+
+ if (fit->n == 0) {
+  fit->origin.x = p[0];
+  fit->origin.y = p[1];
+  fit->origin.z = p[2];
+ }
+ q[0] = p[0] - fit->origin.x;
+ q[1] = p[1] - fit->origin.y;
+ q[2] = p[2] - fit->origin.z;
+ q[3] = 1.0;
+
+ /* one sum per index tuple i <= j <= k <= l */
+ for (i = 0; i < 4; i++) {
+  qi = q[i];
+  for (j = i; j < 4; j++) {
+   qij = qi * q[j];
+   for (k = j; k < 4; k++) {
+    qijk = qij * q[k];
+    for (l = k; l < 4; l++) fit->m[c++] += qijk * q[l];
+   }
+  }
+ }
+ fit->n++;
+}
+
+/*
+** Function moment -- Mean of a(q) b(q) c(q) d(q) over the points, for
+**    affine forms a..d given as 4-vectors acting on (q, 1)
+*/
+static double moment(double t[4][4][4][4], const double *a, const double *b,
+      const double *c, const double *d)
+{
+ int i, j, k, l;
+ double s = 0.0, si, sij, sijk;
+
+ for (i = 0; i < 4; i++) {
+  if (a[i] == 0.0) continue;
+  si = 0.0;
+  for (j = 0; j < 4; j++) {
+   if (b[j] == 0.0) continue;
+   sij = 0.0;
+   for (k = 0; k < 4; k++) {
+    if (c[k] == 0.0) continue;
+    sijk = 0.0;
+    for (l = 0; l < 4; l++) sijk += t[i][j][k][l] * d[l];
+    sij += sijk * c[k];
+   }
+   si += sij * b[j];
+  }
+  s += si * a[i];
+ }
+ return s;
+}
+
+/*
+** Function ppp_fit_solve -- Fit a circle to the points added so far
+**
+** Inputs:
+**  fit     pointer to the fit
+**  method  PPP_FIT_KASA or PPP_FIT_PRATT
+**  circle  pointer to storage for the circle; u is the major axis of
+**    the points, u, v and normal form a right handed basis, rms is the
+**    moment estimate of the RMS distance of the points from the circle
+**
+** Return value: int
+**  true  *circle valid -- circle was found
+**  false *circle undefined -- fewer than 3 points, or all of them on
+**    a line
+*/
+int ppp_fit_solve(const ppp_fit *fit, int method, ppp_fit_circle *circle)
+{
+ double t[4][4][4][4], cov[3][3], w[3], e[3][3], mean[3];
+ double X[4], Y[4], E[4] = { 0.0, 0.0, 0.0, 1.0 };
+ double Mxx, Mxy, Myy, Mxz, Myz, Mzz, Mz, cov_xy;
+ double A0, A1, A2, A22, x, xold, y, yold, dy, det, a, b, r2, K, err;
+ double inv_n;
+ int idx[4], i, j, k, l, c, iter, lo, hi;
+
+ if (fit->n < 3) return false;
+
+ /* expand the 35 sums to the full symmetric tensor */
+ c = 0;
+ for (i = 0; i < 4; i++)
+  for (j = i; j < 4; j++)
+   for (k = j; k < 4; k++)
+    for (l = k; l < 4; l++, c++) {
+     int p0, p1, p2, p3;
+
+     idx[0] = i; idx[1] = j; idx[2] = k; idx[3] = l;
+     for (p0 = 0; p0 < 4; p0++)
+      for (p1 = 0; p1 < 4; p1++)
+       for (p2 = 0; p2 < 4; p2++)
+        for (p3 = 0; p3 < 4; p3++)
+         if ((p0 != p1) && (p0 != p2) && (p0 != p3) && (p1 != p2) &&
+           (p1 != p3) && (p2 != p3))
+          t[idx[p0]][idx[p1]][idx[p2]][idx[p3]] = fit->m[c];
+    }
+
+ inv_n = 1.0 / (double)fit->n;
+ for (i = 0; i < 4; i++)
+  for (j = 0; j < 4; j++)
+   for (k = 0; k < 4; k++)
+    for (l = 0; l < 4; l++) t[i][j][k][l] *= inv_n;
+
+ /* plane: centroid and the covariance eigenvectors */
+ for (i = 0; i < 3; i++) mean[i] = t[i][3][3][3];
+ for (i = 0; i < 3; i++)
+  for (j = 0; j < 3; j++) cov[i][j] = t[i][j][3][3] - mean[i] * mean[j];
+ jacobi3(cov, w, e);
+
+ lo = 0; hi = 0;
+ for (i = 1; i < 3; i++) {
+  if (w[i] < w[lo]) lo = i;
+  if (w[i] > w[hi]) hi = i;
+ }
+ if (lo == hi) hi = (lo + 1) % 3;
+
+ circle->normal.x = e[0][lo]; circle->normal.y = e[1][lo]; circle->normal.z = e[2][lo];
+ circle->u.x = e[0][hi]; circle->u.y = e[1][hi]; circle->u.z = e[2][hi];
+ circle->v.x = circle->normal.y * circle->u.z - circle->normal.z * circle->u.y;
+ circle->v.y = circle->normal.z * circle->u.x - circle->normal.x * circle->u.z;
+ circle->v.z = circle->normal.x * circle->u.y - circle->normal.y * circle->u.x;
+
+ /* in plane coordinates x = u . (q - mean), y = v . (q - mean) */
+ X[0] = circle->u.x; X[1] = circle->u.y; X[2] = circle->u.z;
+ Y[0] = circle->v.x; Y[1] = circle->v.y; Y[2] = circle->v.z;
+ X[3] = -(X[0] * mean[0] + X[1] * mean[1] + X[2] * mean[2]);
+ Y[3] = -(Y[0] * mean[0] + Y[1] * mean[1] + Y[2] * mean[2]);
+
+ Mxx = moment(t, X, X, E, E);
+ Mxy = moment(t, X, Y, E, E);
+ Myy = moment(t, Y, Y, E, E);
+ Mxz = moment(t, X, X, X, E) + moment(t, X, Y, Y, E);
+ Myz = moment(t, X, X, Y, E) + moment(t, Y, Y, Y, E);
+ Mzz = moment(t, X, X, X, X) + 2.0 * moment(t, X, X, Y, Y) + moment(t, Y, Y, Y, Y);
+ Mz = Mxx + Myy;
+ cov_xy = Mxx * Myy - Mxy * Mxy;
+ if (!(cov_xy > 0.0)) return false;
+
+ /* x = 0 is the Kasa fit, Pratt takes the smallest root of its
+    characteristic polynomial, found by Newton from 0 */
+ x = 0.0;
+ if (method == PPP_FIT_PRATT) {
+  A2 = 4.0 * cov_xy - 3.0 * Mz * Mz - Mzz;
+  A1 = Mzz * Mz + 4.0 * cov_xy * Mz - Mxz * Mxz - Myz * Myz - Mz * Mz * Mz;
+  A0 = Mxz * Mxz * Myy + Myz * Myz * Mxx - Mzz * cov_xy
+    - 2.0 * Mxz * Myz * Mxy + Mz * Mz * cov_xy;
+  A22 = A2 + A2;
+  y = DBL_MAX;
+  for (iter = 0; iter < 20; iter++) {
+   yold = y;
+   y = A0 + x * (A1 + x * (A2 + 4.0 * x * x));
+   if (fabs(y) > fabs(yold)) { x = 0.0; break; }
+   dy = A1 + x * (A22 + 16.0 * x * x);
+   if (dy == 0.0) { x = 0.0; break; }
+   xold = x;
+   x = xold - y / dy;
+   if (!(x >= 0.0)) { x = 0.0; break; }
+   if (fabs(x - xold) <= 1e-12 * fabs(x)) break;
+  }
+  if (iter == 20) x = 0.0;
+ }
+
+ det = x * x - x * Mz + cov_xy;
+ if (det == 0.0) return false;
+ a = (Mxz * (Myy - x) - Myz * Mxy) / (2.0 * det);
+ b = (Myz * (Mxx - x) - Mxz * Mxy) / (2.0 * det);
+ r2 = a * a + b * b + Mz + 2.0 * x;
+ if (!(r2 > 0.0) || !(r2 <= DBL_MAX)) return false;
+
+ circle->radius = sqrt(r2);
+ circle->center.x = fit->origin.x + mean[0] + a * circle->u.x + b * circle->v.x;
+ circle->center.y = fit->origin.y + mean[1] + a * circle->u.y + b * circle->v.y;
+ circle->center.z = fit->origin.z + mean[2] + a * circle->u.z + b * circle->v.z;
+ circle->n = fit->n;
+
+ /* mean of (z - 2 a x - 2 b y + K)^2, K = a^2 + b^2 - r^2, over 4 r^2 */
+ K = a * a + b * b - r2;
+ err = Mzz + 4.0 * (a * a * Mxx + b * b * Myy + 2.0 * a * b * Mxy)
+   - 4.0 * (a * Mxz + b * Myz) + 2.0 * K * Mz + K * K;
+ if (err < 0.0) err = 0.0;
+ err /= 4.0 * r2;
+ if (w[lo] > 0.0) err += w[lo];
+ circle->rms = sqrt(err);
+ return true;
+}
+
+/*
+** Function ppp_fit_refine_init -- Start a refinement pass from a circle
+*/
+void ppp_fit_refine_init(ppp_fit_refine *ref, const ppp_fit_circle *circle)
+{
+ int i;
+
+ ref->circle = *circle;
+ ref->n = 0;
+ for (i = 0; i < 6; i++) ref->jtj[i] = 0.0;
+ for (i = 0; i < 3; i++) ref->jtr[i] = 0.0;
+ ref->rr = 0.0;
+ ref->hh = 0.0;
+}
+
+/*
+** Function ppp_fit_refine_add -- Add one point to a refinement pass
+**
+** The residual of the point is its distance from the circle: h out of
+** the plane, rho - r in the plane.  The Jacobian of rho - r with respect
+** to the in plane center offset and the radius goes into the normal
+** equations.
+*/
+void ppp_fit_refine_add(ppp_fit_refine *ref, const double *p)
+{
+ const ppp_fit_circle *c = &ref->circle;
+ double dx, dy, dz, x, y, h, rho, r, j0, j1;
+
+ dx = p[0] - c->center.x;
+ dy = p[1] - c->center.y;
+ dz = p[2] - c->center.z;
+ x = dx * c->u.x + dy * c->u.y + dz * c->u.z;
+ y = dx * c->v.x + dy * c->v.y + dz * c->v.z;
+ h = dx * c->normal.x + dy * c->normal.y + dz * c->normal.z;
+ rho = sqrt(x * x + y * y);
+ r = rho - c->radius;
+
+ ref->n++;
+ ref->rr += r * r;
+ ref->hh += h * h;
+ if (rho == 0.0) return;
+
+ /* J = (-x / rho, -y / rho, -1) */
+ j0 = -x / rho;
+ j1 = -y / rho;
+ ref->jtj[0] += j0 * j0;
+ ref->jtj[1] += j0 * j1;
+ ref->jtj[2] -= j0;
+ ref->jtj[3] += j1 * j1;
+ ref->jtj[4] -= j1;
+ ref->jtj[5] += 1.0;
+ ref->jtr[0] += j0 * r;
+ ref->jtr[1] += j1 * r;
+ ref->jtr[2] -= r;
+}
+
+/*
+** Function ppp_fit_refine_rms -- RMS distance of the points of a pass
+**    from the circle the pass started with
+*/
+double ppp_fit_refine_rms(const ppp_fit_refine *ref)
+{
+ if (ref->n == 0) return 0.0;
+ return sqrt((ref->rr + ref->hh) / (double)ref->n);
+}
+
+/*
+** Function ppp_fit_refine_step -- Apply the Gauss-Newton step of a pass
+**
+** Inputs:
+**  ref     pointer to the finished pass
+**  circle  pointer to storage for the moved circle; the plane and rms
+**    are copied from the circle the pass started with
+**
+** Return value: int
+**  true  *circle valid
+**  false *circle undefined -- the normal equations are singular or the
+**    step collapses the radius
+*/
+int ppp_fit_refine_step(const ppp_fit_refine *ref, ppp_fit_circle *circle)
+{
+ const double *m = ref->jtj, *g = ref->jtr;
+ double c00, c01, c02, c11, c12, c22, det, d0, d1, d2;
+
+ /* solve JtJ d = -Jt r by the adjugate */
+ c00 = m[3] * m[5] - m[4] * m[4];
+ c01 = m[2] * m[4] - m[1] * m[5];
+ c02 = m[1] * m[4] - m[2] * m[3];
+ c11 = m[0] * m[5] - m[2] * m[2];
+ c12 = m[1] * m[2] - m[0] * m[4];
+ c22 = m[0] * m[3] - m[1] * m[1];
+ det = m[0] * c00 + m[1] * c01 + m[2] * c02;
+ if (!(fabs(det) > 0.0)) return false;
+
+ d0 = -(c00 * g[0] + c01 * g[1] + c02 * g[2]) / det;
+ d1 = -(c01 * g[0] + c11 * g[1] + c12 * g[2]) / det;
+ d2 = -(c02 * g[0] + c12 * g[1] + c22 * g[2]) / det;
+
+ *circle = ref->circle;
+ circle->radius += d2;
+ if (!(circle->radius > 0.0) || !(circle->radius <= DBL_MAX)) return false;
+ circle->center.x += d0 * circle->u.x + d1 * circle->v.x;
+ circle->center.y += d0 * circle->u.y + d1 * circle->v.y;
+ circle->center.z += d0 * circle->u.z + d1 * circle->v.z;
+ return true;
+}
+
+/*
+** Function jacobi3 -- Eigenvalues and eigenvectors of a symmetric 3x3
+**    matrix by cyclic Jacobi rotations
+**
+** Inputs:
+**  a  the matrix, destroyed
+**  w  storage for the eigenvalues
+**  e  storage for the eigenvectors, one per column
+*/
+static void jacobi3(double a[3][3], double w[3], double e[3][3])
+{
+ int i, j, k, p, q, sweep;
+ double off, theta, t, c, s, apq, app, aqq, akp, akq;
+
+ for (i = 0; i < 3; i++)
+  for (j = 0; j < 3; j++) e[i][j] = (i == j) ? 1.0 : 0.0;
+
+ for (sweep = 0; sweep < 50; sweep++) {
+  off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+  if (off == 0.0) break;
+  for (p = 0; p < 2; p++) {
+   for (q = p + 1; q < 3; q++) {
+    apq = a[p][q];
+    if (apq == 0.0) continue;
+    app = a[p][p];
+    aqq = a[q][q];
+    theta = (aqq - app) / (2.0 * apq);
+    t = (theta >= 0.0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+    c = 1.0 / sqrt(t * t + 1.0);
+    s = t * c;
+    a[p][p] = app - t * apq;
+    a[q][q] = aqq + t * apq;
+    a[p][q] = a[q][p] = 0.0;
+    for (k = 0; k < 3; k++) {
+     if ((k != p) && (k != q)) {
+      akp = a[k][p];
+      akq = a[k][q];
+      a[k][p] = a[p][k] = c * akp - s * akq;
+      a[k][q] = a[q][k] = s * akp + c * akq;
+     }
+     akp = e[k][p];
+     akq = e[k][q];
+     e[k][p] = c * akp - s * akq;
+     e[k][q] = s * akp + c * akq;
+    }
+   }
+  }
+ }
+ for (i = 0; i < 3; i++) w[i] = a[i][i];
+}
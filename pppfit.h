@@ -0,0 +1,66 @@
+/*
+** pppfit.h
+*/
+
+#ifndef PPPFIT_H
+#define PPPFIT_H
+
+#include "pppcir.h"
+
+/*
+** Algebraic fits for ppp_fit_solve.  PPP_FIT_KASA minimizes the
+** algebraic distance |p - c|^2 - r^2, PPP_FIT_PRATT does the same under
+** Pratt's normalization, which removes most of the bias of Kasa on
+** short arcs.
+*/
+#define PPP_FIT_KASA  0
+#define PPP_FIT_PRATT 1
+
+/*
+** Moments of (x, y, z, 1) up to 4th order, relative to the first point
+** added: 35 sums, whatever the point count.
+*/
+#define PPP_FIT_MOMENTS 35
+
+typedef struct PPP_FIT
+{
+ long n;
+ v3_pos origin;
+ double m[PPP_FIT_MOMENTS];
+} ppp_fit;
+
+typedef struct PPP_FIT_CIRCLE
+{
+ v3_pos center;
+ double radius;
+ v3_vect normal;
+ v3_vect u;
+ v3_vect v;
+ double rms;
+ long n;
+} ppp_fit_circle;
+
+void ppp_fit_init(ppp_fit *fit);
+void ppp_fit_add(ppp_fit *fit, const double *p);
+int ppp_fit_solve(const ppp_fit *fit, int method, ppp_fit_circle *circle);
+
+/*
+** Gauss-Newton refinement of a fitted circle.  Each pass streams the
+** points through ppp_fit_refine_add once more.
+*/
+typedef struct PPP_FIT_REFINE
+{
+ ppp_fit_circle circle;
+ long n;
+ double jtj[6];
+ double jtr[3];
+ double rr;
+ double hh;
+} ppp_fit_refine;
+
+void ppp_fit_refine_init(ppp_fit_refine *ref, const ppp_fit_circle *circle);
+void ppp_fit_refine_add(ppp_fit_refine *ref, const double *p);
+double ppp_fit_refine_rms(const ppp_fit_refine *ref);
+int ppp_fit_refine_step(const ppp_fit_refine *ref, ppp_fit_circle *circle);
+
+#endif
@@ -0,0 +1,85 @@
+/*
+** pppgen.h
+**
+** Precision generic 3 point circle.  The solver of pppcir.c is written
+** once in ppptmpl.h and instantiated here as static inline functions
+** for three scalar types:
+**
+**    float        v2f_pos   suffix _f
+**    double       v2_pos    suffix _d
+**    long double  v2l_pos   suffix _l
+**
+** giving, for suffix S,
+**
+**    ppp_v2_dist S, ppp_line_intersect S, ppp_classify S,
+**    ppp_circle_slope S, ppp_circle_det S, ppp_circle S,
+**    ppp_circle_closed S
+**
+** e.g. ppp_circle_f.  Being inline, the whole solver can be folded into
+** the caller.  Float halves the width of each value, so a vectorizing
+** compiler fits twice as many triples per register; use it for preview
+** geometry and keep double for the final output.
+**
+** The exported double API of pppcir.c is a thin wrapper around the _d
+** instantiation.  Unlike ppp_classify there, the generic ppp_classify
+** decides collinearity on the rounded determinant.
+**
+** Define PPP_NO_LONG_DOUBLE to leave out the long double instantiation.
+*/
+
+#ifndef PPPGEN_H
+#define PPPGEN_H
+
+#include <float.h>
+#include "pppcir.h"
+
+#if defined(_MSC_VER)
+#define PPP_INLINE static __inline
+#elif defined(__GNUC__)
+#define PPP_INLINE static __inline__
+#else
+#define PPP_INLINE static
+#endif
+
+#define PPP_CAT_(a, b) a##b
+#define PPP_CAT(a, b) PPP_CAT_(a, b)
+
+typedef struct V2F_DIST_VECT
+{
+ float x;
+ float y;
+} v2f_pos;
+
+typedef struct V2L_DIST_VECT
+{
+ long double x;
+ long double y;
+} v2l_pos;
+
+#define PPP_T     float
+#define PPP_V     v2f_pos
+#define PPP_S     _f
+#define PPP_SQRT  sqrtf
+#define PPP_FABS  fabsf
+#define PPP_MAX   FLT_MAX
+#include "ppptmpl.h"
+
+#define PPP_T     double
+#define PPP_V     v2_pos
+#define PPP_S     _d
+#define PPP_SQRT  sqrt
+#define PPP_FABS  fabs
+#define PPP_MAX   DBL_MAX
+#include "ppptmpl.h"
+
+#ifndef PPP_NO_LONG_DOUBLE
+#define PPP_T     long double
+#define PPP_V     v2l_pos
+#define PPP_S     _l
+#define PPP_SQRT  sqrtl
+#define PPP_FABS  fabsl
+#define PPP_MAX   LDBL_MAX
+#include "ppptmpl.h"
+#endif
+
+#endif
@@ -0,0 +1,252 @@
+/*
+** pppqual.c
+**
+** Contents: Circumradius quality of triangle meshes.
+**
+** Triangles are streamed in with ppp_qual_add.  Each is laid into its
+** own plane, p1 at the origin and p2 on the +x axis, which keeps the
+** lengths and angles of the 3D triangle, and queued; every
+** PPP_QUAL_BATCH triangles the queue goes through ppp_circle_batch.
+** Only histograms, the worst triangles and optionally the ids over a
+** limit are kept, so memory does not grow with the mesh.
+**
+** The ratio of circumradius to shortest edge is 1/sqrt(3), about
+** 0.577, for an equilateral triangle and grows without bound as a
+** triangle flattens.  Triangles ppp_circle_batch rejects, colinear or
+** thinner than PPP_MIN_SINE, count as degenerate, with an infinite
+** ratio.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "pppqual.h"
+
+const double ppp_qual_ratio_edge[PPP_QUAL_RATIO_BINS] = {
+ 0.6, 0.7, 0.8, 1.0, 1.5, 2.0, 3.0, 5.0, 10.0, 100.0, HUGE_VAL
+};
+
+/*
+** Function qual_sift -- Restore the min heap below slot i
+*/
+static void qual_sift(ppp_qual_tri *heap, int n, int i)
+{
+ ppp_qual_tri t;
+ int c;
+
+ for (;;) {
+  c = 2 * i + 1;
+  if (c >= n) return;
+  if ((c + 1 < n) && (heap[c + 1].ratio < heap[c].ratio)) c++;
+  if (heap[i].ratio <= heap[c].ratio) return;
+  t = heap[i]; heap[i] = heap[c]; heap[c] = t;
+  i = c;
+ }
+}
+
+/*
+** Function qual_worst -- Offer a triangle to the worst list
+*/
+static void qual_worst(ppp_qual *q, int i, double ratio)
+{
+ ppp_qual_tri t;
+ int j, k;
+
+ if (q->worst_max == 0) return;
+ if ((q->worst_n == q->worst_max) && !(ratio > q->worst[0].ratio)) return;
+
+ t.ratio = ratio;
+ t.radius = q->valid[i] ? q->radius[i] : 0.0;
+ for (k = 0; k < 3; k++) t.centroid[k] = q->centroid[i][k];
+ t.id = q->id[i];
+
+ /* full: replace the least bad, else add at the end and sift up */
+ if (q->worst_n == q->worst_max) {
+  q->worst[0] = t;
+  qual_sift(q->worst, q->worst_n, 0);
+  return;
+ }
+ for (j = q->worst_n++; (j > 0) && (q->worst[(j - 1) / 2].ratio > ratio); j = (j - 1) / 2)
+  q->worst[j] = q->worst[(j - 1) / 2];
+ q->worst[j] = t;
+}
+
+/*
+** Function qual_flush -- Solve the queued triangles and fold them into
+**    the totals
+**
+** Return value: int
+**  true  done
+**  false out of memory for the over limit ids
+*/
+static int qual_flush(ppp_qual *q)
+{
+ double ratio;
+ void **grown;
+ int i, b;
+
+ if (q->n == 0) return true;
+ ppp_circle_batch(q->n, q->zero, q->zero, q->x2, q->zero, q->x3, q->y3,
+   q->cx, q->cy, q->radius, q->valid);
+
+ for (i = 0; i < q->n; i++) {
+  q->triangles++;
+  if (!q->valid[i] || !(q->shortest[i] > 0.0)) {
+   q->degenerate++;
+   ratio = HUGE_VAL;
+  } else {
+   ratio = q->radius[i] / q->shortest[i];
+   for (b = 0; ratio >= ppp_qual_ratio_edge[b]; b++);
+   q->ratio_hist[b]++;
+   if (ratio < q->ratio_min) q->ratio_min = ratio;
+   if (ratio > q->ratio_max) q->ratio_max = ratio;
+   q->ratio_sum += ratio;
+
+   frexp(q->radius[i], &b);
+   b += -1 - PPP_QUAL_RADIUS_LOW;
+   if (b < 0) b = 0;
+   if (b >= PPP_QUAL_RADIUS_BINS) b = PPP_QUAL_RADIUS_BINS - 1;
+   q->radius_hist[b]++;
+  }
+
+  qual_worst(q, i, ratio);
+
+  if ((q->limit > 0.0) && (ratio > q->limit)) {
+   if (q->keep_over) {
+    if (q->over == q->over_cap) {
+     q->over_cap = q->over_cap ? 2 * q->over_cap : 1024;
+     grown = (void **)realloc(q->over_id, q->over_cap * sizeof(void *));
+     if (!grown) return false;
+     q->over_id = grown;
+    }
+    q->over_id[q->over] = q->id[i];
+   }
+   q->over++;
+  }
+ }
+ q->n = 0;
+ return true;
+}
+
+/*
+** Function ppp_qual_init -- Start an analysis
+**
+** Inputs:
+**  q          the analysis
+**  worst      number of worst triangles to keep
+**  limit      ratio above which triangles are counted in q->over, 0
+**    for none
+**  keep_over  also keep their ids in q->over_id
+**
+** Return value: int
+**  true  ready
+**  false out of memory
+*/
+int ppp_qual_init(ppp_qual *q, int worst, double limit, int keep_over)
+{
+ double *buf;
+ int b = PPP_QUAL_BATCH;
+
+ memset(q, 0, sizeof(*q));
+ q->ratio_min = HUGE_VAL;
+ q->limit = limit;
+ q->keep_over = keep_over;
+ q->worst_max = (worst > 0) ? worst : 0;
+
+ buf = (double *)malloc(12 * b * sizeof(double));
+ q->valid = (unsigned char *)malloc(b);
+ q->id = (void **)malloc(b * sizeof(void *));
+ q->worst = (ppp_qual_tri *)malloc((q->worst_max + 1) * sizeof(ppp_qual_tri));
+ if (!buf || !q->valid || !q->id || !q->worst) {
+  free(buf);
+  ppp_qual_free(q);
+  return false;
+ }
+ q->x2 = buf; q->x3 = buf + b; q->y3 = buf + 2 * b;
+ q->zero = buf + 3 * b; q->shortest = buf + 4 * b;
+ q->cx = buf + 5 * b; q->cy = buf + 6 * b; q->radius = buf + 7 * b;
+ q->centroid = (double (*)[3])(buf + 8 * b);
+ memset(q->zero, 0, b * sizeof(double));
+ return true;
+}
+
+/*
+** Function ppp_qual_add -- Add a triangle
+**
+** Inputs:
+**  q           the analysis
+**  p1, p2, p3  vertex positions
+**  id          caller's handle for the triangle, returned in q->worst
+**    and q->over_id
+**
+** Return value: int
+**  true  added
+**  false out of memory
+*/
+int ppp_qual_add(ppp_qual *q, const double *p1, const double *p2, const double *p3, void *id)
+{
+ double b[3], c[3], e[3], lb, lc, le, bc, cross2;
+ int i = q->n, k;
+
+ for (k = 0; k < 3; k++) {
+  b[k] = p2[k] - p1[k];
+  c[k] = p3[k] - p1[k];
+  e[k] = c[k] - b[k];
+  q->centroid[i][k] = (p1[k] + p2[k] + p3[k]) / 3.0;
+ }
+ lb = b[0] * b[0] + b[1] * b[1] + b[2] * b[2];
+ lc = c[0] * c[0] + c[1] * c[1] + c[2] * c[2];
+ le = e[0] * e[0] + e[1] * e[1] + e[2] * e[2];
+ bc = b[0] * c[0] + b[1] * c[1] + b[2] * c[2];
+ cross2 = lb * lc - bc * bc;
+
+ q->shortest[i] = sqrt((lb < lc) ? ((lb < le) ? lb : le) : ((lc < le) ? lc : le));
+ lb = sqrt(lb);
+ if (lb > 0.0) {
+  q->x2[i] = lb;
+  q->x3[i] = bc / lb;
+  q->y3[i] = sqrt(cross2 > 0.0 ? cross2 : 0.0) / lb;
+ } else q->x2[i] = q->x3[i] = q->y3[i] = 0.0;
+ q->id[i] = id;
+
+ if (++q->n == PPP_QUAL_BATCH) return qual_flush(q);
+ return true;
+}
+
+static int qual_cmp(const void *a, const void *b)
+{
+ double ra = ((const ppp_qual_tri *)a)->ratio, rb = ((const ppp_qual_tri *)b)->ratio;
+
+ return (ra < rb) - (ra > rb);
+}
+
+/*
+** Function ppp_qual_finish -- Solve what is still queued and sort the
+**    worst triangles, worst first
+**
+** Return value: int
+**  true  done
+**  false out of memory
+*/
+int ppp_qual_finish(ppp_qual *q)
+{
+ if (!qual_flush(q)) return false;
+ qsort(q->worst, q->worst_n, sizeof(ppp_qual_tri), qual_cmp);
+ return true;
+}
+
+/*
+** Function ppp_qual_free -- Release an analysis
+*/
+void ppp_qual_free(ppp_qual *q)
+{
+ free(q->x2);
+ free(q->valid);
+ free(q->id);
+ free(q->worst);
+ free(q->over_id);
+ q->x2 = NULL;
+ q->valid = NULL;
+ q->id = NULL;
+ q->worst = NULL;
+ q->over_id = NULL;
+}
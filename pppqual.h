@@ -0,0 +1,74 @@
+/*
+** pppqual.h
+*/
+
+#ifndef PPPQUAL_H
+#define PPPQUAL_H
+
+#include "pppcir.h"
+
+/* triangles per ppp_circle_batch call */
+#ifndef PPP_QUAL_BATCH
+#define PPP_QUAL_BATCH 4096
+#endif
+
+/*
+** Histogram of circumradius / shortest edge, PPP_QUAL_RATIO_BINS bins
+** with the upper edges in ppp_qual_ratio_edge (the last is infinite),
+** and of the circumradius, one bin per power of 2 from
+** 2^PPP_QUAL_RADIUS_LOW (everything smaller) up.
+*/
+#define PPP_QUAL_RATIO_BINS  11
+#define PPP_QUAL_RADIUS_LOW  -24
+#define PPP_QUAL_RADIUS_BINS 49
+
+extern const double ppp_qual_ratio_edge[PPP_QUAL_RATIO_BINS];
+
+typedef struct PPP_QUAL_TRI
+{
+ double ratio;      /* HUGE_VAL for a degenerate triangle */
+ double radius;
+ double centroid[3];
+ void *id;
+} ppp_qual_tri;
+
+typedef struct PPP_QUAL
+{
+ /* the batch being filled */
+ int n;
+ double *x2, *x3, *y3;   /* in the triangle's plane, p1 at the origin, p2 on +x */
+ double *zero;
+ double *shortest;
+ double (*centroid)[3];
+ double *cx, *cy, *radius;
+ unsigned char *valid;
+ void **id;
+
+ /* totals */
+ long triangles;
+ long degenerate;       /* colinear, or slivers ppp_circle_batch rejects */
+ long over;             /* ratio above limit */
+ long ratio_hist[PPP_QUAL_RATIO_BINS];
+ long radius_hist[PPP_QUAL_RADIUS_BINS];
+ double ratio_min, ratio_max, ratio_sum;   /* over the valid triangles */
+
+ /* worst triangles, a min heap on ratio until ppp_qual_finish sorts it */
+ ppp_qual_tri *worst;
+ int worst_n, worst_max;
+
+ /* ids of the triangles over limit, when kept */
+ double limit;
+ int keep_over;
+ void **over_id;
+ long over_cap;
+} ppp_qual;
+
+int ppp_qual_init(ppp_qual *q, int worst, double limit, int keep_over);
+
+int ppp_qual_add(ppp_qual *q, const double *p1, const double *p2, const double *p3, void *id);
+
+int ppp_qual_finish(ppp_qual *q);
+
+void ppp_qual_free(ppp_qual *q);
+
+#endif
@@ -0,0 +1,515 @@
+/*
+** pppransac.c
+**
+** Contents: RANSAC detection of circles in a 3D point cloud.
+**
+** The points are binned in a hashed uniform grid with cells twice the
+** largest radius, so every point of a circle lies in the 3 x 3 x 3
+** cells around the cell of its center, and so does every point within
+** the largest diameter of a point on it.  Each round
+**
+**  1. tries params->samples triples on ppp_parallel_for workers: the
+**     first point at random among the unclaimed points, the other two
+**     at random from the cells around it, solved with ppp_circle3d and
+**     scored by counting the unclaimed points within tolerance of the
+**     circle in the cells around its center; a circle whose inliers
+**     cover less than params->min_arc of it is not counted, which
+**     keeps the short arcs where it meets other circles from passing
+**     for a circle, and neither is a circle with no more than
+**     PPP_RANSAC_MARGIN times the inliers it would have by chance,
+**  2. takes the best scoring triple, refits its inliers with the Pratt
+**     fit and params->passes Gauss-Newton passes of pppfit.c, and
+**     keeps the refit circle unless it has fewer inliers,
+**  3. claims the inliers of that circle, so later rounds ignore them.
+**
+** The chance count takes the unclaimed points as spread evenly over
+** the largest face of the bounding box, as a scanned surface is,
+** so a circle of radius r expects unclaimed 4 pi r tol / area of them
+** in its band.  min_support alone is a fixed count, while this grows
+** with the radius, which in a plane of scattered points lets every
+** large enough circle through.
+**
+** Rounds stop when the best triple has fewer than min_support inliers.
+** Without a max_radius the search starts at 1/20 of the bounding box
+** diagonal, where the cells are small and the small circles cheap to
+** find, and then doubles the largest radius and rebins the points
+** each time the rounds stop, up to half the diagonal, the largest
+** circle the points can hold.
+**
+** Every chunk of triples draws from its own generator, seeded from the
+** round and the chunk, and the best triple is picked in chunk order,
+** so the result does not depend on the number of threads.
+*/
+
+#include <stdlib.h>
+#include <float.h>
+#include "pppransac.h"
+#include "pppthread.h"
+
+#ifndef PI
+#define PI 3.14159265358979323846
+#endif
+
+typedef struct PPP_GRID
+{
+ double origin[3];
+ double inv_cell;
+ unsigned int mask;
+ int *start;   /* mask + 2 offsets into index, by bucket */
+ int *index;   /* point indices, sorted by bucket */
+} ppp_grid;
+
+typedef struct PPP_RANSAC_JOB
+{
+ int n;
+ const double (*xyz)[3];
+ const ppp_ransac_params *params;
+ double max_radius;
+ double tol2;
+ double min_arc;
+ double density;  /* inliers by chance, per unclaimed point and unit radius */
+ int unclaimed;
+ ppp_grid grid;
+ const unsigned char *claimed;
+ unsigned long long round_seed;
+ ppp_fit_circle *best;   /* one per chunk, n is the score */
+} ppp_ransac_job;
+
+/*
+** Function ransac_rand -- Next 32 random bits of a 64 bit generator
+*/
+static unsigned int ransac_rand(unsigned long long *state)
+{
+ unsigned long long z;
+
+ *state += 0x9E3779B97F4A7C15ULL;
+ z = *state;
+ z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+ z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+ return (unsigned int)((z ^ (z >> 31)) >> 32);
+}
+
+/* uniform index in [0, n) */
+#define RANSAC_PICK(state, n) ((int)(((unsigned long long)ransac_rand(state) * (unsigned int)(n)) >> 32))
+
+/*
+** Function grid_bucket -- Hash bucket of a cell
+*/
+static unsigned int grid_bucket(const ppp_grid *g, long long ix, long long iy, long long iz)
+{
+ unsigned long long h;
+
+ h = (unsigned long long)ix * 73856093ULL ^ (unsigned long long)iy * 19349663ULL
+   ^ (unsigned long long)iz * 83492791ULL;
+ return (unsigned int)(h ^ (h >> 32)) & g->mask;
+}
+
+/*
+** Function grid_cell -- Cell coordinates of a point
+*/
+static void grid_cell(const ppp_grid *g, const double *p, long long *c)
+{
+ int k;
+
+ for (k = 0; k < 3; k++) c[k] = (long long)floor((p[k] - g->origin[k]) * g->inv_cell);
+}
+
+/*
+** Function grid_near -- Buckets of the 27 cells around a point, each
+**    listed once
+**
+** Return value: int
+**  number of buckets written to bucket
+*/
+static int grid_near(const ppp_grid *g, const double *p, unsigned int *bucket)
+{
+ long long c[3];
+ unsigned int b;
+ int dx, dy, dz, i, m = 0;
+
+ grid_cell(g, p, c);
+ for (dx = -1; dx <= 1; dx++)
+  for (dy = -1; dy <= 1; dy++)
+   for (dz = -1; dz <= 1; dz++) {
+    b = grid_bucket(g, c[0] + dx, c[1] + dy, c[2] + dz);
+    for (i = 0; (i < m) && (bucket[i] != b); i++);
+    if (i == m) bucket[m++] = b;
+   }
+ return m;
+}
+
+/*
+** Function grid_build -- Bin the points
+**
+** Return value: int
+**  true  grid built
+**  false out of memory
+*/
+static int grid_build(ppp_grid *g, int n, const double (*xyz)[3], const double *lo, double cell)
+{
+ unsigned int b;
+ long long c[3];
+ int i;
+
+ g->origin[0] = lo[0]; g->origin[1] = lo[1]; g->origin[2] = lo[2];
+ g->inv_cell = 1.0 / cell;
+ for (g->mask = 1; g->mask < (unsigned int)n; g->mask <<= 1);
+ g->mask--;
+
+ g->start = (int *)calloc(g->mask + 2, sizeof(int));
+ g->index = (int *)malloc(n * sizeof(int));
+ if (!g->start || !g->index) return false;
+
+ /* count into start[b + 1], sum, then fill with start[b] as cursor */
+ for (i = 0; i < n; i++) {
+  grid_cell(g, xyz[i], c);
+  g->start[grid_bucket(g, c[0], c[1], c[2]) + 1]++;
+ }
+ for (b = 0; b <= g->mask; b++) g->start[b + 1] += g->start[b];
+ for (i = 0; i < n; i++) {
+  grid_cell(g, xyz[i], c);
+  g->index[g->start[grid_bucket(g, c[0], c[1], c[2])]++] = i;
+ }
+ for (b = g->mask + 1; b > 0; b--) g->start[b] = g->start[b - 1];
+ g->start[0] = 0;
+ return true;
+}
+
+/*
+** Function ransac_inlier -- Whether p is within tolerance of a circle
+*/
+static int ransac_inlier(const ppp_fit_circle *c, const double *p, double tol2)
+{
+ double dx, dy, dz, h, q2, e;
+
+ dx = p[0] - c->center.x;
+ dy = p[1] - c->center.y;
+ dz = p[2] - c->center.z;
+ h = dx * c->normal.x + dy * c->normal.y + dz * c->normal.z;
+ q2 = dx * dx + dy * dy + dz * dz - h * h;
+ e = sqrt(q2 > 0.0 ? q2 : 0.0) - c->radius;
+ return h * h + e * e <= tol2;
+}
+
+/*
+** Function ransac_bin -- Angular bin of a point around a circle
+*/
+static int ransac_bin(const ppp_fit_circle *c, const double *p)
+{
+ double dx, dy, dz;
+ int b;
+
+ dx = p[0] - c->center.x;
+ dy = p[1] - c->center.y;
+ dz = p[2] - c->center.z;
+ b = (int)((atan2(dx * c->v.x + dy * c->v.y + dz * c->v.z,
+   dx * c->u.x + dy * c->u.y + dz * c->u.z) + PI) * (PPP_RANSAC_BINS / (2.0 * PI)));
+ return (b < PPP_RANSAC_BINS) ? b : PPP_RANSAC_BINS - 1;
+}
+
+/*
+** Function ransac_inliers -- Count, and optionally list, the unclaimed
+**    inliers of a circle
+**
+** Inputs:
+**  job   the detection
+**  c     the circle
+**  list  the inliers' indices, or NULL
+**  bins  the angular bins holding an inlier, one bit each
+**
+** Return value: int
+**  the number of inliers
+*/
+static int ransac_inliers(const ppp_ransac_job *job, const ppp_fit_circle *c, int *list,
+   unsigned int *bins)
+{
+ unsigned int bucket[27];
+ double p[3];
+ int m, i, j, count = 0;
+
+ *bins = 0;
+ p[0] = c->center.x; p[1] = c->center.y; p[2] = c->center.z;
+ m = grid_near(&job->grid, p, bucket);
+ for (i = 0; i < m; i++) {
+  for (j = job->grid.start[bucket[i]]; j < job->grid.start[bucket[i] + 1]; j++) {
+   int k = job->grid.index[j];
+
+   if (job->claimed[k] || !ransac_inlier(c, job->xyz[k], job->tol2)) continue;
+   if (list) list[count] = k;
+   *bins |= 1U << ransac_bin(c, job->xyz[k]);
+   count++;
+  }
+ }
+ return count;
+}
+
+/*
+** Function ransac_arc -- Whether the inliers cover min_arc of the circle
+**
+** The arc covered is the bins holding an inlier, so a circle whose
+** inliers bunch up, the short arcs where it runs along other circles
+** and nothing in between, falls short even when they are spread round
+** all of it.  The empty bins that chance inliers would fill are taken
+** off again, or the few scattered points in the band of a circle that
+** grazes another one make up the arc it lacks.
+*/
+static int ransac_arc(const ppp_ransac_job *job, const ppp_fit_circle *c,
+   unsigned int bins)
+{
+ double p;
+ int filled;
+
+ for (filled = 0; bins; bins &= bins - 1) filled++;
+
+ /* share of bins holding a chance inlier */
+ p = 1.0 - exp(-job->density * job->unclaimed * c->radius / PPP_RANSAC_BINS);
+ if (p > 0.5) p = 0.5;
+ return (filled - PPP_RANSAC_BINS * p) / (1.0 - p)
+        * (2.0 * PI / PPP_RANSAC_BINS) >= job->min_arc;
+}
+
+/*
+** Function ransac_chance -- Whether a circle has more inliers than the
+**    unclaimed points would give it by chance, with PPP_RANSAC_MARGIN
+*/
+static int ransac_chance(const ppp_ransac_job *job, const ppp_fit_circle *c)
+{
+ return c->n > PPP_RANSAC_MARGIN * job->density * job->unclaimed * c->radius;
+}
+
+/*
+** Function ransac_near_pick -- A random unclaimed point from the
+**    buckets around a point, other than a and b
+**
+** Return value: int
+**  the point index, or -1 after a few misses
+*/
+static int ransac_near_pick(const ppp_ransac_job *job, const unsigned int *bucket, int total, int a, int b, unsigned long long *state)
+{
+ int tries, r, i, k;
+
+ for (tries = 0; tries < 8; tries++) {
+  r = RANSAC_PICK(state, total);
+  for (i = 0; r >= job->grid.start[bucket[i] + 1] - job->grid.start[bucket[i]]; i++)
+   r -= job->grid.start[bucket[i] + 1] - job->grid.start[bucket[i]];
+  k = job->grid.index[job->grid.start[bucket[i]] + r];
+  if (!job->claimed[k] && (k != a) && (k != b)) return k;
+ }
+ return -1;
+}
+
+/*
+** Function ransac_chunk -- ppp_parallel_for body, trying one chunk of
+**    triples and keeping the best
+*/
+static void ransac_chunk(void *ctx, int worker, int chunk)
+{
+ ppp_ransac_job *job = (ppp_ransac_job *)ctx;
+ ppp_fit_circle *best = &job->best[chunk], c;
+ unsigned long long state;
+ unsigned int bucket[27], bins;
+ v3_pos p[3];
+ int s, tries, i1, i2, i3, m, i, total, samples;
+
+ state = job->round_seed ^ ((unsigned long long)(chunk + 1) * 0xD1B54A32D192ED03ULL);
+ best->n = 0;
+ samples = job->params->samples - chunk * PPP_RANSAC_CHUNK;
+ if (samples > PPP_RANSAC_CHUNK) samples = PPP_RANSAC_CHUNK;
+
+ for (s = 0; s < samples; s++) {
+  for (tries = 0, i1 = -1; (tries < 8) && (i1 < 0); tries++) {
+   i1 = RANSAC_PICK(&state, job->n);
+   if (job->claimed[i1]) i1 = -1;
+  }
+  if (i1 < 0) continue;
+
+  m = grid_near(&job->grid, job->xyz[i1], bucket);
+  for (i = 0, total = 0; i < m; i++)
+   total += job->grid.start[bucket[i] + 1] - job->grid.start[bucket[i]];
+  if (total < 3) continue;
+  if ((i2 = ransac_near_pick(job, bucket, total, i1, i1, &state)) < 0) continue;
+  if ((i3 = ransac_near_pick(job, bucket, total, i1, i2, &state)) < 0) continue;
+
+  p[0].x = job->xyz[i1][0]; p[0].y = job->xyz[i1][1]; p[0].z = job->xyz[i1][2];
+  p[1].x = job->xyz[i2][0]; p[1].y = job->xyz[i2][1]; p[1].z = job->xyz[i2][2];
+  p[2].x = job->xyz[i3][0]; p[2].y = job->xyz[i3][1]; p[2].z = job->xyz[i3][2];
+  if (!ppp_circle3d(&p[0], &p[1], &p[2], &c.center, &c.radius, &c.normal, &c.u, &c.v))
+   continue;
+  if (!(c.radius <= job->max_radius)) continue;
+
+  c.n = ransac_inliers(job, &c, NULL, &bins);
+  if ((c.n > best->n) && ransac_chance(job, &c) && ransac_arc(job, &c, bins)) *best = c;
+ }
+}
+
+/*
+** Function ransac_refit -- Refit the inliers of a circle
+**
+** Return value: int
+**  true  *circle replaced by the refit circle
+**  false the fit failed or left the radius range
+*/
+static int ransac_refit(const ppp_ransac_job *job, const int *list, int count, ppp_fit_circle *circle)
+{
+ ppp_fit fit;
+ ppp_fit_refine refine;
+ ppp_fit_circle c, next;
+ int i, pass;
+
+ ppp_fit_init(&fit);
+ for (i = 0; i < count; i++) ppp_fit_add(&fit, job->xyz[list[i]]);
+ if (!ppp_fit_solve(&fit, PPP_FIT_PRATT, &c)) return false;
+
+ for (pass = 0; pass < job->params->passes; pass++) {
+  ppp_fit_refine_init(&refine, &c);
+  for (i = 0; i < count; i++) ppp_fit_refine_add(&refine, job->xyz[list[i]]);
+  if (!ppp_fit_refine_step(&refine, &next)) break;
+  c = next;
+ }
+ if (!(c.radius <= job->max_radius)) return false;
+ *circle = c;
+ return true;
+}
+
+/*
+** Function ppp_ransac_defaults -- Default parameters
+*/
+void ppp_ransac_defaults(ppp_ransac_params *params)
+{
+ params->tolerance = 0.0;
+ params->max_radius = 0.0;
+ params->min_support = 20;
+ params->min_arc = 2.0 * PI / 3.0;
+ params->samples = 2048;
+ params->passes = 2;
+ params->threads = 0;
+ params->seed = 1;
+}
+
+/*
+** Function ppp_ransac -- Find the circles in a point cloud
+**
+** Inputs:
+**  n            number of points
+**  xyz          the points
+**  params       parameters, see pppransac.h
+**  circles      storage for max_circles circles; n is the inlier count
+**    and rms the RMS distance of the inliers
+**  max_circles  stop after this many circles
+**
+** Return value: int
+**  number of circles found, strongest first at each largest radius
+**  searched, or -1 when out of memory
+*/
+int ppp_ransac(int n, const double (*xyz)[3], const ppp_ransac_params *params,
+      ppp_fit_circle *circles, int max_circles)
+{
+ ppp_ransac_job job;
+ ppp_fit_refine refine;
+ ppp_fit_circle pick, refit;
+ unsigned char *claimed = NULL;
+ unsigned int bins;
+ int *list = NULL, *relist = NULL, *swap;
+ double lo[3], hi[3], side[3], diag, tol, top, area;
+ int chunks, found = 0, unclaimed = n, round, i, k, count, recount;
+
+ if ((n < 3) || (params->samples <= 0)) return 0;
+
+ for (k = 0; k < 3; k++) lo[k] = hi[k] = xyz[0][k];
+ for (i = 1; i < n; i++)
+  for (k = 0; k < 3; k++) {
+   if (xyz[i][k] < lo[k]) lo[k] = xyz[i][k];
+   if (xyz[i][k] > hi[k]) hi[k] = xyz[i][k];
+  }
+ diag = sqrt((hi[0] - lo[0]) * (hi[0] - lo[0]) + (hi[1] - lo[1]) * (hi[1] - lo[1])
+   + (hi[2] - lo[2]) * (hi[2] - lo[2]));
+
+ job.n = n;
+ job.xyz = xyz;
+ job.params = params;
+ tol = (params->tolerance > 0.0) ? params->tolerance : diag * 1e-3;
+ if (!(tol > 0.0)) return 0;
+ job.max_radius = (params->max_radius > 0.0) ? params->max_radius : diag / 20.0;
+ if (job.max_radius < tol) job.max_radius = tol;
+ top = (params->max_radius > 0.0) ? job.max_radius : diag / 2.0;
+ job.tol2 = tol * tol;
+ job.min_arc = params->min_arc;
+
+ /* the largest face of the box, its sides at least the band wide */
+ for (k = 0; k < 3; k++) side[k] = (hi[k] - lo[k] > 2.0 * tol) ? hi[k] - lo[k] : 2.0 * tol;
+ area = side[0] * side[1];
+ if (side[1] * side[2] > area) area = side[1] * side[2];
+ if (side[2] * side[0] > area) area = side[2] * side[0];
+ job.density = 4.0 * PI * tol / area;
+ job.grid.start = NULL;
+ job.grid.index = NULL;
+
+ chunks = (params->samples + PPP_RANSAC_CHUNK - 1) / PPP_RANSAC_CHUNK;
+ job.best = (ppp_fit_circle *)malloc(chunks * sizeof(ppp_fit_circle));
+ claimed = (unsigned char *)calloc(n, 1);
+ list = (int *)malloc(n * sizeof(int));
+ relist = (int *)malloc(n * sizeof(int));
+ if (!job.best || !claimed || !list || !relist
+   || !grid_build(&job.grid, n, xyz, lo, 2.0 * job.max_radius + tol)) {
+  found = -1;
+  goto done;
+ }
+ job.claimed = claimed;
+
+ for (round = 0; (found < max_circles) && (unclaimed >= params->min_support); round++) {
+  job.round_seed = params->seed * 0x2545F4914F6CDD1DULL + (unsigned long long)round;
+  job.unclaimed = unclaimed;
+  ppp_parallel_for(chunks, params->threads, ransac_chunk, &job);
+
+  /* first best in chunk order, whatever thread tried it */
+  pick.n = 0;
+  for (i = 0; i < chunks; i++)
+   if (job.best[i].n > pick.n) pick = job.best[i];
+  if ((pick.n < 3) || (pick.n < params->min_support)) {
+   if (job.max_radius >= top) break;
+
+   /* nothing left this size, look for larger circles */
+   job.max_radius = (2.0 * job.max_radius < top) ? 2.0 * job.max_radius : top;
+   free(job.grid.start);
+   free(job.grid.index);
+   if (!grid_build(&job.grid, n, xyz, lo, 2.0 * job.max_radius + tol)) {
+    found = -1;
+    goto done;
+   }
+   continue;
+  }
+
+  count = ransac_inliers(&job, &pick, list, &bins);
+  refit = pick;
+  if (ransac_refit(&job, list, count, &refit)) {
+   refit.n = recount = ransac_inliers(&job, &refit, relist, &bins);
+   if ((recount >= count) && ransac_chance(&job, &refit) && ransac_arc(&job, &refit, bins)) {
+    pick = refit;
+    count = recount;
+    swap = list;
+    list = relist;
+    relist = swap;
+   }
+  }
+
+  /* RMS distance of the inliers, then claim them */
+  ppp_fit_refine_init(&refine, &pick);
+  for (i = 0; i < count; i++) {
+   ppp_fit_refine_add(&refine, xyz[list[i]]);
+   claimed[list[i]] = 1;
+  }
+  pick.rms = ppp_fit_refine_rms(&refine);
+  pick.n = count;
+  unclaimed -= count;
+  circles[found++] = pick;
+ }
+
+done:
+ free(job.grid.start);
+ free(job.grid.index);
+ free(job.best);
+ free(claimed);
+ free(list);
+ free(relist);
+ return found;
+}
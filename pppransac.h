@@ -0,0 +1,51 @@
+/*
+** pppransac.h
+*/
+
+#ifndef PPPRANSAC_H
+#define PPPRANSAC_H
+
+#include "pppfit.h"
+
+/*
+** Parameters of ppp_ransac, as set by ppp_ransac_defaults.
+*/
+typedef struct PPP_RANSAC_PARAMS
+{
+ double tolerance;      /* largest distance of an inlier from its circle; 0 for 1/1000 of the diagonal */
+ double max_radius;     /* largest circle; 0 to search from 1/20 of the bounding box
+                           diagonal up to half of it */
+ int min_support;       /* inliers needed to accept a circle, and more than
+                           PPP_RANSAC_MARGIN times those it would have by chance */
+ double min_arc;        /* arc, in radians, the inliers must cover */
+ int samples;           /* triples tried per circle found */
+ int passes;            /* Gauss-Newton passes over the inliers */
+ int threads;           /* 0 for one per processor */
+ unsigned long long seed;
+} ppp_ransac_params;
+
+/* triples per work item of the sampling rounds */
+#ifndef PPP_RANSAC_CHUNK
+#define PPP_RANSAC_CHUNK 64
+#endif
+
+/*
+** How many times the inliers a circle would have by chance, from the
+** unclaimed points spread evenly over the bounding box, it needs
+** besides min_support.
+*/
+#ifndef PPP_RANSAC_MARGIN
+#define PPP_RANSAC_MARGIN 3.0
+#endif
+
+/* angular bins measuring the arc the inliers span, at most 32 */
+#ifndef PPP_RANSAC_BINS
+#define PPP_RANSAC_BINS 32
+#endif
+
+void ppp_ransac_defaults(ppp_ransac_params *params);
+
+int ppp_ransac(int n, const double (*xyz)[3], const ppp_ransac_params *params,
+      ppp_fit_circle *circles, int max_circles);
+
+#endif
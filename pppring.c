@@ -0,0 +1,424 @@
+/*
+** pppring.c
+**
+** Contents: Unit circle tables and ring vertex generation.
+**
+** ppp_ring_table returns the cos/sin of 2 pi i / sides for i in
+** [0, sides).  Tables for 8, 16, 32, 64 and 128 sides are compiled in
+** (correctly rounded, exact at the quadrants).  Other side counts are
+** built once with the angle addition recurrence, which costs two trig
+** calls per table, and kept in a small cache, so generating a ring
+** with ppp_ring_emit costs only multiplies and adds: a loop over the
+** table, or for PPP_RING_BATCH sides and more where AVX2 is there, one
+** ppp_affine_batch call (pppbatch.c) on it.
+**
+** The recurrence drifts by about sides * 1e-16, well below what a
+** Modeler vertex can hold.
+**
+** ppp_arc_emit generates open arcs with the same recurrence, started
+** at the arc's own angle, so it needs no table.
+**
+** The cache is not thread safe: look tables up from one thread at a
+** time, with callers synchronised by a join, as the panel thread of
+** 3PointCircle.c is before the main thread builds rings again.
+*/
+
+#include <stdlib.h>
+#include "pppring.h"
+
+#ifndef PI
+#define PI 3.14159265358979323846
+#endif
+
+static const double ppp_cos8[8] = {
+  1.0,  0.7071067811865476,  0.0, -0.7071067811865476,
+ -1.0, -0.7071067811865476,  0.0,  0.7071067811865476
+};
+
+static const double ppp_sin8[8] = {
+  0.0,  0.7071067811865476,  1.0,  0.7071067811865476,
+  0.0, -0.7071067811865476, -1.0, -0.7071067811865476
+};
+
+static const double ppp_cos16[16] = {
+  1.0,  0.9238795325112867,  0.7071067811865476,  0.3826834323650898,
+  0.0, -0.3826834323650898, -0.7071067811865476, -0.9238795325112867,
+ -1.0, -0.9238795325112867, -0.7071067811865476, -0.3826834323650898,
+  0.0,  0.3826834323650898,  0.7071067811865476,  0.9238795325112867
+};
+
+static const double ppp_sin16[16] = {
+  0.0,  0.3826834323650898,  0.7071067811865476,  0.9238795325112867,
+  1.0,  0.9238795325112867,  0.7071067811865476,  0.3826834323650898,
+  0.0, -0.3826834323650898, -0.7071067811865476, -0.9238795325112867,
+ -1.0, -0.9238795325112867, -0.7071067811865476, -0.3826834323650898
+};
+
+static const double ppp_cos32[32] = {
+  1.0,  0.9807852804032304,  0.9238795325112867,  0.8314696123025452,
+  0.7071067811865476,  0.5555702330196022,  0.3826834323650898,  0.19509032201612828,
+  0.0, -0.19509032201612828, -0.3826834323650898, -0.5555702330196022,
+ -0.7071067811865476, -0.8314696123025452, -0.9238795325112867, -0.9807852804032304,
+ -1.0, -0.9807852804032304, -0.9238795325112867, -0.8314696123025452,
+ -0.7071067811865476, -0.5555702330196022, -0.3826834323650898, -0.19509032201612828,
+  0.0,  0.19509032201612828,  0.3826834323650898,  0.5555702330196022,
+  0.7071067811865476,  0.8314696123025452,  0.9238795325112867,  0.9807852804032304
+};
+
+static const double ppp_sin32[32] = {
+  0.0,  0.19509032201612828,  0.3826834323650898,  0.5555702330196022,
+  0.7071067811865476,  0.8314696123025452,  0.9238795325112867,  0.9807852804032304,
+  1.0,  0.9807852804032304,  0.9238795325112867,  0.8314696123025452,
+  0.7071067811865476,  0.5555702330196022,  0.3826834323650898,  0.19509032201612828,
+  0.0, -0.19509032201612828, -0.3826834323650898, -0.5555702330196022,
+ -0.7071067811865476, -0.8314696123025452, -0.9238795325112867, -0.9807852804032304,
+ -1.0, -0.9807852804032304, -0.9238795325112867, -0.8314696123025452,
+ -0.7071067811865476, -0.5555702330196022, -0.3826834323650898, -0.19509032201612828
+};
+
+static const double ppp_cos64[64] = {
+  1.0,  0.9951847266721969,  0.9807852804032304,  0.9569403357322088,
+  0.9238795325112867,  0.881921264348355,  0.8314696123025452,  0.773010453362737,
+  0.7071067811865476,  0.6343932841636455,  0.5555702330196022,  0.47139673682599764,
+  0.3826834323650898,  0.2902846772544624,  0.19509032201612828,  0.0980171403295606,
+  0.0, -0.0980171403295606, -0.19509032201612828, -0.2902846772544624,
+ -0.3826834323650898, -0.47139673682599764, -0.5555702330196022, -0.6343932841636455,
+ -0.7071067811865476, -0.773010453362737, -0.8314696123025452, -0.881921264348355,
+ -0.9238795325112867, -0.9569403357322088, -0.9807852804032304, -0.9951847266721969,
+ -1.0, -0.9951847266721969, -0.9807852804032304, -0.9569403357322088,
+ -0.9238795325112867, -0.881921264348355, -0.8314696123025452, -0.773010453362737,
+ -0.7071067811865476, -0.6343932841636455, -0.5555702330196022, -0.47139673682599764,
+ -0.3826834323650898, -0.2902846772544624, -0.19509032201612828, -0.0980171403295606,
+  0.0,  0.0980171403295606,  0.19509032201612828,  0.2902846772544624,
+  0.3826834323650898,  0.47139673682599764,  0.5555702330196022,  0.6343932841636455,
+  0.7071067811865476,  0.773010453362737,  0.8314696123025452,  0.881921264348355,
+  0.9238795325112867,  0.9569403357322088,  0.9807852804032304,  0.9951847266721969
+};
+
+static const double ppp_sin64[64] = {
+  0.0,  0.0980171403295606,  0.19509032201612828,  0.2902846772544624,
+  0.3826834323650898,  0.47139673682599764,  0.5555702330196022,  0.6343932841636455,
+  0.7071067811865476,  0.773010453362737,  0.8314696123025452,  0.881921264348355,
+  0.9238795325112867,  0.9569403357322088,  0.9807852804032304,  0.9951847266721969,
+  1.0,  0.9951847266721969,  0.9807852804032304,  0.9569403357322088,
+  0.9238795325112867,  0.881921264348355,  0.8314696123025452,  0.773010453362737,
+  0.7071067811865476,  0.6343932841636455,  0.5555702330196022,  0.47139673682599764,
+  0.3826834323650898,  0.2902846772544624,  0.19509032201612828,  0.0980171403295606,
+  0.0, -0.0980171403295606, -0.19509032201612828, -0.2902846772544624,
+ -0.3826834323650898, -0.47139673682599764, -0.5555702330196022, -0.6343932841636455,
+ -0.7071067811865476, -0.773010453362737, -0.8314696123025452, -0.881921264348355,
+ -0.9238795325112867, -0.9569403357322088, -0.9807852804032304, -0.9951847266721969,
+ -1.0, -0.9951847266721969, -0.9807852804032304, -0.9569403357322088,
+ -0.9238795325112867, -0.881921264348355, -0.8314696123025452, -0.773010453362737,
+ -0.7071067811865476, -0.6343932841636455, -0.5555702330196022, -0.47139673682599764,
+ -0.3826834323650898, -0.2902846772544624, -0.19509032201612828, -0.0980171403295606
+};
+
+static const double ppp_cos128[128] = {
+  1.0,  0.9987954562051724,  0.9951847266721969,  0.989176509964781,
+  0.9807852804032304,  0.970031253194544,  0.9569403357322088,  0.9415440651830208,
+  0.9238795325112867,  0.9039892931234433,  0.881921264348355,  0.8577286100002721,
+  0.8314696123025452,  0.8032075314806449,  0.773010453362737,  0.7409511253549591,
+  0.7071067811865476,  0.6715589548470184,  0.6343932841636455,  0.5956993044924334,
+  0.5555702330196022,  0.5141027441932218,  0.47139673682599764,  0.4275550934302821,
+  0.3826834323650898,  0.33688985339222005,  0.2902846772544624,  0.2429801799032639,
+  0.19509032201612828,  0.14673047445536175,  0.0980171403295606,  0.049067674327418015,
+  0.0, -0.049067674327418015, -0.0980171403295606, -0.14673047445536175,
+ -0.19509032201612828, -0.2429801799032639, -0.2902846772544624, -0.33688985339222005,
+ -0.3826834323650898, -0.4275550934302821, -0.47139673682599764, -0.5141027441932218,
+ -0.5555702330196022, -0.5956993044924334, -0.6343932841636455, -0.6715589548470184,
+ -0.7071067811865476, -0.7409511253549591, -0.773010453362737, -0.8032075314806449,
+ -0.8314696123025452, -0.8577286100002721, -0.881921264348355, -0.9039892931234433,
+ -0.9238795325112867, -0.9415440651830208, -0.9569403357322088, -0.970031253194544,
+ -0.9807852804032304, -0.989176509964781, -0.9951847266721969, -0.9987954562051724,
+ -1.0, -0.9987954562051724, -0.9951847266721969, -0.989176509964781,
+ -0.9807852804032304, -0.970031253194544, -0.9569403357322088, -0.9415440651830208,
+ -0.9238795325112867, -0.9039892931234433, -0.881921264348355, -0.8577286100002721,
+ -0.8314696123025452, -0.8032075314806449, -0.773010453362737, -0.7409511253549591,
+ -0.7071067811865476, -0.6715589548470184, -0.6343932841636455, -0.5956993044924334,
+ -0.5555702330196022, -0.5141027441932218, -0.47139673682599764, -0.4275550934302821,
+ -0.3826834323650898, -0.33688985339222005, -0.2902846772544624, -0.2429801799032639,
+ -0.19509032201612828, -0.14673047445536175, -0.0980171403295606, -0.049067674327418015,
+  0.0,  0.049067674327418015,  0.0980171403295606,  0.14673047445536175,
+  0.19509032201612828,  0.2429801799032639,  0.2902846772544624,  0.33688985339222005,
+  0.3826834323650898,  0.4275550934302821,  0.47139673682599764,  0.5141027441932218,
+  0.5555702330196022,  0.5956993044924334,  0.6343932841636455,  0.6715589548470184,
+  0.7071067811865476,  0.7409511253549591,  0.773010453362737,  0.8032075314806449,
+  0.8314696123025452,  0.8577286100002721,  0.881921264348355,  0.9039892931234433,
+  0.9238795325112867,  0.9415440651830208,  0.9569403357322088,  0.970031253194544,
+  0.9807852804032304,  0.989176509964781,  0.9951847266721969,  0.9987954562051724
+};
+
+static const double ppp_sin128[128] = {
+  0.0,  0.049067674327418015,  0.0980171403295606,  0.14673047445536175,
+  0.19509032201612828,  0.2429801799032639,  0.2902846772544624,  0.33688985339222005,
+  0.3826834323650898,  0.4275550934302821,  0.47139673682599764,  0.5141027441932218,
+  0.5555702330196022,  0.5956993044924334,  0.6343932841636455,  0.6715589548470184,
+  0.7071067811865476,  0.7409511253549591,  0.773010453362737,  0.8032075314806449,
+  0.8314696123025452,  0.8577286100002721,  0.881921264348355,  0.9039892931234433,
+  0.9238795325112867,  0.9415440651830208,  0.9569403357322088,  0.970031253194544,
+  0.9807852804032304,  0.989176509964781,  0.9951847266721969,  0.9987954562051724,
+  1.0,  0.9987954562051724,  0.9951847266721969,  0.989176509964781,
+  0.9807852804032304,  0.970031253194544,  0.9569403357322088,  0.9415440651830208,
+  0.9238795325112867,  0.9039892931234433,  0.881921264348355,  0.8577286100002721,
+  0.8314696123025452,  0.8032075314806449,  0.773010453362737,  0.7409511253549591,
+  0.7071067811865476,  0.6715589548470184,  0.6343932841636455,  0.5956993044924334,
+  0.5555702330196022,  0.5141027441932218,  0.47139673682599764,  0.4275550934302821,
+  0.3826834323650898,  0.33688985339222005,  0.2902846772544624,  0.2429801799032639,
+  0.19509032201612828,  0.14673047445536175,  0.0980171403295606,  0.049067674327418015,
+  0.0, -0.049067674327418015, -0.0980171403295606, -0.14673047445536175,
+ -0.19509032201612828, -0.2429801799032639, -0.2902846772544624, -0.33688985339222005,
+ -0.3826834323650898, -0.4275550934302821, -0.47139673682599764, -0.5141027441932218,
+ -0.5555702330196022, -0.5956993044924334, -0.6343932841636455, -0.6715589548470184,
+ -0.7071067811865476, -0.7409511253549591, -0.773010453362737, -0.8032075314806449,
+ -0.8314696123025452, -0.8577286100002721, -0.881921264348355, -0.9039892931234433,
+ -0.9238795325112867, -0.9415440651830208, -0.9569403357322088, -0.970031253194544,
+ -0.9807852804032304, -0.989176509964781, -0.9951847266721969, -0.9987954562051724,
+ -1.0, -0.9987954562051724, -0.9951847266721969, -0.989176509964781,
+ -0.9807852804032304, -0.970031253194544, -0.9569403357322088, -0.9415440651830208,
+ -0.9238795325112867, -0.9039892931234433, -0.881921264348355, -0.8577286100002721,
+ -0.8314696123025452, -0.8032075314806449, -0.773010453362737, -0.7409511253549591,
+ -0.7071067811865476, -0.6715589548470184, -0.6343932841636455, -0.5956993044924334,
+ -0.5555702330196022, -0.5141027441932218, -0.47139673682599764, -0.4275550934302821,
+ -0.3826834323650898, -0.33688985339222005, -0.2902846772544624, -0.2429801799032639,
+ -0.19509032201612828, -0.14673047445536175, -0.0980171403295606, -0.049067674327418015
+};
+
+static const ppp_ring ppp_builtin[] = {
+ { 8, ppp_cos8, ppp_sin8 },
+ { 16, ppp_cos16, ppp_sin16 },
+ { 32, ppp_cos32, ppp_sin32 },
+ { 64, ppp_cos64, ppp_sin64 },
+ { 128, ppp_cos128, ppp_sin128 }
+};
+
+static ppp_ring ppp_cache[PPP_RING_CACHE];
+static int ppp_cache_count = 0;
+static int ppp_cache_next = 0;
+
+/*
+** Function ppp_ring_build -- Fill a table by the angle recurrence
+**
+** Inputs:
+**  sides  number of entries
+**  cosv   storage for sides cosines
+**  sinv   storage for sides sines
+*/
+static void ppp_ring_build(int sides, double *cosv, double *sinv)
+{
+ double cd, sd, c, s, t;
+ int i;
+
+ cd = cos(2.0 * PI / sides);
+ sd = sin(2.0 * PI / sides);
+ c = 1.0;
+ s = 0.0;
+ for (i = 0; i < sides; i++) {
+  cosv[i] = c;
+  sinv[i] = s;
+  t = c * cd - s * sd;
+  s = s * cd + c * sd;
+  c = t;
+ }
+}
+
+/*
+** Function ppp_ring_table -- Unit circle table for a side count
+**
+** Inputs:
+**  sides  number of ring vertices, 3 or more
+**
+** Return value: const ppp_ring *
+**  the table, or NULL when sides < 3 or memory runs out.  Built in and
+**  cached tables stay valid until ppp_ring_free; once the cache is
+**  full, a table may be replaced by a later call for another count.
+*/
+const ppp_ring *ppp_ring_table(int sides)
+{
+ ppp_ring *r;
+ double *buf;
+ int i;
+
+ if (sides < 3) return NULL;
+
+ for (i = 0; i < (int)(sizeof(ppp_builtin) / sizeof(ppp_builtin[0])); i++)
+  if (ppp_builtin[i].sides == sides) return &ppp_builtin[i];
+
+ for (i = 0; i < ppp_cache_count; i++)
+  if (ppp_cache[i].sides == sides) return &ppp_cache[i];
+
+ buf = (double *)malloc(2 * sides * sizeof(double));
+ if (!buf) return NULL;
+ ppp_ring_build(sides, buf, buf + sides);
+
+ if (ppp_cache_count < PPP_RING_CACHE) r = &ppp_cache[ppp_cache_count++];
+ else {
+  r = &ppp_cache[ppp_cache_next];
+  ppp_cache_next = (ppp_cache_next + 1) % PPP_RING_CACHE;
+  free((void *)r->cosv);
+ }
+ r->sides = sides;
+ r->cosv = buf;
+ r->sinv = buf + sides;
+ return r;
+}
+
+/*
+** Function ppp_ring_emit -- Ring vertices of a circle in 3D space
+**
+** Inputs:
+**  ring    unit circle table from ppp_ring_table
+**  center  pointer to circle center
+**  radius  circle radius
+**  u, v    pointers to the orthonormal in-plane axes, as returned by
+**    ppp_circle3d
+**  xyz     storage for ring->sides positions
+**
+** Vertex i is center + radius (cos u + sin v) of angle 2 pi i / sides.
+*/
+void ppp_ring_emit(const ppp_ring *ring, v3_pos *center, double radius,
+      v3_vect *u, v3_vect *v, double (*xyz)[3])
+{
+ double m[3][4], ux, uy, uz, vx, vy, vz;
+ int i;
+
+ /* the table is the unit circle in the x, y plane, already SoA */
+ if ((ring->sides >= PPP_RING_BATCH) && (ppp_batch_isa() == PPP_ISA_AVX2)) {
+  m[0][0] = radius * u->x; m[0][1] = radius * v->x; m[0][2] = 0.0; m[0][3] = center->x;
+  m[1][0] = radius * u->y; m[1][1] = radius * v->y; m[1][2] = 0.0; m[1][3] = center->y;
+  m[2][0] = radius * u->z; m[2][1] = radius * v->z; m[2][2] = 0.0; m[2][3] = center->z;
+  ppp_affine_batch(ring->sides, (const double (*)[4])m, ring->cosv, ring->sinv, NULL, xyz);
+  return;
+ }
+
+ /* the same sums in the same order, so the same bits */
+ ux = radius * u->x; uy = radius * u->y; uz = radius * u->z;
+ vx = radius * v->x; vy = radius * v->y; vz = radius * v->z;
+
+ for (i = 0; i < ring->sides; i++) {
+  xyz[i][0] = center->x + ring->cosv[i] * ux + ring->sinv[i] * vx;
+  xyz[i][1] = center->y + ring->cosv[i] * uy + ring->sinv[i] * vy;
+  xyz[i][2] = center->z + ring->cosv[i] * uz + ring->sinv[i] * vz;
+ }
+}
+
+/*
+** Function ppp_arc_angle -- Angle of p around center in the u, v frame
+*/
+static double ppp_arc_angle(v3_pos *center, v3_vect *u, v3_vect *v, v3_pos *p)
+{
+ double dx, dy, dz;
+
+ dx = p->x - center->x;
+ dy = p->y - center->y;
+ dz = p->z - center->z;
+ return atan2(dx * v->x + dy * v->y + dz * v->z, dx * u->x + dy * u->y + dz * u->z);
+}
+
+/*
+** Function ppp_arc_angles -- Start angle and sweep of the arc from p1
+**    to p3 that passes through p2
+**
+** Inputs:
+**  center, u, v  circle frame, as returned by ppp_circle3d
+**  p1, p2, p3    points on the circle
+**  start         storage for the angle of p1
+**  sweep         storage for the signed angle from p1 to p3, positive
+**    from u toward v, in (-2 pi, 2 pi)
+*/
+void ppp_arc_angles(v3_pos *center, v3_vect *u, v3_vect *v,
+      v3_pos *p1, v3_pos *p2, v3_pos *p3, double *start, double *sweep)
+{
+ double a1, a2, a3;
+
+ a1 = ppp_arc_angle(center, u, v, p1);
+ a2 = ppp_arc_angle(center, u, v, p2) - a1;
+ a3 = ppp_arc_angle(center, u, v, p3) - a1;
+ if (a2 < 0.0) a2 += 2.0 * PI;
+ if (a3 < 0.0) a3 += 2.0 * PI;
+
+ /* counterclockwise from p1, p2 comes first unless the arc runs the
+    other way */
+ *start = a1;
+ *sweep = (a2 <= a3) ? a3 : a3 - 2.0 * PI;
+}
+
+/*
+** Function ppp_arc_segments -- Segments of an arc, as many per turn as
+**    a ring of sides has
+*/
+int ppp_arc_segments(double sweep, int sides)
+{
+ int n;
+
+ n = (int)ceil(fabs(sweep) * sides / (2.0 * PI) - 1e-9);
+ return (n < 1) ? 1 : n;
+}
+
+/*
+** Function ppp_arc_emit -- Vertices of an open arc in 3D space
+**
+** Inputs:
+**  center, radius, u, v  circle, as for ppp_ring_emit
+**  start, sweep          from ppp_arc_angles
+**  segments              number of segments
+**  xyz                   storage for segments + 1 positions
+*/
+void ppp_arc_emit(v3_pos *center, double radius, v3_vect *u, v3_vect *v,
+      double start, double sweep, int segments, double (*xyz)[3])
+{
+ double cd, sd, c, s, t;
+ int i;
+
+ cd = cos(sweep / segments);
+ sd = sin(sweep / segments);
+ c = cos(start);
+ s = sin(start);
+ for (i = 0; i <= segments; i++) {
+  xyz[i][0] = center->x + radius * (c * u->x + s * v->x);
+  xyz[i][1] = center->y + radius * (c * u->y + s * v->y);
+  xyz[i][2] = center->z + radius * (c * u->z + s * v->z);
+  t = c * cd - s * sd;
+  s = s * cd + c * sd;
+  c = t;
+ }
+}
+
+/*
+** Function ppp_ring_sides -- Fewest sides keeping a ring within a chord
+**    tolerance of its circle
+**
+** Inputs:
+**  radius     circle radius
+**  tolerance  largest distance allowed between an edge and the circle
+**  min_sides  lower bound on the result, 3 or more
+**  max_sides  upper bound on the result
+**
+** Return value: int
+**  the side count, clamped to [min_sides, max_sides]
+**
+** The middle of an edge of an n sided ring is r (1 - cos(pi / n)) from
+** the circle, so n = ceil(pi / acos(1 - tolerance / r)).
+*/
+int ppp_ring_sides(double radius, double tolerance, int min_sides, int max_sides)
+{
+ double n;
+
+ if (!(tolerance > 0.0) || !(radius > tolerance)) return min_sides;
+ n = ceil(PI / acos(1.0 - tolerance / radius));
+ if (n < min_sides) return min_sides;
+ if (!(n <= max_sides)) return max_sides;
+ return (int)n;
+}
+
+/*
+** Function ppp_ring_free -- Release all cached tables
+*/
+void ppp_ring_free(void)
+{
+ int i;
+
+ for (i = 0; i < ppp_cache_count; i++) free((void *)ppp_cache[i].cosv);
+ ppp_cache_count = 0;
+ ppp_cache_next = 0;
+}
@@ -0,0 +1,54 @@
+/*
+** pppring.h
+*/
+
+#ifndef PPPRING_H
+#define PPPRING_H
+
+#include "pppcir.h"
+
+/*
+** Number of side counts kept by the ring table cache besides the
+** built in 8, 16, 32, 64 and 128 side tables.
+*/
+#ifndef PPP_RING_CACHE
+#define PPP_RING_CACHE 64
+#endif
+
+/*
+** Smallest ring ppp_ring_emit hands to the AVX2 ppp_affine_batch
+** kernel.  Below it, and on the other kernels at any size, its own
+** loop over the table is faster.
+*/
+#ifndef PPP_RING_BATCH
+#define PPP_RING_BATCH 32
+#endif
+
+typedef struct PPP_RING
+{
+ int sides;
+ const double *cosv;
+ const double *sinv;
+} ppp_ring;
+
+const ppp_ring *ppp_ring_table(int sides);
+
+void ppp_ring_emit(const ppp_ring *ring, v3_pos *center, double radius,
+      v3_vect *u, v3_vect *v, double (*xyz)[3]);
+
+/*
+** Open arcs on the circle of ppp_circle3d, from p1 to p3 through p2.
+*/
+void ppp_arc_angles(v3_pos *center, v3_vect *u, v3_vect *v,
+      v3_pos *p1, v3_pos *p2, v3_pos *p3, double *start, double *sweep);
+
+int ppp_arc_segments(double sweep, int sides);
+
+void ppp_arc_emit(v3_pos *center, double radius, v3_vect *u, v3_vect *v,
+      double start, double sweep, int segments, double (*xyz)[3]);
+
+int ppp_ring_sides(double radius, double tolerance, int min_sides, int max_sides);
+
+void ppp_ring_free(void);
+
+#endif
@@ -0,0 +1,330 @@
+/*
+** pppthread.c
+**
+** Contents: Portable thread start/join and a work-stealing parallel
+**    for loop.
+**
+** ppp_parallel_for gives every worker a contiguous run of chunk
+** indices, packed as (begin, end) into one 64 bit word.  The owner
+** takes chunks from the front of its run with a compare and swap on
+** begin; a worker whose run is empty steals the back half of another
+** run with a compare and swap on end, installs it as its own run and
+** carries on.  A worker leaves when one sweep over all the other runs
+** finds nothing to steal.  Chunks are claimed exactly once, so a body
+** that writes only the outputs of its own chunk needs no locks and
+** gives the same result for any number of threads.
+**
+** The runs need a 64 bit compare and swap: the GCC __atomic builtins,
+** or _InterlockedCompareExchange64, which MSVC has on x86 from Visual
+** C++ 2005 on.  Without either, PPP_ATOMIC64 is left undefined and
+** ppp_parallel_for does every chunk on the calling thread.
+*/
+
+#include <stdlib.h>
+#include "pppthread.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1400)
+#include <intrin.h>
+#define PPP_ATOMIC64 1
+#elif defined(__GNUC__) || defined(__clang__)
+#define PPP_ATOMIC64 1
+#endif
+
+typedef unsigned long long ppp_u64;
+
+struct PPP_THREAD
+{
+#ifdef _WIN32
+ HANDLE handle;
+#else
+ pthread_t handle;
+#endif
+ void (*fn)(void *);
+ void *arg;
+};
+
+/* one run of chunks per worker, on its own cache line */
+typedef struct PPP_RUN
+{
+ volatile ppp_u64 span;
+ char pad[64 - sizeof(ppp_u64)];
+} ppp_run;
+
+typedef struct PPP_FOR
+{
+ ppp_run *runs;
+ int workers;
+ ppp_for_body *body;
+ void *ctx;
+} ppp_for;
+
+typedef struct PPP_WORKER
+{
+ ppp_for *loop;
+ int id;
+} ppp_worker;
+
+#define PPP_SPAN(begin, end) (((ppp_u64)(end) << 32) | (ppp_u64)(begin))
+#define PPP_BEGIN(span) ((unsigned int)((span) & 0xffffffffu))
+#define PPP_END(span) ((unsigned int)((span) >> 32))
+
+/*
+** Function span_load, span_cas, span_store -- Atomic access to a run;
+**    without PPP_ATOMIC64 they are only reached from one thread
+*/
+static ppp_u64 span_load(volatile ppp_u64 *p)
+{
+#if defined(PPP_ATOMIC64) && defined(_MSC_VER)
+ return (ppp_u64)_InterlockedCompareExchange64((volatile __int64 *)p, 0, 0);
+#elif defined(PPP_ATOMIC64)
+ return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#else
+ return *p;
+#endif
+}
+
+static int span_cas(volatile ppp_u64 *p, ppp_u64 expected, ppp_u64 desired)
+{
+#if defined(PPP_ATOMIC64) && defined(_MSC_VER)
+ return (ppp_u64)_InterlockedCompareExchange64((volatile __int64 *)p,
+   (__int64)desired, (__int64)expected) == expected;
+#elif defined(PPP_ATOMIC64)
+ return __atomic_compare_exchange_n(p, &expected, desired, 0,
+   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#else
+ if (*p != expected) return 0;
+ *p = desired;
+ return 1;
+#endif
+}
+
+static void span_store(volatile ppp_u64 *p, ppp_u64 value)
+{
+#if defined(PPP_ATOMIC64) && defined(_MSC_VER)
+ ppp_u64 old;
+
+ /* x86 has no 64 bit exchange intrinsic, so swap until it takes */
+ do old = span_load(p);
+ while (!span_cas(p, old, value));
+#elif defined(PPP_ATOMIC64)
+ __atomic_store_n(p, value, __ATOMIC_RELEASE);
+#else
+ *p = value;
+#endif
+}
+
+#ifdef _WIN32
+static DWORD WINAPI thread_main(LPVOID arg)
+{
+ struct PPP_THREAD *t = (struct PPP_THREAD *)arg;
+
+ t->fn(t->arg);
+ return 0;
+}
+#else
+static void *thread_main(void *arg)
+{
+ struct PPP_THREAD *t = (struct PPP_THREAD *)arg;
+
+ t->fn(t->arg);
+ return NULL;
+}
+#endif
+
+/*
+** Function ppp_thread_start -- Run fn(arg) on a new thread
+**
+** Return value: int
+**  true  thread started, *thread valid until ppp_thread_join
+**  false thread could not be created
+*/
+int ppp_thread_start(ppp_thread *thread, void (*fn)(void *), void *arg)
+{
+ struct PPP_THREAD *t;
+
+ t = (struct PPP_THREAD *)malloc(sizeof(*t));
+ if (!t) return 0;
+ t->fn = fn;
+ t->arg = arg;
+#ifdef _WIN32
+ t->handle = CreateThread(NULL, 0, thread_main, t, 0, NULL);
+ if (!t->handle) {
+  free(t);
+  return 0;
+ }
+#else
+ if (pthread_create(&t->handle, NULL, thread_main, t) != 0) {
+  free(t);
+  return 0;
+ }
+#endif
+ *thread = t;
+ return 1;
+}
+
+/*
+** Function ppp_thread_join -- Wait for a thread and release it
+*/
+void ppp_thread_join(ppp_thread thread)
+{
+#ifdef _WIN32
+ WaitForSingleObject(thread->handle, INFINITE);
+ CloseHandle(thread->handle);
+#else
+ pthread_join(thread->handle, NULL);
+#endif
+ free(thread);
+}
+
+/*
+** Function ppp_cpu_count -- Number of processors online
+*/
+int ppp_cpu_count(void)
+{
+#ifdef _WIN32
+ SYSTEM_INFO info;
+
+ GetSystemInfo(&info);
+ return (int)info.dwNumberOfProcessors;
+#else
+ long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+ return (n > 0) ? (int)n : 1;
+#endif
+}
+
+/*
+** Function run_pop -- Take the first chunk of a run
+*/
+static int run_pop(ppp_run *run, int *chunk)
+{
+ ppp_u64 span;
+ unsigned int begin, end;
+
+ for (;;) {
+  span = span_load(&run->span);
+  begin = PPP_BEGIN(span);
+  end = PPP_END(span);
+  if (begin >= end) return 0;
+  if (span_cas(&run->span, span, PPP_SPAN(begin + 1, end))) {
+   *chunk = (int)begin;
+   return 1;
+  }
+ }
+}
+
+/*
+** Function run_steal -- Take the back half of a run, at least one chunk
+*/
+static int run_steal(ppp_run *run, unsigned int *first, unsigned int *last)
+{
+ ppp_u64 span;
+ unsigned int begin, end, mid;
+
+ for (;;) {
+  span = span_load(&run->span);
+  begin = PPP_BEGIN(span);
+  end = PPP_END(span);
+  if (begin >= end) return 0;
+  mid = begin + (end - begin) / 2;
+  if (span_cas(&run->span, span, PPP_SPAN(begin, mid))) {
+   *first = mid;
+   *last = end;
+   return 1;
+  }
+ }
+}
+
+/*
+** Function worker_main -- Work through the own run, then steal
+*/
+static void worker_main(void *arg)
+{
+ ppp_worker *w = (ppp_worker *)arg;
+ ppp_for *loop = w->loop;
+ ppp_run *own = &loop->runs[w->id];
+ unsigned int first = 0, last = 0;
+ int chunk, k, victim;
+
+ for (;;) {
+  while (run_pop(own, &chunk)) loop->body(loop->ctx, w->id, chunk);
+
+  for (k = 1; k < loop->workers; k++) {
+   victim = (w->id + k) % loop->workers;
+   if (run_steal(&loop->runs[victim], &first, &last)) break;
+  }
+  if (k == loop->workers) return;
+
+  /* nobody else writes an empty run, so a plain store installs it */
+  span_store(&own->span, PPP_SPAN(first, last));
+ }
+}
+
+/*
+** Function ppp_parallel_for -- Call body for every chunk in [0, chunks)
+**
+** Inputs:
+**  chunks   number of chunks
+**  threads  number of workers, including the caller; 0 or less for
+**    one per processor
+**  body     called as body(ctx, worker, chunk), worker in [0, threads)
+**  ctx      passed through to body
+**
+** Return value: int
+**  number of workers that ran; if threads could not be started, or
+**  there is no PPP_ATOMIC64, the caller does their chunks
+*/
+int ppp_parallel_for(int chunks, int threads, ppp_for_body *body, void *ctx)
+{
+ ppp_for loop;
+ ppp_worker *workers;
+ ppp_thread *handles;
+ void *block;
+ int i, started = 0;
+
+ if (chunks <= 0) return 0;
+ if (threads <= 0) threads = ppp_cpu_count();
+ if (threads > chunks) threads = chunks;
+#ifndef PPP_ATOMIC64
+ threads = 1;
+#endif
+
+ block = (threads > 1) ? malloc(threads * (sizeof(ppp_run) + sizeof(ppp_worker)
+   + sizeof(ppp_thread)) + sizeof(ppp_run)) : NULL;
+ if (!block) {
+  for (i = 0; i < chunks; i++) body(ctx, 0, i);
+  return 1;
+ }
+
+ /* runs first, cache line aligned within the block */
+ loop.runs = (ppp_run *)(((size_t)block + sizeof(ppp_run) - 1) & ~(size_t)(sizeof(ppp_run) - 1));
+ workers = (ppp_worker *)(loop.runs + threads);
+ handles = (ppp_thread *)(workers + threads);
+ loop.workers = threads;
+ loop.body = body;
+ loop.ctx = ctx;
+
+ for (i = 0; i < threads; i++) {
+  loop.runs[i].span = PPP_SPAN((ppp_u64)chunks * i / threads,
+    (ppp_u64)chunks * (i + 1) / threads);
+  workers[i].loop = &loop;
+  workers[i].id = i;
+ }
+
+ for (i = 1; i < threads; i++) {
+  if (!ppp_thread_start(&handles[i], worker_main, &workers[i])) break;
+  started++;
+ }
+ worker_main(&workers[0]);
+
+ for (i = 1; i <= started; i++) ppp_thread_join(handles[i]);
+ free(block);
+ return started + 1;
+}
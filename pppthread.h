@@ -0,0 +1,29 @@
+/*
+** pppthread.h
+*/
+
+#ifndef PPPTHREAD_H
+#define PPPTHREAD_H
+
+/*
+** Portable threads: Win32 threads on Windows, pthreads elsewhere.
+*/
+typedef struct PPP_THREAD *ppp_thread;
+
+int ppp_thread_start(ppp_thread *thread, void (*fn)(void *), void *arg);
+void ppp_thread_join(ppp_thread thread);
+int ppp_cpu_count(void);
+
+/*
+** Work-stealing parallel for.  body(ctx, worker, chunk) is called once
+** for every chunk in [0, chunks), on up to threads workers (the caller
+** is worker 0).  Each worker starts on its own contiguous run of chunks
+** and, when that is used up, steals half of what another worker has
+** left.  Workers share no locks; a chunk is claimed with one compare
+** and swap.
+*/
+typedef void ppp_for_body(void *ctx, int worker, int chunk);
+
+int ppp_parallel_for(int chunks, int threads, ppp_for_body *body, void *ctx);
+
+#endif
@@ -0,0 +1,237 @@
+/*
+** ppptmpl.h
+**
+** Template body of the precision generic 3 point circle, included by
+** pppgen.h once per scalar type.  Do not include it directly.
+**
+** Before each inclusion define
+**
+**  PPP_T     the scalar type
+**  PPP_V     a point type with members x and y of type PPP_T
+**  PPP_S     the suffix of the generated names, e.g. _f
+**  PPP_SQRT  square root for PPP_T
+**  PPP_FABS  absolute value for PPP_T
+**  PPP_MAX   largest finite PPP_T
+**
+** All of them are undefined again at the end of this file.
+*/
+
+#define PPP_FN(name) PPP_CAT(name, PPP_S)
+
+/*
+** Function ppp_v2_dist -- Find the distance between 2 points in 2D space
+*/
+PPP_INLINE PPP_T PPP_FN(ppp_v2_dist)(const PPP_V *a, const PPP_V *b)
+{
+ PPP_T dx, dy;
+
+ dx = (a->x - b->x);
+ dy = (a->y - b->y);
+ return (PPP_SQRT((dx * dx) + (dy * dy)));
+}
+
+/*
+** Function ppp_line_intersect -- Find the intersection of 2 lines in 2D
+**    space
+**
+** Inputs:
+**  p1  pointer to point on first line
+**  p2  pointer to point on second line
+**  d1  pointer to slope vector of first line
+**  d2  pointer to slope vector of second line
+**  ip  pointer to storage for intersection position values
+**
+** Return value: short
+**  true *ip contents valid -- intersection found
+**  false *ip contents undefined -- intersection NOT found
+**    should only happen when passed two parallel lines
+**
+** With both lines sloped, x comes from the slopes y = m x + b, and y
+** from them too when one line is horizontal, otherwise from the
+** inverse slopes x = y / m + b.  A vertical line gives x directly and
+** the other line y.  Each outcome is counted with PPP_COUNT.
+*/
+PPP_INLINE short PPP_FN(ppp_line_intersect)(const PPP_V *p1, const PPP_V *p2,
+       const PPP_V *d1, const PPP_V *d2, PPP_V *ip)
+{
+ PPP_T m1 = 0, m2 = 0;
+ int stat = true;
+
+ if(d1->x != 0) m1 = d1->y / d1->x;
+ if(d2->x != 0) m2 = d2->y / d2->x;
+
+ if((d1->x != 0) && (d2->x != 0)) {
+  PPP_T temp_x, m, b1, b2;
+
+  m = m1 - m2;
+  if (PPP_FABS(m) != 0){
+   b1 = p1->y - m1 * p1->x;
+   b2 = p2->y - m2 * p2->x;
+   temp_x = (b2 - b1) / m;
+   if((m1 == 0) || (m2 == 0)) {
+    PPP_COUNT(PPP_COUNT_HORIZONTAL);
+    ip->x = temp_x;
+    ip->y = ((b2 * m1) - (b1 * m2)) / m;
+   } else {
+    m1 = 1 / m1;
+    m2 = 1 / m2;
+    m = (m1 - m2);
+    if (m != 0) {
+     PPP_COUNT(PPP_COUNT_SLOPED);
+     ip->x = temp_x;
+     b1 = p1->x -  m1 * p1->y;
+     b2 = p2->x -  m2 * p2->y;
+     ip->y = (b2 - b1) / m;
+    } else {
+     PPP_COUNT(PPP_COUNT_INVERSE_FAIL);
+     stat = false; /* Error: should never happen? */
+    }
+   }
+  } else {
+   PPP_COUNT(PPP_COUNT_PARALLEL);
+   stat = false; /* Error: parallel non-vertical lines */
+  }
+ } else if(d1->x != 0) {
+  PPP_COUNT(PPP_COUNT_VERTICAL_2);
+  ip->x = p2->x;
+  m2 = p1->y - (p1->x * m1);
+  ip->y =  (m1 * p2->x) + m2;
+ } else if(d2->x != 0) {
+  PPP_COUNT(PPP_COUNT_VERTICAL_1);
+  ip->x = p1->x;
+  m1 = p2->y - (p2->x * m2);
+  ip->y =  (m2 * p1->x) + m1;
+ } else {
+  PPP_COUNT(PPP_COUNT_VERTICAL_BOTH);
+  stat = false; /* Error: parallel vertical lines */
+ }
+ return stat;
+}
+
+/*
+** Function ppp_classify -- Degeneracy test of ppp_classify in pppcir.c
+**    in rounded arithmetic: the collinear decision is d == 0 on the
+**    rounded determinant rather than the exact sign
+*/
+PPP_INLINE int PPP_FN(ppp_classify)(const PPP_V *p1, const PPP_V *p2,
+      const PPP_V *p3, PPP_T min_sine)
+{
+ PPP_T bx, by, cx, cy, ex, ey, b2, c2, e2, emin, d;
+
+ PPP_COUNT(PPP_COUNT_CLASSIFY);
+ bx = p2->x - p1->x; by = p2->y - p1->y;
+ cx = p3->x - p1->x; cy = p3->y - p1->y;
+ d = bx * cy - by * cx;
+ if (d == 0) {
+  PPP_COUNT(PPP_COUNT_COLLINEAR);
+  return PPP_TRIPLE_COLLINEAR;
+ }
+ if (min_sine <= 0) return PPP_TRIPLE_OK;
+
+ ex = p3->x - p2->x; ey = p3->y - p2->y;
+ b2 = bx * bx + by * by;
+ c2 = cx * cx + cy * cy;
+ e2 = ex * ex + ey * ey;
+ emin = (b2 < c2) ? b2 : c2;
+ if (e2 < emin) emin = e2;
+
+ if (!(d * d * emin >= min_sine * min_sine * b2 * c2 * e2)) {
+  PPP_COUNT(PPP_COUNT_SLIVER);
+  return PPP_TRIPLE_SLIVER;
+ }
+ return PPP_TRIPLE_OK;
+}
+
+/*
+** Function ppp_circle_slope -- The original ppp_circle construction,
+**    intersecting the perpendicular bisectors, with no degeneracy test
+**    of its own
+*/
+PPP_INLINE int PPP_FN(ppp_circle_slope)(const PPP_V *p1, const PPP_V *p2,
+      const PPP_V *p3, PPP_V *center, PPP_T *radius)
+{
+ PPP_V d1, d2, mp1, mp2;
+ int have_center = true;
+
+ PPP_COUNT(PPP_COUNT_SLOPE);
+
+ /* calculate perpendicular slope vectors */
+ d1.y = p2->x - p1->x;
+ d2.y = p3->x - p1->x;
+ d1.x = p1->y - p2->y;
+ d2.x = p1->y - p3->y;
+
+ /* calculate midpoint position values */
+ mp1.x = (p1->x + p2->x) * (PPP_T)0.5;
+ mp1.y = (p1->y + p2->y) * (PPP_T)0.5;
+ mp2.x = (p1->x + p3->x) * (PPP_T)0.5;
+ mp2.y = (p1->y + p3->y) * (PPP_T)0.5;
+
+ if ((mp1.x == mp2.x) && (mp1.y == mp2.y)) {
+  PPP_COUNT(PPP_COUNT_SAME_MIDPOINT);
+  *center = mp1;
+ } else have_center = PPP_FN(ppp_line_intersect)(&mp1, &mp2, &d1, &d2, center);
+
+ if (have_center) *radius = PPP_FN(ppp_v2_dist)(center, p1);
+ return (have_center);
+}
+
+/*
+** Function ppp_circle_det -- The determinant form of ppp_circle_closed,
+**    rejecting only d == 0 and overflow
+*/
+PPP_INLINE int PPP_FN(ppp_circle_det)(const PPP_V *p1, const PPP_V *p2,
+      const PPP_V *p3, PPP_V *center, PPP_T *radius)
+{
+ PPP_T bx, by, cx, cy, b2, c2, d, inv, ux, uy, r2;
+
+ bx = p2->x - p1->x;
+ by = p2->y - p1->y;
+ cx = p3->x - p1->x;
+ cy = p3->y - p1->y;
+ d = 2 * (bx * cy - by * cx);
+ if (d == 0) return false;
+
+ b2 = bx * bx + by * by;
+ c2 = cx * cx + cy * cy;
+ inv = 1 / d;
+ ux = (cy * b2 - by * c2) * inv;
+ uy = (bx * c2 - cx * b2) * inv;
+ r2 = ux * ux + uy * uy;
+ if (!(r2 <= PPP_MAX)) return false;
+
+ center->x = p1->x + ux;
+ center->y = p1->y + uy;
+ *radius = PPP_SQRT(r2);
+ return true;
+}
+
+/*
+** Function ppp_circle -- ppp_circle_slope behind the rounded
+**    ppp_classify with PPP_MIN_SINE
+*/
+PPP_INLINE int PPP_FN(ppp_circle)(const PPP_V *p1, const PPP_V *p2,
+      const PPP_V *p3, PPP_V *center, PPP_T *radius)
+{
+ if (PPP_FN(ppp_classify)(p1, p2, p3, (PPP_T)PPP_MIN_SINE) != PPP_TRIPLE_OK) return false;
+ return PPP_FN(ppp_circle_slope)(p1, p2, p3, center, radius);
+}
+
+/*
+** Function ppp_circle_closed -- ppp_circle_det behind the rounded
+**    ppp_classify with PPP_MIN_SINE
+*/
+PPP_INLINE int PPP_FN(ppp_circle_closed)(const PPP_V *p1, const PPP_V *p2,
+      const PPP_V *p3, PPP_V *center, PPP_T *radius)
+{
+ if (PPP_FN(ppp_classify)(p1, p2, p3, (PPP_T)PPP_MIN_SINE) != PPP_TRIPLE_OK) return false;
+ return PPP_FN(ppp_circle_det)(p1, p2, p3, center, radius);
+}
+
+#undef PPP_FN
+#undef PPP_T
+#undef PPP_V
+#undef PPP_S
+#undef PPP_SQRT
+#undef PPP_FABS
+#undef PPP_MAX
@@ -0,0 +1,460 @@
+/*
+** pppstream.c
+**
+** Contents: Command line circle solver for files of packed point
+**    triples, outside of Modeler.
+**
+** Usage: pppstream [-j threads] [-w triples] [-q] input output
+**        pppstream -g count [-S seed] output
+**
+** input holds one record of six native doubles per triple,
+** x1 y1 x2 y2 x3 y3.  output gets one ppp_stream_out record per triple:
+** the center, the radius and a flags word, PPP_STREAM_VALID for a
+** circle and 0 for a rejected triple, whose center and radius are 0.
+** "-" reads stdin or writes stdout.  -g writes count random triples
+** instead, to make test input.
+**
+** Regular files are memory mapped a window of -w triples at a time
+** (default PPP_STREAM_WINDOW) and solved in place: every chunk of
+** PPP_MT_CHUNK triples is read from the input mapping into the cache
+** sized scratch of one worker, solved by ppp_circle_batch and written
+** straight to the output mapping.  Pipes go through one window sized
+** buffer each way instead.  Either way the memory used depends on the
+** window and the thread count, not on the file size.
+**
+** Prints the triple count, the valid count and the throughput to stderr
+** unless -q is given.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../pppcir.h"
+#include "../pppthread.h"
+#include "../bench/bench.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define PPP_STREAM_VALID 1
+
+typedef struct PPP_STREAM_OUT
+{
+ double cx;
+ double cy;
+ double radius;
+ unsigned int flags;
+ unsigned int pad;
+} ppp_stream_out;
+
+/*
+** Triples per window.  A multiple of PPP_MT_CHUNK triples is a multiple
+** of 64 KB in both files, the mapping granularity of Windows.
+*/
+#ifndef PPP_STREAM_WINDOW
+#define PPP_STREAM_WINDOW (256 * PPP_MT_CHUNK)
+#endif
+
+#define IN_SIZE  (6 * sizeof(double))
+#define OUT_SIZE sizeof(ppp_stream_out)
+
+typedef unsigned long long ppp_u64;
+
+/* SoA copy of one chunk, per worker */
+typedef struct PPP_STREAM_SCRATCH
+{
+ double x1[PPP_MT_CHUNK], y1[PPP_MT_CHUNK];
+ double x2[PPP_MT_CHUNK], y2[PPP_MT_CHUNK];
+ double x3[PPP_MT_CHUNK], y3[PPP_MT_CHUNK];
+ double cx[PPP_MT_CHUNK], cy[PPP_MT_CHUNK], radius[PPP_MT_CHUNK];
+ unsigned char valid[PPP_MT_CHUNK];
+} ppp_stream_scratch;
+
+typedef struct PPP_STREAM
+{
+ const double *in;
+ ppp_stream_out *out;
+ int n;
+ ppp_stream_scratch *scratch;
+ int *count;
+} ppp_stream;
+
+typedef struct PPP_MAPPED
+{
+#ifdef _WIN32
+ HANDLE file;
+ HANDLE mapping;
+#else
+ int fd;
+#endif
+ ppp_u64 size;
+} ppp_mapped;
+
+/*
+** Function map_open -- Open a regular file for mapping; with size > 0
+**    create it with that size for writing
+**
+** Return value: int
+**  true  file open, mapped->size set
+**  false not a regular file or cannot be opened
+*/
+static int map_open(ppp_mapped *mapped, const char *name, ppp_u64 size)
+{
+#ifdef _WIN32
+ LARGE_INTEGER len;
+
+ mapped->file = CreateFileA(name, size ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+   FILE_SHARE_READ, NULL, size ? CREATE_ALWAYS : OPEN_EXISTING,
+   FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+ if (mapped->file == INVALID_HANDLE_VALUE) return false;
+ if (GetFileType(mapped->file) != FILE_TYPE_DISK) {
+  CloseHandle(mapped->file);
+  return false;
+ }
+ if (size) {
+  len.QuadPart = (LONGLONG)size;
+ } else if (!GetFileSizeEx(mapped->file, &len)) {
+  CloseHandle(mapped->file);
+  return false;
+ }
+ mapped->size = (ppp_u64)len.QuadPart;
+ mapped->mapping = NULL;
+ if (mapped->size) {
+  mapped->mapping = CreateFileMappingA(mapped->file, NULL,
+    size ? PAGE_READWRITE : PAGE_READONLY, len.HighPart, len.LowPart, NULL);
+  if (!mapped->mapping) {
+   CloseHandle(mapped->file);
+   return false;
+  }
+ }
+ return true;
+#else
+ struct stat st;
+
+ mapped->fd = size ? open(name, O_RDWR | O_CREAT | O_TRUNC, 0666) : open(name, O_RDONLY);
+ if (mapped->fd < 0) return false;
+ if ((fstat(mapped->fd, &st) != 0) || !S_ISREG(st.st_mode)
+   || (size && (ftruncate(mapped->fd, (off_t)size) != 0))) {
+  close(mapped->fd);
+  return false;
+ }
+ mapped->size = size ? size : (ppp_u64)st.st_size;
+ return true;
+#endif
+}
+
+/*
+** Function map_view, map_unview -- Map len bytes at offset, a multiple
+**    of 64 KB, and unmap them again
+*/
+static void *map_view(ppp_mapped *mapped, ppp_u64 offset, size_t len, int write)
+{
+#ifdef _WIN32
+ return MapViewOfFile(mapped->mapping, write ? FILE_MAP_WRITE : FILE_MAP_READ,
+   (DWORD)(offset >> 32), (DWORD)offset, len);
+#else
+ void *p = mmap(NULL, len, write ? PROT_READ | PROT_WRITE : PROT_READ,
+   MAP_SHARED, mapped->fd, (off_t)offset);
+
+ if (p == MAP_FAILED) return NULL;
+ if (!write) madvise(p, len, MADV_SEQUENTIAL);
+ return p;
+#endif
+}
+
+static void map_unview(void *p, size_t len)
+{
+#ifdef _WIN32
+ UnmapViewOfFile(p);
+#else
+ munmap(p, len);
+#endif
+}
+
+static void map_close(ppp_mapped *mapped)
+{
+#ifdef _WIN32
+ if (mapped->mapping) CloseHandle(mapped->mapping);
+ CloseHandle(mapped->file);
+#else
+ close(mapped->fd);
+#endif
+}
+
+/*
+** Function stream_chunk -- ppp_parallel_for body, solving one chunk of
+**    the current window
+*/
+static void stream_chunk(void *ctx, int worker, int chunk)
+{
+ ppp_stream *job = (ppp_stream *)ctx;
+ ppp_stream_scratch *s = &job->scratch[worker];
+ const double *in = job->in + (size_t)chunk * PPP_MT_CHUNK * 6;
+ ppp_stream_out *out = job->out + (size_t)chunk * PPP_MT_CHUNK;
+ int i, n = job->n - chunk * PPP_MT_CHUNK;
+
+ if (n > PPP_MT_CHUNK) n = PPP_MT_CHUNK;
+ for (i = 0; i < n; i++, in += 6) {
+  s->x1[i] = in[0]; s->y1[i] = in[1];
+  s->x2[i] = in[2]; s->y2[i] = in[3];
+  s->x3[i] = in[4]; s->y3[i] = in[5];
+ }
+ job->count[chunk] = ppp_circle_batch(n, s->x1, s->y1, s->x2, s->y2,
+   s->x3, s->y3, s->cx, s->cy, s->radius, s->valid);
+ for (i = 0; i < n; i++) {
+  out[i].cx = s->cx[i];
+  out[i].cy = s->cy[i];
+  out[i].radius = s->radius[i];
+  out[i].flags = s->valid[i] ? PPP_STREAM_VALID : 0;
+  out[i].pad = 0;
+ }
+}
+
+/*
+** Function stream_window -- Solve n triples from in into out
+**
+** Return value: int
+**  number of valid circles
+*/
+static int stream_window(ppp_stream *job, const double *in, ppp_stream_out *out,
+      int n, int threads)
+{
+ int chunks, i, count = 0;
+
+ chunks = (n + PPP_MT_CHUNK - 1) / PPP_MT_CHUNK;
+ job->in = in;
+ job->out = out;
+ job->n = n;
+ ppp_parallel_for(chunks, threads, stream_chunk, job);
+ for (i = 0; i < chunks; i++) count += job->count[i];
+ return count;
+}
+
+/*
+** Function stream_mapped -- Solve a mapped input file into a mapped
+**    output file, one window at a time
+**
+** Return value: int
+**  true  done, *triples and *valid set
+**  false a view could not be mapped
+*/
+static int stream_mapped(ppp_stream *job, ppp_mapped *in, ppp_mapped *out,
+      int window, int threads, ppp_u64 *triples, ppp_u64 *valid)
+{
+ ppp_u64 total = in->size / IN_SIZE, done;
+ const double *inp;
+ ppp_stream_out *outp;
+ int n;
+
+ for (done = 0; done < total; done += n) {
+  n = (total - done < (ppp_u64)window) ? (int)(total - done) : window;
+  inp = (const double *)map_view(in, done * IN_SIZE, n * IN_SIZE, false);
+  if (!inp) return false;
+  outp = (ppp_stream_out *)map_view(out, done * OUT_SIZE, n * OUT_SIZE, true);
+  if (!outp) {
+   map_unview((void *)inp, n * IN_SIZE);
+   return false;
+  }
+  *valid += stream_window(job, inp, outp, n, threads);
+  map_unview(outp, n * OUT_SIZE);
+  map_unview((void *)inp, n * IN_SIZE);
+  *triples = done + n;
+ }
+ return true;
+}
+
+/*
+** Function stream_stdio -- Solve a stream through one window sized
+**    buffer each way
+**
+** Return value: int
+**  true  done, *triples and *valid set
+**  false out of memory or a write failed
+*/
+static int stream_stdio(ppp_stream *job, FILE *in, FILE *out,
+      int window, int threads, ppp_u64 *triples, ppp_u64 *valid)
+{
+ double *inp;
+ ppp_stream_out *outp;
+ size_t got, tail;
+ int ok = true;
+
+ inp = (double *)malloc(window * IN_SIZE);
+ outp = (ppp_stream_out *)malloc(window * OUT_SIZE);
+ if (!inp || !outp) {
+  free(inp);
+  free(outp);
+  return false;
+ }
+
+ for (;;) {
+  got = fread(inp, 1, window * IN_SIZE, in);
+  tail = got % IN_SIZE;
+  got /= IN_SIZE;
+  if (got) {
+   *valid += stream_window(job, inp, outp, (int)got, threads);
+   *triples += got;
+   if (fwrite(outp, OUT_SIZE, got, out) != got) {
+    ok = false;
+    break;
+   }
+  }
+  if (got < (size_t)window) {
+   if (tail) fprintf(stderr, "pppstream: ignoring %d trailing bytes\n", (int)tail);
+   break;
+  }
+ }
+
+ free(inp);
+ free(outp);
+ return ok;
+}
+
+/*
+** Function generate -- Write count random triples
+*/
+static int generate(FILE *out, ppp_u64 count, unsigned long long seed)
+{
+ double rec[6 * 1024];
+ ppp_u64 done;
+ int i, n;
+
+ for (done = 0; done < count; done += n) {
+  n = (count - done < 1024) ? (int)(count - done) : 1024;
+  for (i = 0; i < 6 * n; i++) rec[i] = bench_rand(&seed, -1000.0, 1000.0);
+  if (fwrite(rec, IN_SIZE, n, out) != (size_t)n) return false;
+ }
+ return true;
+}
+
+static FILE *open_stdio(const char *name, int write)
+{
+ if (!strcmp(name, "-")) {
+#ifdef _WIN32
+  _setmode(_fileno(write ? stdout : stdin), _O_BINARY);
+#endif
+  return write ? stdout : stdin;
+ }
+ return fopen(name, write ? "wb" : "rb");
+}
+
+int main(int argc, char **argv)
+{
+ const char *inName = NULL, *outName = NULL;
+ int threads = 0, window = PPP_STREAM_WINDOW, quiet = false, ok, i;
+ ppp_u64 gen = 0, triples = 0, valid = 0;
+ unsigned long long seed = 1;
+ ppp_mapped inMap, outMap;
+ ppp_stream job;
+ FILE *in, *out;
+ double t;
+
+ for (i = 1; i < argc; i++) {
+  const char *a = argv[i];
+  const char *v = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+  if ((a[0] != '-') || !a[1]) {
+   if (!inName && !gen) inName = a;
+   else if (!outName) outName = a;
+   else {
+    fprintf(stderr, "pppstream: too many files\n");
+    return 2;
+   }
+   continue;
+  }
+  if (!strcmp(a, "-q")) { quiet = true; continue; }
+  if (!v) {
+   fprintf(stderr, "pppstream: missing value for %s\n", a);
+   return 2;
+  }
+  if (!strcmp(a, "-j")) threads = atoi(v);
+  else if (!strcmp(a, "-w")) window = atoi(v);
+  else if (!strcmp(a, "-g")) gen = strtoull(v, NULL, 10);
+  else if (!strcmp(a, "-S")) seed = strtoull(v, NULL, 10);
+  else {
+   fprintf(stderr, "pppstream: unknown option %s\n", a);
+   return 2;
+  }
+  i++;
+ }
+
+ if (!outName || (!gen && !inName)) {
+  fprintf(stderr, "usage: pppstream [-j threads] [-w triples] [-q] input output\n"
+    "       pppstream -g count [-S seed] output\n");
+  return 2;
+ }
+
+ if (gen) {
+  out = open_stdio(outName, true);
+  if (!out) {
+   fprintf(stderr, "pppstream: cannot create %s\n", outName);
+   return 1;
+  }
+  ok = generate(out, gen, seed);
+  if (out != stdout) ok = (fclose(out) == 0) && ok;
+  if (!ok) fprintf(stderr, "pppstream: cannot write %s\n", outName);
+  return ok ? 0 : 1;
+ }
+
+ /* whole chunks, so that every window starts on a 64 KB boundary */
+ window = (window + PPP_MT_CHUNK - 1) / PPP_MT_CHUNK * PPP_MT_CHUNK;
+ if (window < PPP_MT_CHUNK) window = PPP_MT_CHUNK;
+ if (threads <= 0) threads = ppp_cpu_count();
+
+ job.scratch = (ppp_stream_scratch *)malloc(threads * sizeof(ppp_stream_scratch));
+ job.count = (int *)malloc(window / PPP_MT_CHUNK * sizeof(int));
+ if (!job.scratch || !job.count) {
+  fprintf(stderr, "pppstream: out of memory\n");
+  return 1;
+ }
+
+ /* pick the kernel before the workers read it */
+ ppp_batch_isa();
+ t = bench_now();
+
+ if (strcmp(inName, "-") && strcmp(outName, "-") && map_open(&inMap, inName, 0)) {
+  if ((inMap.size % IN_SIZE) != 0)
+   fprintf(stderr, "pppstream: ignoring %d trailing bytes\n", (int)(inMap.size % IN_SIZE));
+  if (inMap.size < IN_SIZE) {
+   /* nothing to map, leave an empty output */
+   out = fopen(outName, "wb");
+   ok = out && (fclose(out) == 0);
+  } else if (map_open(&outMap, outName, inMap.size / IN_SIZE * OUT_SIZE)) {
+   ok = stream_mapped(&job, &inMap, &outMap, window, threads, &triples, &valid);
+   map_close(&outMap);
+  } else ok = false;
+  map_close(&inMap);
+ } else {
+  in = open_stdio(inName, false);
+  out = in ? open_stdio(outName, true) : NULL;
+  ok = (in && out) ? stream_stdio(&job, in, out, window, threads, &triples, &valid) : false;
+  if (in && (in != stdin)) fclose(in);
+  if (out && (out != stdout)) ok = (fclose(out) == 0) && ok;
+  else if (out) ok = (fflush(out) == 0) && ok;
+ }
+
+ t = bench_now() - t;
+ free(job.scratch);
+ free(job.count);
+
+ if (!ok) {
+  fprintf(stderr, "pppstream: cannot process %s into %s\n", inName, outName);
+  return 1;
+ }
+ if (!quiet) {
+  if (t <= 0) t = 1e-9;
+  fprintf(stderr, "%llu triples, %llu valid, %d threads, %s, %.3f s, "
+    "%.1f Mtriples/s, %.1f MB/s\n", triples, valid, threads,
+    ppp_batch_isa_name(ppp_batch_isa()), t, triples / t * 1e-6,
+    triples * (double)(IN_SIZE + OUT_SIZE) / t * 1e-6);
+ }
+ return 0;
+}